@@ -2,6 +2,8 @@
 #include <cassert>
 #include <ctime>
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 #if defined(_WIN32)
 #include <Windows.h>
@@ -16,89 +18,285 @@
 #endif
 
 #include "seval.hpp"
+#include "seval_expr.hpp"
+#include "seval_vm.hpp"
+#include "seval_jit.hpp"
+#include "seval_cache.hpp"
+#include "seval_schema.hpp"
+#include "seval_static.hpp"
 
 #define BENCHMARK_ITERATIONS 1000000
 
+/* hides a literal from the optimizer, which could otherwise run the constexpr kernels at compile time */
+SEVAL_INLINE const char* opaque(const char* text) {
+    const char* volatile hidden = text;
+    return hidden;
+}
+
 struct Benchmark8BitSigned {
     SEVAL_INLINE void operator()() const {
-        volatile int8_t result = seval::evaluate<int8_t, const char*>("127");
+        volatile int8_t result = seval::evaluate<int8_t, const char*>(opaque("127"));
         (void)result;
     }
 };
 
 struct Benchmark8BitUnsigned {
     SEVAL_INLINE void operator()() const {
-        volatile uint8_t result = seval::evaluate<uint8_t, const char*>("255");
+        volatile uint8_t result = seval::evaluate<uint8_t, const char*>(opaque("255"));
         (void)result;
     }
 };
 
 struct Benchmark16BitSigned {
     SEVAL_INLINE void operator()() const {
-        volatile int16_t result = seval::evaluate<int16_t, const char*>("32767");
+        volatile int16_t result = seval::evaluate<int16_t, const char*>(opaque("32767"));
         (void)result;
     }
 };
 
 struct Benchmark16BitUnsigned {
     SEVAL_INLINE void operator()() const {
-        volatile uint16_t result = seval::evaluate<uint16_t, const char*>("65535");
+        volatile uint16_t result = seval::evaluate<uint16_t, const char*>(opaque("65535"));
         (void)result;
     }
 };
 
 struct Benchmark32BitSigned {
     SEVAL_INLINE void operator()() const {
-        volatile int32_t result = seval::evaluate<int32_t, const char*>("2147483647");
+        volatile int32_t result = seval::evaluate<int32_t, const char*>(opaque("2147483647"));
         (void)result;
     }
 };
 
 struct Benchmark32BitUnsigned {
     SEVAL_INLINE void operator()() const {
-        volatile uint32_t result = seval::evaluate<uint32_t, const char*>("4294967295");
+        volatile uint32_t result = seval::evaluate<uint32_t, const char*>(opaque("4294967295"));
         (void)result;
     }
 };
 
 struct Benchmark64BitSigned {
     SEVAL_INLINE void operator()() const {
-        volatile int64_t result = seval::evaluate<int64_t, const char*>("9223372036854775807");
+        volatile int64_t result = seval::evaluate<int64_t, const char*>(opaque("9223372036854775807"));
         (void)result;
     }
 };
 
 struct Benchmark64BitUnsigned {
     SEVAL_INLINE void operator()() const {
-        volatile uint64_t result = seval::evaluate<uint64_t, const char*>("18446744073709551615");
+        volatile uint64_t result = seval::evaluate<uint64_t, const char*>(opaque("18446744073709551615"));
         (void)result;
     }
 };
 
 struct BenchmarkHexadecimal {
     SEVAL_INLINE void operator()() const {
-        volatile int result = seval::evaluate<int, const char*>("0x123");
+        volatile int result = seval::evaluate<int, const char*>(opaque("0x123"));
         (void)result;
     }
 };
 
 struct BenchmarkFloatingPoint {
     SEVAL_INLINE void operator()() const {
-        volatile float result = seval::evaluate<float, const char*>("3.14");
+        volatile float result = seval::evaluate<float, const char*>(opaque("3.14"));
         (void)result;
     }
 };
 
 struct BenchmarkFloatingPointExponent {
     SEVAL_INLINE void operator()() const {
-        volatile float result = seval::evaluate<float, const char*>("3.14e2");
+        volatile float result = seval::evaluate<float, const char*>(opaque("3.14e2"));
         (void)result;
     }
 };
 
 struct BenchmarkBinary {
     SEVAL_INLINE void operator()() const {
-        volatile int result = seval::evaluate<int, const char*>("0b101010");
+        volatile int result = seval::evaluate<int, const char*>(opaque("0b101010"));
+        (void)result;
+    }
+};
+
+struct BenchmarkExpression {
+    seval::expr::expression e;
+    seval::expr::bindings vars;
+
+    BenchmarkExpression() {
+        seval::expr::parse("(0x10 + 3.5e2) * -0b11 / x + y * y", e);
+        vars["x"] = 2.0;
+        vars["y"] = 0.5;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::value v;
+        seval::expr::evaluate(e, vars, v);
+        volatile double result = v.f;
+        (void)result;
+    }
+};
+
+struct BenchmarkExpressionVM {
+    seval::expr::program p;
+    seval::expr::bindings vars;
+
+    BenchmarkExpressionVM() {
+        seval::expr::compile("(0x10 + 3.5e2) * -0b11 / x + y * y", p);
+        vars["x"] = 2.0;
+        vars["y"] = 0.5;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::value v;
+        seval::expr::run(p, vars, v);
+        volatile double result = v.f;
+        (void)result;
+    }
+};
+
+struct BenchmarkExpressionColumns {
+    seval::expr::program p;
+    seval::expr::column_ref columns[2];
+    double x[256], y[256];
+    mutable double out[256];
+
+    BenchmarkExpressionColumns() {
+        seval::expr::compile("(0x10 + 3.5e2) * -0b11 / x + y * y", p);
+        for (int i = 0; i < 256; ++i) {
+            x[i] = 2.0 + i;
+            y[i] = 0.5 * i;
+        }
+        columns[0] = seval::expr::column_ref(x);
+        columns[1] = seval::expr::column_ref(y);
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::run_columns(p, columns, 256, out);
+        volatile double result = out[255];
+        (void)result;
+    }
+};
+
+struct BenchmarkExpressionJIT {
+    const seval::expr::jit_program& jit;
+    double vars[2];
+
+    explicit BenchmarkExpressionJIT(const seval::expr::jit_program& j) : jit(j) {
+        vars[0] = 2.0;
+        vars[1] = 0.5;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::value v;
+        if (jit.scalar()) jit.run(vars, v);
+        volatile double result = v.f;
+        (void)result;
+    }
+};
+
+#if defined(SEVAL_STATIC_FORMULA)
+struct BenchmarkExpressionStatic {
+    double vars[2];
+
+    BenchmarkExpressionStatic() {
+        vars[0] = 2.0;
+        vars[1] = 0.5;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        const double* volatile row = vars;
+        volatile double result = seval::expr::formula<"(0x10 + 3.5e2) * -0b11 / x + y * y">::run(row);
+        (void)result;
+    }
+};
+#endif
+
+struct BenchmarkExpressionJITColumns {
+    const seval::expr::jit_program& jit;
+    const double* columns[2];
+    double x[256], y[256];
+    mutable double out[256];
+
+    explicit BenchmarkExpressionJITColumns(const seval::expr::jit_program& j) : jit(j) {
+        for (int i = 0; i < 256; ++i) {
+            x[i] = 2.0 + i;
+            y[i] = 0.5 * i;
+        }
+        columns[0] = x;
+        columns[1] = y;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        if (jit.packed()) jit.run_columns(columns, 256, out);
+        volatile double result = out[255];
+        (void)result;
+    }
+};
+
+struct BenchmarkExpressionCached {
+    seval::expr::expression_cache& cache;
+    double vars[2];
+
+    explicit BenchmarkExpressionCached(seval::expr::expression_cache& c) : cache(c) {
+        vars[0] = 2.0;
+        vars[1] = 0.5;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::compiled_expression c;
+        seval::expr::value v;
+        cache.get("(0x10 + 3.5e2) * -0b11 / x + y * y", c);
+        c.run(vars, v);
+        volatile double result = v.f;
+        (void)result;
+    }
+};
+
+/* a formula over 50 variables f00 ... f49: f00 * f01 + f02 * f03 + ... */
+struct WideFormula {
+    std::vector<std::string> names;
+    std::string text;
+
+    WideFormula() {
+        for (int i = 0; i < 50; ++i) {
+            char name[4] = { 'f', static_cast<char>('0' + i / 10), static_cast<char>('0' + i % 10), '\0' };
+            names.push_back(name);
+            text += (i == 0 ? "" : (i % 2 ? " * " : " + ")) + names.back();
+        }
+    }
+};
+
+struct BenchmarkExpressionBindings {
+    seval::expr::program p;
+    seval::expr::bindings vars;
+
+    BenchmarkExpressionBindings() {
+        WideFormula f;
+        seval::expr::compile(f.text.c_str(), p);
+        for (size_t i = 0; i < f.names.size(); ++i) vars[f.names[i]] = 0.5 * i;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::value v;
+        seval::expr::run(p, vars, v);
+        volatile double result = v.f;
+        (void)result;
+    }
+};
+
+struct BenchmarkExpressionSchema {
+    seval::expr::program p;
+    double row[50];
+
+    BenchmarkExpressionSchema() {
+        WideFormula f;
+        seval::expr::compile(f.text.c_str(), seval::expr::schema(f.names), p);
+        for (int i = 0; i < 50; ++i) row[i] = 0.5 * i;
+    }
+
+    SEVAL_INLINE void operator()() const {
+        seval::expr::value v;
+        seval::expr::run(p, row, v);
+        volatile double result = v.f;
         (void)result;
     }
 };
@@ -151,6 +349,24 @@ void seval_benchmark() {
     benchmark("Floating-point", BenchmarkFloatingPoint());
     benchmark("Floating-point with exponent", BenchmarkFloatingPointExponent());
     benchmark("Binary", BenchmarkBinary());
+    benchmark("Expression (AST)", BenchmarkExpression());
+    benchmark("Expression (bytecode)", BenchmarkExpressionVM());
+    benchmark("Expression (columns, 256 rows)", BenchmarkExpressionColumns());
+
+    seval::expr::program p;
+    seval::expr::jit_program jit;
+    seval::expr::compile("(0x10 + 3.5e2) * -0b11 / x + y * y", p);
+    jit.compile(p);
+    benchmark("Expression (native)", BenchmarkExpressionJIT(jit));
+    benchmark("Expression (native columns, 256 rows)", BenchmarkExpressionJITColumns(jit));
+#if defined(SEVAL_STATIC_FORMULA)
+    benchmark("Expression (compile-time formula)", BenchmarkExpressionStatic());
+#endif
+    benchmark("Expression (50 variables, bindings)", BenchmarkExpressionBindings());
+    benchmark("Expression (50 variables, schema)", BenchmarkExpressionSchema());
+
+    seval::expr::expression_cache cache;
+    benchmark("Expression (cached text)", BenchmarkExpressionCached(cache));
 }
 
 int main() {
@@ -2,7 +2,7 @@
 New-Item -ItemType Directory -Force -Path "bin"
 
 # Define array of C++ standards
-$cpp_standards = @("c++98", "c++03", "c++11", "c++14", "c++17")
+$cpp_standards = @("c++98", "c++03", "c++11", "c++14", "c++17", "c++20")
 
 # Loop through each standard and compile benchmark.cpp and test.cpp
 foreach ($standard in $cpp_standards) {
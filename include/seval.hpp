@@ -19,6 +19,33 @@
 #define SEVAL_INLINE inline
 #endif // SEVAL_INLINE
 
+/* The literal kernels are usable in constant expressions from C++14 on (relaxed constexpr). */
+#if !defined(SEVAL_CONSTEXPR)
+#if __cplusplus >= 201402L
+#define SEVAL_CONSTEXPR constexpr
+#else
+#define SEVAL_CONSTEXPR
+#endif
+#endif // SEVAL_CONSTEXPR
+
+/* Path counters (see seval_stats.hpp); compiled out unless SEVAL_STATS is defined. */
+#if defined(SEVAL_STATS)
+#include "seval_stats.hpp"
+#define SEVAL_STAT_ADD(c, n) ::seval::stats::internal::add(::seval::stats::c, static_cast<uint64_t>(n))
+#else
+#define SEVAL_STAT_ADD(c, n) ((void)0)
+#endif // SEVAL_STATS
+#define SEVAL_STAT(c) SEVAL_STAT_ADD(c, 1)
+#define SEVAL_STAT_IF(cond, c) SEVAL_STAT_ADD(c, (cond) ? 1 : 0)
+
+/* Per-call tracing (see seval_trace.hpp); compiled out unless SEVAL_TRACE is defined. */
+#if defined(SEVAL_TRACE)
+#include "seval_trace.hpp"
+#define SEVAL_TRACE_CALL(k, length) ::seval::trace::internal::span seval_trace_span_(::seval::trace::k, length)
+#else
+#define SEVAL_TRACE_CALL(k, length) ((void)0)
+#endif // SEVAL_TRACE
+
 namespace seval {
 
 namespace compatibility {
@@ -30,8 +57,9 @@ struct StaticAssert;
 template <>
 struct StaticAssert<true> {};
 
+/* sizeof needs the complete type, so a false `expr` fails to compile */
 #define compatibility_static_assert(expr, msg) \
-    typedef compatibility::static_assertion::StaticAssert<(expr)> static_assert_failed_at_##__LINE__
+    typedef char static_assert_failed_at_##__LINE__[sizeof(compatibility::static_assertion::StaticAssert<(expr)>)]
 } /* static_assertion */
 
 namespace type_traits {
@@ -102,7 +130,7 @@ namespace math {
  * 
  * @note This function supports both integer and real base values and integer exponents.
  */
-double pow(double base, int exponent) {
+SEVAL_INLINE SEVAL_CONSTEXPR double pow(double base, int exponent) {
     double result = 1.0;
 
     // Handle the case when exponent is negative
@@ -145,7 +173,7 @@ enum Sign : int8_t {
  * @param cnt The number of characters to subtract from `i`.
  * This function adjusts the index `i` by subtracting `cnt` from it.
  */
-SEVAL_INLINE void dec_(size_t& i, size_t cnt) {
+SEVAL_INLINE SEVAL_CONSTEXPR void dec_(size_t& i, size_t cnt) {
     if (i >= cnt) {
         i -= cnt;
     } else {
@@ -158,7 +186,7 @@ SEVAL_INLINE void dec_(size_t& i, size_t cnt) {
  * @param i The index to be incremented.
  * @param cnt The count to increment the index by.
  */
-SEVAL_INLINE void inc_(size_t& i, size_t cnt) {
+SEVAL_INLINE SEVAL_CONSTEXPR void inc_(size_t& i, size_t cnt) {
     if (cnt >= 0) { // Ensure the count is non-negative before incrementing
         i += cnt;
     }
@@ -171,7 +199,7 @@ SEVAL_INLINE void inc_(size_t& i, size_t cnt) {
  * @param cnt The count to increment the index by.
  * @details If the condition `cond` is true, the index `i` is incremented by `cnt` using `inc_`.
  */
-SEVAL_INLINE void inc_if_(bool cond, size_t& i, size_t cnt) {
+SEVAL_INLINE SEVAL_CONSTEXPR void inc_if_(bool cond, size_t& i, size_t cnt) {
     if (cond) return inc_(i, cnt);
 }
 
@@ -182,7 +210,7 @@ SEVAL_INLINE void inc_if_(bool cond, size_t& i, size_t cnt) {
  * @param cnt The number of characters to subtract from `i`.
  * This function decreases `i` by `cnt` only if the condition `cond` is true.
  */
-SEVAL_INLINE void dec_if_(bool cond, size_t& i, size_t cnt) {
+SEVAL_INLINE SEVAL_CONSTEXPR void dec_if_(bool cond, size_t& i, size_t cnt) {
     if (cond) return dec_(i, cnt);
 }
 
@@ -191,7 +219,7 @@ SEVAL_INLINE void dec_if_(bool cond, size_t& i, size_t cnt) {
  * @param i The index to increment.
  * @param cnt The number of characters to skip.
  */
-SEVAL_INLINE void skip_(size_t& i, size_t cnt) {
+SEVAL_INLINE SEVAL_CONSTEXPR void skip_(size_t& i, size_t cnt) {
     return inc_(i, cnt);
 }
 
@@ -199,7 +227,7 @@ SEVAL_INLINE void skip_(size_t& i, size_t cnt) {
  * @brief Advances the index by 1.
  * @param i The index to increment.
  */
-SEVAL_INLINE void next_(size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR void next_(size_t& i) {
     return inc_(i, 1);
 }
 
@@ -207,10 +235,43 @@ SEVAL_INLINE void next_(size_t& i) {
  * @brief Decrements the index by 1.
  * @param i The index to increment.
  */
-SEVAL_INLINE void prev_(size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR void prev_(size_t& i) {
     return dec_(i, 1);
 }
 
+/**
+ * @brief Appends a digit to a number: `number * radix + digit`.
+ * Integers up to 64 bits wrap around on overflow (the arithmetic is done unsigned), so reading the
+ * magnitude of the most negative value, or an out-of-range literal, is well defined.
+ * @param number The digits read so far.
+ * @param radix The base of the literal.
+ * @param digit The value of the new digit.
+ * @return The updated number.
+ */
+template <typename T>
+SEVAL_INLINE SEVAL_CONSTEXPR T push_digit_(T number, unsigned radix, T digit) {
+    if (_TypeTraitsSpace::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t)) {
+        return static_cast<T>(static_cast<uint64_t>(number) * radix + static_cast<uint64_t>(digit));
+    }
+    return number * static_cast<T>(radix) + digit;
+}
+
+/**
+ * @brief Applies a sign to a number with a conditional negate; integers wrap around like in
+ *        `push_digit_`, so "-1" is the largest value of an unsigned `T`.
+ * @param number The magnitude.
+ * @param sign The sign to apply; `SIGN_NONE` counts as positive.
+ * @return The signed number.
+ */
+template <typename T>
+SEVAL_INLINE SEVAL_CONSTEXPR T apply_sign_(T number, Sign sign) {
+    if (_TypeTraitsSpace::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t)) {
+        uint64_t mask = static_cast<uint64_t>(0) - static_cast<uint64_t>(sign == SIGN_NEGATIVE);
+        return static_cast<T>((static_cast<uint64_t>(number) ^ mask) - mask);
+    }
+    return sign == SIGN_NEGATIVE ? static_cast<T>(-number) : number;
+}
+
 /**
  * @brief Determines the sign of the number at the current index in the string.
  * @param str The string being parsed.
@@ -218,7 +279,7 @@ SEVAL_INLINE void prev_(size_t& i) {
  * @return The sign of the number (negative, positive, or none).
  */
 template <typename StrT>
-Sign get_sign(StrT str, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR Sign get_sign(StrT str, size_t& i) {
     if (str[i] == '-') {
         return SIGN_NEGATIVE;
     } else if (str[i] == '+') {
@@ -233,7 +294,7 @@ Sign get_sign(StrT str, size_t& i) {
  * @param literal The character to check.
  * @return True if the character is a binary digit ('0' or '1'), otherwise false.
  */
-SEVAL_INLINE bool is_binary_ch(const char literal) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_binary_ch(const char literal) {
     return (literal == '0' || literal == '1');
 }
 
@@ -243,7 +304,7 @@ SEVAL_INLINE bool is_binary_ch(const char literal) {
  * @param literal The character to check.
  * @return True if the character is a decimal digit, otherwise false.
  */
-SEVAL_INLINE bool is_decimal_ch(const char literal) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_decimal_ch(const char literal) {
     return (literal >= '0' && literal <= '9');
 }
 
@@ -252,7 +313,7 @@ SEVAL_INLINE bool is_decimal_ch(const char literal) {
  * @param literal The character to check.
  * @return True if the character is a lowercase hexadecimal digit, otherwise false.
  */
-SEVAL_INLINE bool is_lower_hex_ch(const char literal) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_lower_hex_ch(const char literal) {
     return (literal >= 'a' && literal <= 'f');
 }
 
@@ -261,7 +322,7 @@ SEVAL_INLINE bool is_lower_hex_ch(const char literal) {
  * @param literal The character to check.
  * @return True if the character is an uppercase hexadecimal digit, otherwise false.
  */
-SEVAL_INLINE bool is_upper_hex_ch(const char literal) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_upper_hex_ch(const char literal) {
     return (literal >= 'A' && literal <= 'F');
 }
 
@@ -270,7 +331,7 @@ SEVAL_INLINE bool is_upper_hex_ch(const char literal) {
  * @param literal The character to check.
  * @return True if the character is a hexadecimal digit (0-9, a-f, A-F), otherwise false.
  */
-SEVAL_INLINE bool is_hexadecimal_ch(const char literal) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_hexadecimal_ch(const char literal) {
     return (is_decimal_ch(literal) || is_lower_hex_ch(literal) || is_upper_hex_ch(literal));
 }
 
@@ -280,7 +341,7 @@ SEVAL_INLINE bool is_hexadecimal_ch(const char literal) {
  * @return The integer value of the decimal character.
  */
 template <typename T>
-SEVAL_INLINE T evaluate_decimal_ch(const char ch) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_decimal_ch(const char ch) {
     return (ch - '0');
 }
 
@@ -290,7 +351,7 @@ SEVAL_INLINE T evaluate_decimal_ch(const char ch) {
  * @return The integer value of the lowercase hexadecimal character.
  */
 template <typename T>
-SEVAL_INLINE T evaluate_lower_hex_ch(const char ch) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_lower_hex_ch(const char ch) {
     return (ch - 'a' + 10);
 }
 
@@ -300,7 +361,7 @@ SEVAL_INLINE T evaluate_lower_hex_ch(const char ch) {
  * @return The integer value of the uppercase hexadecimal character.
  */
 template <typename T>
-SEVAL_INLINE T evaluate_upper_hex_ch(const char ch) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_upper_hex_ch(const char ch) {
     return (ch - 'A' + 10);
 }
 
@@ -310,7 +371,7 @@ SEVAL_INLINE T evaluate_upper_hex_ch(const char ch) {
  * @return The integer value of the hexadecimal character.
  */
 template <typename T>
-SEVAL_INLINE T evaluate_hexadecimal_ch(const char ch) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_hexadecimal_ch(const char ch) {
     if (is_decimal_ch(ch)) return evaluate_decimal_ch<T>(ch);
     if (is_lower_hex_ch(ch)) return evaluate_lower_hex_ch<T>(ch);
     if (is_upper_hex_ch(ch)) return evaluate_upper_hex_ch<T>(ch);
@@ -323,7 +384,7 @@ SEVAL_INLINE T evaluate_hexadecimal_ch(const char ch) {
  * @return The integer value of the decimal character.
  */
 template <typename T>
-SEVAL_INLINE T evaluate_binary_ch(const char ch) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_binary_ch(const char ch) {
     if (is_binary_ch(ch)) {
         return evaluate_decimal_ch<T>(ch);
     }
@@ -336,7 +397,7 @@ SEVAL_INLINE T evaluate_binary_ch(const char ch) {
  * @return The integer value of the character, or 0 if the character is invalid.
  */
 template <typename T>
-SEVAL_INLINE T evaluate_any_ch(const char ch) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_any_ch(const char ch) {
     if (is_decimal_ch(ch)) {
         return evaluate_decimal_ch<T>(ch);
     } else if (is_lower_hex_ch(ch)) {
@@ -356,25 +417,11 @@ SEVAL_INLINE T evaluate_any_ch(const char ch) {
  * @param i The current index in the string.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_decimal_literal(StrT str, T& number, size_t& i) {
-    #if __cplusplus >= 201703L
-    if constexpr (_TypeTraitsSpace::is_integral<T>::value) {
-        while (str[i] != '\0' && is_hexadecimal_ch(str[i])) {
-            number = (number << 3) + (number << 1) + evaluate_decimal_ch<T>(str[i]);
-            next_(i);
-        }
-    } else {
-        while (str[i] != '\0' && is_hexadecimal_ch(str[i])) {
-            number = number * 10 + evaluate_decimal_ch<T>(str[i]);
-            next_(i);
-        }
-    }
-    #else
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_decimal_literal(StrT str, T& number, size_t& i) {
     while (str[i] != '\0' && is_decimal_ch(str[i])) {
-        number = number * 10 + evaluate_decimal_ch<T>(str[i]);
+        number = push_digit_<T>(number, 10, evaluate_decimal_ch<T>(str[i]));
         next_(i);
     }
-    #endif
 }
 
 /**
@@ -385,7 +432,7 @@ SEVAL_INLINE void evaluate_decimal_literal(StrT str, T& number, size_t& i) {
  * @param decimalPlace The current decimal place.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_floatpoint_literal(StrT str, T& number, size_t& i, T decimalPlace) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_floatpoint_literal(StrT str, T& number, size_t& i, T decimalPlace) {
     while (str[i] != '\0' && is_decimal_ch(str[i])) {
         number += evaluate_decimal_ch<T>(str[i]) * decimalPlace;
         decimalPlace /= static_cast<T>(10);
@@ -400,7 +447,7 @@ SEVAL_INLINE void evaluate_floatpoint_literal(StrT str, T& number, size_t& i, T
  * @param i The current index in the string.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_exponent_literal(StrT str, T& number, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_exponent_literal(StrT str, T& number, size_t& i) {
     if (str[i] == 'e' || str[i] == 'E') {
         next_(i);
         Sign expSign = SIGN_POSITIVE;
@@ -432,11 +479,11 @@ SEVAL_INLINE void evaluate_exponent_literal(StrT str, T& number, size_t& i) {
  * @param i The current index in the string.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_hexadecimal_literal(StrT str, T& number, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_hexadecimal_literal(StrT str, T& number, size_t& i) {
 #if __cplusplus >= 201703L
     if constexpr (_TypeTraitsSpace::is_integral<T>::value) {
         while (str[i] != '\0' && is_hexadecimal_ch(str[i])) {
-            number = (number << 4) | evaluate_hexadecimal_ch<T>(str[i]);
+            number = push_digit_<T>(number, 16, evaluate_hexadecimal_ch<T>(str[i]));
             next_(i);
         }
     } else {
@@ -446,7 +493,7 @@ SEVAL_INLINE void evaluate_hexadecimal_literal(StrT str, T& number, size_t& i) {
     }
 #else
     while (str[i] != '\0' && is_hexadecimal_ch(str[i])) {
-        number = number * 16 + evaluate_hexadecimal_ch<T>(str[i]);
+        number = push_digit_<T>(number, 16, evaluate_hexadecimal_ch<T>(str[i]));
         next_(i);
     }
 #endif /* C++17 */
@@ -459,11 +506,11 @@ SEVAL_INLINE void evaluate_hexadecimal_literal(StrT str, T& number, size_t& i) {
  * @param i The current index in the string.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_binary_literal(StrT str, T& number, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_binary_literal(StrT str, T& number, size_t& i) {
 #if __cplusplus >= 201703L
     if constexpr (_TypeTraitsSpace::is_integral<T>::value) {
         while (str[i] != '\0' && is_binary_ch(str[i])) {
-            number = (number << 1) | evaluate_binary_ch<T>(str[i]);
+            number = push_digit_<T>(number, 2, evaluate_binary_ch<T>(str[i]));
             next_(i);
         }
     } else {
@@ -473,7 +520,7 @@ SEVAL_INLINE void evaluate_binary_literal(StrT str, T& number, size_t& i) {
     }
 #else
     while (str[i] != '\0' && is_binary_ch(str[i])) {
-        number = number * 2 + evaluate_binary_ch<T>(str[i]);
+        number = push_digit_<T>(number, 2, evaluate_binary_ch<T>(str[i]));
         next_(i);
     }
 #endif /* C++17 */
@@ -485,7 +532,7 @@ SEVAL_INLINE void evaluate_binary_literal(StrT str, T& number, size_t& i) {
  * @param i The current index in the string.
  * @param consideSignAndPrefixInMaxLength Whether to include the sign and prefix in the maximum length calculation.
  */
-SEVAL_INLINE void _get_cnti(size_t& cnt, size_t& i, bool consideSignAndPrefixInMaxLength) {
+SEVAL_INLINE SEVAL_CONSTEXPR void _get_cnti(size_t& cnt, size_t& i, bool consideSignAndPrefixInMaxLength) {
     if (consideSignAndPrefixInMaxLength) {
         cnt = i;  // If considering sign and prefix, set the count to the current index
     } else {
@@ -503,12 +550,12 @@ SEVAL_INLINE void _get_cnti(size_t& cnt, size_t& i, bool consideSignAndPrefixInM
  * 
  * @note This function helps to ensure that an iteration does not exceed the specified maximum length.
  */
-SEVAL_INLINE bool _cnti_can_iterate(size_t& cnt, size_t& maxLength) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool _cnti_can_iterate(size_t& cnt, size_t& maxLength) {
     // std::cout << "Called can iterate with args: cnt(" << cnt << ")" << " maxLength(" << maxLength << ")\n";
     return cnt < maxLength;
 }
 
-SEVAL_INLINE void _cnti_next(size_t& cnt, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR void _cnti_next(size_t& cnt, size_t& i) {
     inc_(cnt,1);
     inc_(i,1);
 }
@@ -522,31 +569,15 @@ SEVAL_INLINE void _cnti_next(size_t& cnt, size_t& i) {
  * @param consideSignAndPrefixInMaxLength Whether to include the sign and prefix in the maximum length calculation.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_decimal_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_decimal_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
     size_t cnt = 0;
     _get_cnti(cnt, i, consideSignAndPrefixInMaxLength);
 
-    #if __cplusplus >= 201703L
-    if constexpr (_TypeTraitsSpace::is_integral<T>::value) {
-        while (str[i] != '\0' && is_hexadecimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-            number = (number << 3) + (number << 1) + evaluate_decimal_ch<T>(str[i]);
-            // next_(i);
-            _cnti_next(cnt,i);
-        }
-    } else {
-        while (str[i] != '\0' && is_hexadecimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-            number = number * 10 + evaluate_decimal_ch<T>(str[i]);
-            // next_(i);
-            _cnti_next(cnt,i);
-        }
-    }
-    #else
-    while (str[i] != '\0' && is_decimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-        number = number * 10 + evaluate_decimal_ch<T>(str[i]);
+    while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_decimal_ch(str[i])) {
+        number = push_digit_<T>(number, 10, evaluate_decimal_ch<T>(str[i]));
         // next_(i);
         _cnti_next(cnt,i);
     }
-    #endif
 }
 
 /**
@@ -559,11 +590,11 @@ SEVAL_INLINE void evaluate_decimal_literal_n(StrT str, T& number, size_t& i, siz
  * @param consideSignAndPrefixInMaxLength Whether to include the sign and prefix in the maximum length calculation.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_floatpoint_literal_n(StrT str, T& number, size_t& i, T decimalPlace, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_floatpoint_literal_n(StrT str, T& number, size_t& i, T decimalPlace, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
     size_t cnt = 0;
     _get_cnti(cnt, i, consideSignAndPrefixInMaxLength);
 
-    while (str[i] != '\0' && is_decimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
+    while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_decimal_ch(str[i])) {
         number += evaluate_decimal_ch<T>(str[i]) * decimalPlace;
         decimalPlace /= static_cast<T>(10);
         /* next_(i) */ _cnti_next(cnt,i);
@@ -579,7 +610,7 @@ SEVAL_INLINE void evaluate_floatpoint_literal_n(StrT str, T& number, size_t& i,
  * @param consideSignAndPrefixInMaxLength Whether to include the sign and prefix in the maximum length calculation.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_exponent_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_exponent_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
     size_t cnt = 0;
     _get_cnti(cnt, i, consideSignAndPrefixInMaxLength);
 
@@ -587,20 +618,23 @@ SEVAL_INLINE void evaluate_exponent_literal_n(StrT str, T& number, size_t& i, si
         /* next_(i) */ _cnti_next(cnt,i);
         Sign expSign = SIGN_POSITIVE;
 
-        if (str[i] == '-') {
+        if (_cnti_can_iterate(cnt, maxLength) && str[i] == '-') {
             expSign = SIGN_NEGATIVE;
             /* next_(i) */ _cnti_next(cnt,i);
-        } else if (str[i] == '+') {
+        } else if (_cnti_can_iterate(cnt, maxLength) && str[i] == '+') {
             /* next_(i) */ _cnti_next(cnt,i);
         }
 
         int exponent = 0;
-        while (str[i] != '\0' && is_decimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
+        while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_decimal_ch(str[i])) {
+            /* past 10^8 the power is 0 or infinite anyway; stop before the int overflows */
+            if (exponent < 100000000) {
         #if __cplusplus >= 201703L
-            exponent = (exponent << 3) + (exponent << 1) + evaluate_decimal_ch<int>(str[i]);
+                exponent = (exponent << 3) + (exponent << 1) + evaluate_decimal_ch<int>(str[i]);
         #else
-            exponent = exponent * 10 + evaluate_decimal_ch<int>(str[i]);
+                exponent = exponent * 10 + evaluate_decimal_ch<int>(str[i]);
         #endif
+            }
             /* next_(i) */ _cnti_next(cnt,i);
         }
         number *= internal::math::pow(static_cast<T>(10), static_cast<T>(expSign * exponent));
@@ -616,23 +650,23 @@ SEVAL_INLINE void evaluate_exponent_literal_n(StrT str, T& number, size_t& i, si
  * @param consideSignAndPrefixInMaxLength Whether to include the sign and prefix in the maximum length calculation.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_hexadecimal_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_hexadecimal_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
     size_t cnt = 0;
     _get_cnti(cnt, i, consideSignAndPrefixInMaxLength);
 #if __cplusplus >= 201703L
     if constexpr (_TypeTraitsSpace::is_integral<T>::value) {
-        while (str[i] != '\0' && is_hexadecimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-            number = (number << 4) | evaluate_hexadecimal_ch<T>(str[i]);
+        while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_hexadecimal_ch(str[i])) {
+            number = push_digit_<T>(number, 16, evaluate_hexadecimal_ch<T>(str[i]));
             /* next_(i) */ _cnti_next(cnt,i);
         }
     } else {
-        while (str[i] != '\0' && is_hexadecimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
+        while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_hexadecimal_ch(str[i])) {
             /* next_(i) */ _cnti_next(cnt,i);
         }
     }
 #else
-    while (str[i] != '\0' && is_hexadecimal_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-        number = number * 16 + evaluate_hexadecimal_ch<T>(str[i]);
+    while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_hexadecimal_ch(str[i])) {
+        number = push_digit_<T>(number, 16, evaluate_hexadecimal_ch<T>(str[i]));
         /* next_(i) */ _cnti_next(cnt,i);
     }
 #endif
@@ -647,23 +681,23 @@ SEVAL_INLINE void evaluate_hexadecimal_literal_n(StrT str, T& number, size_t& i,
  * @param consideSignAndPrefixInMaxLength Whether to include the sign and prefix in the maximum length calculation.
  */
 template <typename T, typename StrT>
-SEVAL_INLINE void evaluate_binary_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR void evaluate_binary_literal_n(StrT str, T& number, size_t& i, size_t maxLength, bool consideSignAndPrefixInMaxLength = true) {
     size_t cnt = 0;
     _get_cnti(cnt, i, consideSignAndPrefixInMaxLength);
 #if __cplusplus >= 201703L
     if constexpr (_TypeTraitsSpace::is_integral<T>::value) {
-        while (str[i] != '\0' && is_binary_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-            number = (number << 1) | evaluate_binary_ch<T>(str[i]);
+        while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_binary_ch(str[i])) {
+            number = push_digit_<T>(number, 2, evaluate_binary_ch<T>(str[i]));
             /* next_(i) */ _cnti_next(cnt,i);
         }
     } else {
-        while (str[i] != '\0' && is_binary_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
+        while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_binary_ch(str[i])) {
             /* next_(i) */ _cnti_next(cnt,i);
         }
     }
 #else
-    while (str[i] != '\0' && is_binary_ch(str[i]) && _cnti_can_iterate(cnt, maxLength)) {
-        number = number * 2 + evaluate_binary_ch<T>(str[i]);
+    while (_cnti_can_iterate(cnt, maxLength) && str[i] != '\0' && is_binary_ch(str[i])) {
+        number = push_digit_<T>(number, 2, evaluate_binary_ch<T>(str[i]));
         /* next_(i) */ _cnti_next(cnt,i);
     }
 #endif
@@ -676,7 +710,7 @@ SEVAL_INLINE void evaluate_binary_literal_n(StrT str, T& number, size_t& i, size
  * @return True if the string has a hexadecimal prefix, otherwise false.
  */
 template <typename StrT>
-SEVAL_INLINE bool has_hexadecimal_prefix(StrT literal, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool has_hexadecimal_prefix(StrT literal, size_t& i) {
     return (literal[i] == '0') && (literal[i + 1] == 'x' || literal[i + 1] == 'X');
 }
 
@@ -687,7 +721,7 @@ SEVAL_INLINE bool has_hexadecimal_prefix(StrT literal, size_t& i) {
  * @return True if the string has a binary prefix, otherwise false.
  */
 template <typename StrT>
-SEVAL_INLINE bool has_binary_prefix(StrT literal, size_t& i) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool has_binary_prefix(StrT literal, size_t& i) {
     return (literal[i] == '0') && (literal[i + 1] == 'b' || literal[i + 1] == 'B');
 }
 
@@ -698,10 +732,117 @@ SEVAL_INLINE bool has_binary_prefix(StrT literal, size_t& i) {
  * @return True if the string has a sign, otherwise false.
  */
 template <typename StrT>
-SEVAL_INLINE bool has_sign(StrT literal, size_t i) {
+SEVAL_INLINE SEVAL_CONSTEXPR bool has_sign(StrT literal, size_t i) {
     return literal[i] == '-' || literal[i] == '+';
 }
 
+/**
+ * @brief Value of a digit in base `Radix` (2, 10 or 16), or `Radix` or more if `c` is not one.
+ */
+template <unsigned Radix>
+SEVAL_INLINE SEVAL_CONSTEXPR unsigned digit_value_(char c) {
+    unsigned d = static_cast<unsigned>(static_cast<unsigned char>(c)) - '0';
+    if (Radix != 16 || d < 10) return d;
+    unsigned letter = (static_cast<unsigned>(static_cast<unsigned char>(c)) | 0x20u) - 'a'; /* 'A'-'F' and 'a'-'f' */
+    return letter < 6 ? letter + 10 : 16;
+}
+
+/**
+ * @brief Reads the digits of an integer literal in base `Radix` (2, 10 or 16) into a 64-bit
+ *        magnitude, stopping at the first byte that is not a digit or at `length`.
+ * @param str The string being parsed.
+ * @param magnitude The value of the digits read so far; updated (wrapping around on overflow).
+ * @param i The current index in the string.
+ * @param length The length of the string.
+ * @return `false` if the value does not fit in 64 bits.
+ */
+template <unsigned Radix>
+SEVAL_INLINE SEVAL_CONSTEXPR bool evaluate_magnitude_n(const char* str, uint64_t& magnitude, size_t& i, size_t length) {
+    /* the largest magnitude that can take any digit; above it, or at it with a large digit, the value overflows */
+    const uint64_t cutoff = ~static_cast<uint64_t>(0) / Radix;
+    const unsigned cutlim = static_cast<unsigned>(~static_cast<uint64_t>(0) % Radix);
+    bool exact = true;
+    for (; i < length; ++i) {
+        unsigned d = digit_value_<Radix>(str[i]);
+        if (d >= Radix) break;
+        if (magnitude >= cutoff && (magnitude > cutoff || d > cutlim)) exact = false;
+        magnitude = magnitude * Radix + d;
+    }
+    return exact;
+}
+
+/**
+ * @brief Range of an integral type up to 64 bits, which `evaluate_field` checks literals against.
+ *        Other types (floating-point, wider integers) accept every magnitude.
+ */
+template <typename T, bool Checked = _TypeTraitsSpace::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t)>
+struct integer_range_ {
+    static const bool checked = false;
+
+    static SEVAL_CONSTEXPR bool fits(uint64_t, Sign) { return true; }
+};
+
+template <typename T>
+struct integer_range_<T, true> {
+    static const bool checked = true;
+
+    /** @brief Whether `magnitude` with `sign` is a value of `T`; "-0" is one for unsigned `T` too. */
+    static SEVAL_CONSTEXPR bool fits(uint64_t magnitude, Sign sign) {
+        if (static_cast<T>(-1) < static_cast<T>(0)) {
+            uint64_t max = (static_cast<uint64_t>(1) << (8 * sizeof(T) - 1)) - 1;
+            return magnitude <= max + (sign == SIGN_NEGATIVE ? 1u : 0u);
+        }
+        return sign == SIGN_NEGATIVE ? magnitude == 0 : magnitude <= static_cast<uint64_t>(static_cast<T>(~static_cast<T>(0)));
+    }
+};
+
+/**
+ * @struct prologue
+ * @brief What precedes the digits of a literal.
+ */
+struct prologue {
+    Sign sign;       /**< `SIGN_NEGATIVE` or `SIGN_POSITIVE`. */
+    bool hasSign;    /**< Whether a '+' or '-' was read. */
+    unsigned radix;  /**< 2, 10 or 16. */
+    size_t length;   /**< Characters taken by the sign and the prefix. */
+};
+
+/**
+ * @brief Reads the optional sign and "0b"/"0x" prefix of a literal in one pass.
+ *
+ * Each of the first three characters is read at most once and the sign, radix and length are
+ * derived from them with compares and arithmetic instead of a chain of branches. The character
+ * after a '0' is only read when it lies within `length`, like in `has_binary_prefix`.
+ *
+ * @param str The string being parsed.
+ * @param length Characters available (`SIZE_MAX` for a terminated string); must be at least 1.
+ * @param consideSign Whether a leading '+' or '-' is part of the literal.
+ * @param consideHex Whether "0x" and "0X" select radix 16.
+ * @param consideBinary Whether "0b" and "0B" select radix 2.
+ * @return The sign, radix and length of the prologue.
+ */
+template <typename StrT>
+SEVAL_INLINE SEVAL_CONSTEXPR prologue read_prologue(StrT str, size_t length, bool consideSign, bool consideHex, bool consideBinary) {
+    char lead = str[0];
+    bool negative = consideSign && lead == '-';
+    bool hasSign = negative || (consideSign && lead == '+');
+    size_t s = static_cast<size_t>(hasSign);
+
+    /* 'X' | 0x20 == 'x' and 'B' | 0x20 == 'b' */
+    bool zero = s + 1 < length && str[s] == '0';
+    char marker = zero ? static_cast<char>(str[s + 1] | 0x20) : '\0';
+    bool hex = consideHex && marker == 'x';
+    bool binary = consideBinary && marker == 'b';
+
+    prologue head = {
+        negative ? SIGN_NEGATIVE : SIGN_POSITIVE,
+        hasSign,
+        10u + 6u * static_cast<unsigned>(hex) - 8u * static_cast<unsigned>(binary),
+        s + 2 * static_cast<size_t>(hex || binary)
+    };
+    return head;
+}
+
 } /* internal */
 
 /**
@@ -722,43 +863,45 @@ SEVAL_INLINE bool has_sign(StrT literal, size_t i) {
  * @throws _StatAssert If `T` is not an arithmetic type (integral or floating-point).
  */
 template <typename T, typename StrT>
-SEVAL_INLINE T evaluate(StrT str, bool consideSign = true, bool consideFloatPoint = true, bool consideHex = true, bool consideBinary = true, bool consideExponent = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate(StrT str, bool consideSign = true, bool consideFloatPoint = true, bool consideHex = true, bool consideBinary = true, bool consideExponent = true) {
     _StatAssert(_TypeTraitsSpace::is_arithmetic<T>::value, "Template parameter T must be an arithmetic type (integral or floating-point).");
     
     T number = 0;
     size_t i = 0;
 
-    internal::Sign sign = internal::SIGN_POSITIVE;
+    SEVAL_TRACE_CALL(KERNEL_EVALUATE, i);
+    SEVAL_STAT(EVALUATE_CALLS);
 
-    if (consideSign) {
-        internal::Sign intermediateSign = internal::get_sign<StrT>(str, i);
-        if (intermediateSign != internal::SIGN_NONE) {
-            sign = intermediateSign;
-            internal::skip_(i, 1); /* Eat: sigSym (+ or -) */
-        }
-    }
+    /* Eat: sigSym (+ or -) and binaryPrefix (0b or 0B) or hexadecimalPrefix (0x or 0X) */
+    internal::prologue head = internal::read_prologue<StrT>(str, SIZE_MAX, consideSign, consideHex, consideBinary);
+    SEVAL_STAT_IF(head.hasSign, EVALUATE_SIGN);
+    i = head.length;
 
-    if (consideBinary && internal::has_binary_prefix<StrT>(str, i)) {
-        internal::skip_(i, 2); // Eat: binaryPrefix (0b or 0B) 
+    if (head.radix == 2) {
+        SEVAL_STAT(EVALUATE_BINARY);
         internal::evaluate_binary_literal<T, StrT>(str, number, i);
-    } else if (consideHex && internal::has_hexadecimal_prefix<StrT>(str, i)) {
-        internal::skip_(i, 2); /* Eat: hexadecimalPrefix (0x or 0X) */
+    } else if (head.radix == 16) {
+        SEVAL_STAT(EVALUATE_HEXADECIMAL);
         internal::evaluate_hexadecimal_literal<T, StrT>(str, number, i);
     } else {
+        SEVAL_STAT(EVALUATE_DECIMAL);
         internal::evaluate_decimal_literal<T, StrT>(str, number, i);
     }
 
     if (_TypeTraitsSpace::is_floating_point<T>::value && consideFloatPoint && str[i] == '.') {
+        SEVAL_STAT(EVALUATE_FRACTION);
         internal::next_(i);
         T decimalPlace = static_cast<T>(0.1);
         internal::evaluate_floatpoint_literal<T, StrT>(str, number, i, decimalPlace);
     }
 
     if (_TypeTraitsSpace::is_floating_point<T>::value && consideFloatPoint && consideExponent) {
+        SEVAL_STAT_IF(str[i] == 'e' || str[i] == 'E', EVALUATE_EXPONENT);
         internal::evaluate_exponent_literal<T, StrT>(str, number, i);
     }
 
-    return consideSign ? number * sign : number;
+    SEVAL_STAT_ADD(EVALUATE_BYTES, i);
+    return internal::apply_sign_<T>(number, head.sign);
 }
 
 /**
@@ -782,36 +925,34 @@ SEVAL_INLINE T evaluate(StrT str, bool consideSign = true, bool consideFloatPoin
  * @throws _StatAssert If `T` is not an arithmetic type (integral or floating-point).
  */
 template <typename T, typename StrT>
-SEVAL_INLINE T evaluate_n(StrT str, size_t maxLength = SIZE_MAX, bool consideSignAndPrefixInMaxLength = true, bool consideSign = true, bool consideFloatPoint = true, bool consideHex = true, bool consideBinary = true, bool consideExponent = true) {
+SEVAL_INLINE SEVAL_CONSTEXPR T evaluate_n(StrT str, size_t maxLength = SIZE_MAX, bool consideSignAndPrefixInMaxLength = true, bool consideSign = true, bool consideFloatPoint = true, bool consideHex = true, bool consideBinary = true, bool consideExponent = true) {
     _StatAssert(_TypeTraitsSpace::is_arithmetic<T>::value, "Template parameter T must be an arithmetic type (integral or floating-point).");
 
     T number = 0;
     size_t i = 0;
 
-    internal::Sign sign = internal::SIGN_POSITIVE;
+    SEVAL_TRACE_CALL(KERNEL_EVALUATE_N, i);
+    SEVAL_STAT(EVALUATE_N_CALLS);
 
-    // Handle the sign of the number if considered
-    if (consideSign) {
-        internal::Sign intermediateSign = internal::get_sign<StrT>(str, i);
-        if (intermediateSign != internal::SIGN_NONE) {
-            sign = intermediateSign;
-            internal::skip_(i, 1); /* Eat: sigSym (+ or -) */
-        }
-    }
+    // Handle the sign and the binary or hexadecimal prefix if the corresponding flags are set
+    internal::prologue head = internal::read_prologue<StrT>(str, SIZE_MAX, consideSign, consideHex, consideBinary);
+    SEVAL_STAT_IF(head.hasSign, EVALUATE_N_SIGN);
+    i = head.length;
 
-    // Process binary or hexadecimal literals if the corresponding flags are set
-    if (consideBinary && internal::has_binary_prefix<StrT>(str, i)) {
-        internal::skip_(i, 2); // Eat: binaryPrefix (0b or 0B)
+    if (head.radix == 2) {
+        SEVAL_STAT(EVALUATE_N_BINARY);
         internal::evaluate_binary_literal_n<T, StrT>(str, number, i, maxLength, consideSignAndPrefixInMaxLength);
-    } else if (consideHex && internal::has_hexadecimal_prefix<StrT>(str, i)) {
-        internal::skip_(i, 2); /* Eat: hexadecimalPrefix (0x or 0X) */
+    } else if (head.radix == 16) {
+        SEVAL_STAT(EVALUATE_N_HEXADECIMAL);
         internal::evaluate_hexadecimal_literal_n<T, StrT>(str, number, i, maxLength, consideSignAndPrefixInMaxLength);
     } else {
+        SEVAL_STAT(EVALUATE_N_DECIMAL);
         internal::evaluate_decimal_literal_n<T, StrT>(str, number, i, maxLength, consideSignAndPrefixInMaxLength);
     }
 
     // Process floating-point literals if required and within the maxLength
     if (_TypeTraitsSpace::is_floating_point<T>::value && consideFloatPoint && str[i] == '.' && maxLength > i) {
+        SEVAL_STAT(EVALUATE_N_FRACTION);
         internal::next_(i);
         T decimalPlace = static_cast<T>(0.1);
         internal::evaluate_floatpoint_literal_n<T, StrT>(str, number, i, decimalPlace, maxLength, consideSignAndPrefixInMaxLength);
@@ -819,11 +960,115 @@ SEVAL_INLINE T evaluate_n(StrT str, size_t maxLength = SIZE_MAX, bool consideSig
 
     // Process exponent literals if required and within the maxLength
     if (_TypeTraitsSpace::is_floating_point<T>::value && consideFloatPoint && consideExponent) {
+        SEVAL_STAT_IF(str[i] == 'e' || str[i] == 'E', EVALUATE_N_EXPONENT);
         internal::evaluate_exponent_literal_n<T, StrT>(str, number, i, maxLength, consideSignAndPrefixInMaxLength);
     }
 
+    SEVAL_STAT_ADD(EVALUATE_N_BYTES, i);
+
     // Return the final evaluated number, considering the sign if applicable
-    return consideSign ? number * sign : number;
+    return internal::apply_sign_<T>(number, head.sign);
+}
+
+/**
+ * @brief Evaluates a length-delimited field that must consist of exactly one number literal.
+ *
+ * Unlike `evaluate_n`, the field is validated: it must be non-empty, contain at least one digit,
+ * and be consumed completely (no trailing characters, no dangling exponent or prefix). For integral
+ * `T` of up to 64 bits the value must also fit in `T`, with no '-' for unsigned `T` (except "-0").
+ * The "0b" and "0x" prefixes are only read for integral `T`.
+ * No byte at or past `str[length]` is read, so fields may point straight into a larger buffer.
+ *
+ * @param str The start of the field.
+ * @param length The length of the field in characters.
+ * @param out Receives the evaluated number if the field is valid; left untouched otherwise.
+ *
+ * @return `true` if the field is a valid literal for `T`, otherwise `false`.
+ */
+template <typename T>
+SEVAL_INLINE SEVAL_CONSTEXPR bool evaluate_field(const char* str, size_t length, T& out) {
+    _StatAssert(_TypeTraitsSpace::is_arithmetic<T>::value, "Template parameter T must be an arithmetic type (integral or floating-point).");
+
+    T number = 0;
+    size_t i = 0;
+    size_t begin = 0;
+    size_t digits = 0;
+
+    SEVAL_TRACE_CALL(KERNEL_EVALUATE_FIELD, length);
+    SEVAL_STAT(FIELD_CALLS);
+    SEVAL_STAT_ADD(FIELD_BYTES, length);
+
+    if (length == 0) {
+        SEVAL_STAT(FIELD_ERROR_EMPTY);
+        return false;
+    }
+
+    /* Eat: sigSym (+ or -) and, for integers, binaryPrefix (0b or 0B) or hexadecimalPrefix (0x or 0X) */
+    const bool integral = _TypeTraitsSpace::is_integral<T>::value;
+    internal::prologue head = internal::read_prologue<const char*>(str, length, true, integral, integral);
+    SEVAL_STAT_IF(head.hasSign, FIELD_SIGN);
+    i = head.length;
+
+    /* integers up to 64 bits are read as a magnitude and range-checked before the sign is applied */
+    const bool checked = internal::integer_range_<T>::checked;
+    uint64_t magnitude = 0;
+    bool exact = true;
+
+    if (head.radix == 2) {
+        SEVAL_STAT(FIELD_BINARY);
+        begin = i;
+        if (checked) exact = internal::evaluate_magnitude_n<2>(str, magnitude, i, length);
+        else internal::evaluate_binary_literal_n<T, const char*>(str, number, i, length);
+        digits = i - begin;
+    } else if (head.radix == 16) {
+        SEVAL_STAT(FIELD_HEXADECIMAL);
+        begin = i;
+        if (checked) exact = internal::evaluate_magnitude_n<16>(str, magnitude, i, length);
+        else internal::evaluate_hexadecimal_literal_n<T, const char*>(str, number, i, length);
+        digits = i - begin;
+    } else {
+        SEVAL_STAT(FIELD_DECIMAL);
+        begin = i;
+        if (checked) exact = internal::evaluate_magnitude_n<10>(str, magnitude, i, length);
+        else internal::evaluate_decimal_literal_n<T, const char*>(str, number, i, length);
+        digits = i - begin;
+
+        if (_TypeTraitsSpace::is_floating_point<T>::value && i < length && str[i] == '.') {
+            SEVAL_STAT(FIELD_FRACTION);
+            internal::next_(i);
+            begin = i;
+            internal::evaluate_floatpoint_literal_n<T, const char*>(str, number, i, static_cast<T>(0.1), length);
+            digits += i - begin;
+        }
+
+        if (_TypeTraitsSpace::is_floating_point<T>::value && digits != 0 && i < length && (str[i] == 'e' || str[i] == 'E')) {
+            SEVAL_STAT(FIELD_EXPONENT);
+            internal::evaluate_exponent_literal_n<T, const char*>(str, number, i, length);
+            if (!internal::is_decimal_ch(str[i - 1])) { /* "1e", "1e+" */
+                SEVAL_STAT(FIELD_ERROR_EXPONENT);
+                return false;
+            }
+        }
+    }
+
+    if (digits == 0) {
+        SEVAL_STAT(FIELD_ERROR_DIGITS);
+        return false;
+    }
+    if (i != length) {
+        SEVAL_STAT(FIELD_ERROR_TRAILING);
+        return false;
+    }
+    if (checked) {
+        if (!exact || !internal::integer_range_<T>::fits(magnitude, head.sign)) {
+            SEVAL_STAT(FIELD_ERROR_RANGE);
+            return false;
+        }
+        number = static_cast<T>(magnitude);
+    }
+
+    out = internal::apply_sign_<T>(number, head.sign);
+    return true;
 }
 
 } /* seval */
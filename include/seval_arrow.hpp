@@ -0,0 +1,285 @@
+/**
+ * @file seval_arrow.hpp
+ * @brief Column output in the Apache Arrow C Data Interface layout.
+ *
+ * `parse_column_arrow` evaluates a delimited column (see seval_batch.hpp) straight into an
+ * `ArrowArray`: a 64-byte aligned value buffer plus a validity bitmap in which invalid or empty
+ * fields are nulls. The exported array and schema can be handed to any Arrow implementation
+ * without copying. The C Data Interface structs are declared here, so no Arrow headers or
+ * libraries are needed.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_ARROW_HPP_LOADED)
+#define SEVAL_ARROW_HPP_LOADED
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "seval_batch.hpp"
+
+/* The ABI-stable structs of the Arrow C Data Interface, guarded as the specification requires. */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace seval {
+
+namespace arrow {
+
+namespace internal {
+/**
+ * @brief Arrow format string of a fixed-width primitive, selected by size and signedness.
+ */
+template <size_t Size, bool Integral, bool Signed>
+struct format_of;
+
+template <> struct format_of<1, true, true>   { static const char* value() { return "c"; } };
+template <> struct format_of<1, true, false>  { static const char* value() { return "C"; } };
+template <> struct format_of<2, true, true>   { static const char* value() { return "s"; } };
+template <> struct format_of<2, true, false>  { static const char* value() { return "S"; } };
+template <> struct format_of<4, true, true>   { static const char* value() { return "i"; } };
+template <> struct format_of<4, true, false>  { static const char* value() { return "I"; } };
+template <> struct format_of<8, true, true>   { static const char* value() { return "l"; } };
+template <> struct format_of<8, true, false>  { static const char* value() { return "L"; } };
+template <> struct format_of<4, false, true>  { static const char* value() { return "f"; } };
+template <> struct format_of<8, false, true>  { static const char* value() { return "g"; } };
+
+/**
+ * @brief Signedness used to pick the format; floating-point types always count as signed.
+ */
+template <typename T, bool Integral>
+struct is_signed_ { static const bool value = true; };
+
+template <typename T>
+struct is_signed_<T, true> { static const bool value = (static_cast<T>(-1) < static_cast<T>(0)); };
+
+/** Buffer alignment recommended by the Arrow columnar format. */
+static const size_t alignment = 64;
+
+/**
+ * @brief Allocates `size` bytes aligned to `alignment`; the original pointer is stored just before the block.
+ */
+SEVAL_INLINE void* aligned_alloc_(size_t size) {
+    void* raw = malloc(size + alignment + sizeof(void*));
+    if (!raw) return NULL;
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+}
+
+SEVAL_INLINE void aligned_free_(void* p) {
+    if (p) free(reinterpret_cast<void**>(p)[-1]);
+}
+
+/**
+ * @brief Owns the buffers of an exported array; freed by `release_array`.
+ */
+struct array_private {
+    const void* buffers[2];
+};
+
+/**
+ * @brief Owns the name of an exported schema; freed by `release_schema`.
+ */
+struct schema_private {
+    char* name;
+};
+
+SEVAL_INLINE void release_array(struct ArrowArray* array) {
+    array_private* priv = static_cast<array_private*>(array->private_data);
+    aligned_free_(const_cast<void*>(priv->buffers[0]));
+    aligned_free_(const_cast<void*>(priv->buffers[1]));
+    delete priv;
+    array->release = NULL;
+}
+
+SEVAL_INLINE void release_schema(struct ArrowSchema* schema) {
+    schema_private* priv = static_cast<schema_private*>(schema->private_data);
+    free(priv->name);
+    delete priv;
+    schema->release = NULL;
+}
+
+/**
+ * @brief Field functor that writes values and validity bits into growable aligned buffers.
+ */
+template <typename T>
+struct arrow_sink {
+    T* values;
+    uint8_t* validity;
+    size_t capacity;
+    size_t rows;
+    size_t nulls;
+    bool failed;
+
+    explicit arrow_sink(size_t expectedRows) : values(NULL), validity(NULL), capacity(0), rows(0), nulls(0), failed(false) {
+        grow(expectedRows < 64 ? 64 : expectedRows);
+    }
+
+    SEVAL_INLINE bool grow(size_t newCapacity) {
+        T* newValues = static_cast<T*>(aligned_alloc_(newCapacity * sizeof(T)));
+        uint8_t* newValidity = static_cast<uint8_t*>(aligned_alloc_((newCapacity + 7) / 8));
+        if (!newValues || !newValidity) {
+            aligned_free_(newValues);
+            aligned_free_(newValidity);
+            failed = true;
+            return false;
+        }
+        memset(newValidity, 0, (newCapacity + 7) / 8);
+        if (rows) {
+            memcpy(newValues, values, rows * sizeof(T));
+            memcpy(newValidity, validity, (rows + 7) / 8);
+        }
+        aligned_free_(values);
+        aligned_free_(validity);
+        values = newValues;
+        validity = newValidity;
+        capacity = newCapacity;
+        return true;
+    }
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        (void)row;
+        if (failed || (rows == capacity && !grow(capacity * 2))) return;
+
+        T value = 0;
+        if (evaluate_field<T>(field, length, value)) {
+            validity[rows >> 3] |= static_cast<uint8_t>(1u << (rows & 7));
+        } else {
+            ++nulls;
+        }
+        values[rows++] = value;
+    }
+};
+} /* internal */
+
+/**
+ * @brief Returns the Arrow format string of `T` ("i" for int32_t, "g" for double, ...).
+ */
+template <typename T>
+SEVAL_INLINE const char* format() {
+    return internal::format_of<sizeof(T), _TypeTraitsSpace::is_integral<T>::value,
+                               internal::is_signed_<T, _TypeTraitsSpace::is_integral<T>::value>::value>::value();
+}
+
+/**
+ * @brief Evaluates every field of a delimited buffer into an Arrow C Data Interface array.
+ *
+ * The array has two buffers: the validity bitmap (LSB bit order, or `NULL` when there are no nulls)
+ * and the 64-byte aligned values, with 0 stored in the slots of null rows. Both are owned by the
+ * array and freed by its `release` callback.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param array Receives the exported array.
+ * @param schema If not `NULL`, receives the matching nullable primitive schema.
+ * @param name The field name written to the schema (default is "").
+ *
+ * @return `true` on success, `false` if a buffer could not be allocated (nothing is exported then).
+ */
+template <typename T>
+SEVAL_INLINE bool parse_column_arrow(const char* data, size_t size, char delimiter, struct ArrowArray* array,
+                                     struct ArrowSchema* schema = NULL, const char* name = "") {
+    internal::arrow_sink<T> sink(size / 8);
+    batch::internal::for_each_field(data, size, delimiter, sink);
+
+    internal::array_private* arrayPrivate = sink.failed ? NULL : new internal::array_private;
+    internal::schema_private* schemaPrivate = NULL;
+    if (arrayPrivate && schema) {
+        schemaPrivate = new internal::schema_private;
+        schemaPrivate->name = static_cast<char*>(malloc(strlen(name) + 1));
+        if (schemaPrivate->name) {
+            memcpy(schemaPrivate->name, name, strlen(name) + 1);
+        } else {
+            delete schemaPrivate;
+            schemaPrivate = NULL;
+        }
+    }
+
+    if (!arrayPrivate || (schema && !schemaPrivate)) {
+        internal::aligned_free_(sink.values);
+        internal::aligned_free_(sink.validity);
+        delete arrayPrivate;
+        return false;
+    }
+
+    if (sink.nulls == 0) {
+        internal::aligned_free_(sink.validity);
+        sink.validity = NULL;
+    }
+
+    arrayPrivate->buffers[0] = sink.validity;
+    arrayPrivate->buffers[1] = sink.values;
+
+    array->length = static_cast<int64_t>(sink.rows);
+    array->null_count = static_cast<int64_t>(sink.nulls);
+    array->offset = 0;
+    array->n_buffers = 2;
+    array->n_children = 0;
+    array->buffers = arrayPrivate->buffers;
+    array->children = NULL;
+    array->dictionary = NULL;
+    array->release = &internal::release_array;
+    array->private_data = arrayPrivate;
+
+    if (schema) {
+        schema->format = format<T>();
+        schema->name = schemaPrivate->name;
+        schema->metadata = NULL;
+        schema->flags = ARROW_FLAG_NULLABLE;
+        schema->n_children = 0;
+        schema->children = NULL;
+        schema->dictionary = NULL;
+        schema->release = &internal::release_schema;
+        schema->private_data = schemaPrivate;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks the validity bit of a row of an exported array.
+ */
+SEVAL_INLINE bool is_valid(const struct ArrowArray* array, int64_t row) {
+    const uint8_t* validity = static_cast<const uint8_t*>(array->buffers[0]);
+    row += array->offset;
+    return !validity || ((validity[row >> 3] >> (row & 7)) & 1);
+}
+
+} /* arrow */
+
+} /* seval */
+
+#endif // SEVAL_ARROW_HPP_LOADED
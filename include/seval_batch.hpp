@@ -0,0 +1,1154 @@
+/**
+ * @file seval_batch.hpp
+ * @brief Batch (column) evaluation on top of seval.hpp.
+ *
+ * A column is a buffer of delimiter-separated fields, e.g. one value per line. The functions in
+ * this header split such a buffer into fields and evaluate every field with `seval::evaluate_field`,
+ * reporting fields that are empty or not a valid literal as errors instead of silently returning 0.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_BATCH_HPP_LOADED)
+#define SEVAL_BATCH_HPP_LOADED
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEVAL_BATCH_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SEVAL_BATCH_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SEVAL_BATCH_PREFETCH(p) _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define SEVAL_BATCH_PREFETCH(p) ((void)(p))
+#endif
+
+/* Strings `parse_gather` prefetches ahead of the one it converts. */
+#if !defined(SEVAL_GATHER_DISTANCE)
+#define SEVAL_GATHER_DISTANCE 16
+#endif // SEVAL_GATHER_DISTANCE
+
+#include "seval.hpp"
+#include "seval_kernels.hpp"
+
+namespace seval {
+
+namespace batch {
+
+namespace internal {
+/**
+ * @brief Calls `fn(row, field, length)` for every field of a delimited buffer.
+ *
+ * A delimiter at the very end of the buffer does not start an extra (empty) field, and when the
+ * delimiter is '\n' a trailing '\r' is stripped from each field so CRLF input behaves like LF input.
+ *
+ * @param data The buffer to split.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param fn The functor to call for each field.
+ *
+ * @return The number of fields.
+ */
+template <typename Fn>
+SEVAL_INLINE size_t for_each_field(const char* data, size_t size, char delimiter, Fn& fn) {
+    size_t row = 0;
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p < end) {
+        const char* next = static_cast<const char*>(memchr(p, delimiter, static_cast<size_t>(end - p)));
+        const char* fieldEnd = next ? next : end;
+        size_t length = static_cast<size_t>(fieldEnd - p);
+
+        if (delimiter == '\n' && length != 0 && p[length - 1] == '\r') {
+            --length;
+        }
+
+        fn(row, p, length);
+        ++row;
+
+        if (!next) break;
+        p = next + 1;
+    }
+    return row;
+}
+
+/**
+ * @brief Field functor that evaluates into a vector and collects the rows of invalid fields.
+ */
+template <typename T>
+struct column_sink {
+    std::vector<T>& values;
+    std::vector<size_t>* errors;
+    size_t errorCount;
+
+    column_sink(std::vector<T>& values_, std::vector<size_t>* errors_) : values(values_), errors(errors_), errorCount(0) {}
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        T value = 0;
+        if (!evaluate_field<T>(field, length, value)) {
+            ++errorCount;
+            if (errors) errors->push_back(row);
+        }
+        values.push_back(value);
+    }
+};
+
+/**
+ * @brief Mixes up to 16 bytes of a field (as two little words plus the length) into a 64-bit hash.
+ */
+SEVAL_INLINE uint64_t hash_key16(uint64_t lo, uint64_t hi, size_t length) {
+    uint64_t h = (lo * 0x9E3779B97F4A7C15ULL) ^ (hi * 0xC2B2AE3D27D4EB4FULL) ^ (static_cast<uint64_t>(length) << 56);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter (default is '\n').
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ *
+ * @return The number of invalid fields.
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_column(const char* data, size_t size, char delimiter, std::vector<T>& values, std::vector<size_t>* errors = NULL) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN, size);
+    internal::column_sink<T> sink(values, errors);
+    internal::for_each_field(data, size, delimiter, sink);
+    return sink.errorCount;
+}
+
+/**
+ * @struct field_index
+ * @brief Start offsets of the fields of a delimited buffer, as built by `index_fields`.
+ *
+ * Field `k` spans `[begin(k), begin(k) + length(k))`. The last offset is a sentinel placed one past
+ * the (real or implied) delimiter that ends the last field, so every field is handled the same way.
+ */
+struct field_index {
+    std::vector<size_t> offsets; /**< `size() + 1` entries: the start of every field plus the sentinel. */
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }          /**< Number of fields. */
+    size_t begin(size_t k) const { return offsets[k]; }                                 /**< Offset of field `k`. */
+    size_t length(size_t k) const { return offsets[k + 1] - offsets[k] - 1; }           /**< Length of field `k`, delimiter excluded. */
+};
+
+/**
+ * @brief Records the start offset of every field of a delimited buffer.
+ *
+ * Scans 16 bytes per step with SSE2 compares where available and falls back to `memchr` otherwise.
+ * Field boundaries follow `parse_column`: a delimiter at the very end does not start an extra field.
+ * Unlike `parse_column`, trailing '\r' characters are kept; callers strip them when needed.
+ *
+ * @param data The buffer to index.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param index Receives the offsets (previous contents are discarded).
+ *
+ * @return The number of fields.
+ */
+SEVAL_INLINE size_t index_fields(const char* data, size_t size, char delimiter, field_index& index) {
+    std::vector<size_t>& offsets = index.offsets;
+    offsets.clear();
+    SEVAL_TRACE_CALL(KERNEL_INDEX_FIELDS, size);
+    SEVAL_STAT(INDEX_CALLS);
+    SEVAL_STAT_ADD(INDEX_BYTES, size);
+    if (size == 0) return 0;
+
+    offsets.reserve(size / 8 + 2);
+    offsets.push_back(0);
+
+    size_t i = 0;
+#if defined(SEVAL_BATCH_SSE2)
+    const __m128i needle = _mm_set1_epi8(delimiter);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        while (mask) {
+            offsets.push_back(i + kernels::internal::ctz32_(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    SEVAL_STAT_ADD(INDEX_SIMD_BYTES, i);
+    SEVAL_STAT_ADD(INDEX_SCALAR_BYTES, size - i);
+    while (i < size) {
+        const char* next = static_cast<const char*>(memchr(data + i, delimiter, size - i));
+        if (!next) break;
+        i = static_cast<size_t>(next - data) + 1;
+        offsets.push_back(i);
+    }
+
+    if (offsets.back() != size) {
+        offsets.push_back(size + 1); /* implied delimiter after the last field */
+    }
+    return offsets.size() - 1;
+}
+
+/**
+ * @struct dictionary_options
+ * @brief Tuning knobs of `dictionary_cache`.
+ */
+struct dictionary_options {
+    size_t capacity;      /**< Number of hash slots, rounded up to a power of two (default 256). */
+    size_t sampleSize;    /**< Lookups per window after which the hit rate is judged (default 1024). */
+    double minHitRate;    /**< The cache disables itself when a window's hit rate is below this (default 0.5). */
+
+    dictionary_options() : capacity(256), sampleSize(1024), minHitRate(0.5) {}
+};
+
+/**
+ * @class dictionary_cache
+ * @brief Small hash cache from the raw bytes of short fields (up to 16 bytes) to their evaluated value.
+ *
+ * Meant for low-cardinality columns (status codes, enum-like floats, prices on a tick grid): a hit
+ * skips the conversion entirely. Every distinct valid spelling that gets cached is assigned a dense
+ * dictionary code in insertion order, so a column can also be emitted dictionary-encoded.
+ *
+ * The hit rate is checked after every `sampleSize` lookups; when it drops below `minHitRate` the
+ * cache disables itself for good and every further lookup evaluates the field directly, so
+ * high-cardinality columns pay for at most one window of hashing.
+ */
+template <typename T>
+class dictionary_cache {
+public:
+    static const uint32_t no_code = 0xFFFFFFFFu; /**< Code of fields that are invalid or not cached. */
+    static const size_t max_key_length = 16;     /**< Longer fields bypass the cache. */
+
+    explicit dictionary_cache(const dictionary_options& options = dictionary_options())
+        : options_(options), mask_(0), used_(0), lookups_(0), hits_(0), windowLookups_(0), windowHits_(0), enabled_(true) {
+        size_t capacity = 16;
+        while (capacity < options_.capacity) capacity <<= 1;
+        slots_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    /**
+     * @brief Evaluates a field, going through the cache when it is enabled.
+     *
+     * @param field The start of the field.
+     * @param length The length of the field.
+     * @param value Receives the evaluated value (0 if the field is invalid).
+     * @param code Receives the dictionary code of the field, or `no_code`.
+     *
+     * @return `true` if the field is a valid literal, otherwise `false`.
+     */
+    SEVAL_INLINE bool lookup(const char* field, size_t length, T& value, uint32_t& code) {
+        code = no_code;
+        value = 0;
+        SEVAL_STAT(DICTIONARY_LOOKUPS);
+
+        if (!enabled_ || length > max_key_length || length == 0) {
+            SEVAL_STAT(DICTIONARY_BYPASSES);
+            return evaluate_field<T>(field, length, value);
+        }
+
+        uint64_t key[2] = { 0, 0 };
+        memcpy(key, field, length);
+
+        ++lookups_;
+        ++windowLookups_;
+
+        size_t index = static_cast<size_t>(internal::hash_key16(key[0], key[1], length)) & mask_;
+        for (size_t probe = 0; probe < max_probes; ++probe, index = (index + 1) & mask_) {
+            slot& s = slots_[index];
+            if (s.length == 0) {
+                SEVAL_STAT(DICTIONARY_MISSES);
+                return insert(s, key, field, length, value, code);
+            }
+            if (s.length == length && s.lo == key[0] && s.hi == key[1]) {
+                SEVAL_STAT(DICTIONARY_HITS);
+                ++hits_;
+                ++windowHits_;
+                tick();
+                code = s.code;
+                if (s.code == no_code) return false;
+                value = values_[s.code];
+                return true;
+            }
+        }
+
+        SEVAL_STAT(DICTIONARY_MISSES);
+        tick();
+        return evaluate_field<T>(field, length, value);
+    }
+
+    bool enabled() const { return enabled_; }            /**< Whether the cache is still in use. */
+    size_t lookups() const { return lookups_; }          /**< Lookups that went through the cache. */
+    size_t hits() const { return hits_; }                /**< Lookups answered from the cache. */
+    const std::vector<T>& values() const { return values_; } /**< Dictionary: value of each code. */
+
+private:
+    static const size_t max_probes = 8;
+
+    struct slot {
+        uint64_t lo;
+        uint64_t hi;
+        uint32_t length; /* 0 marks an empty slot; empty fields are never cached */
+        uint32_t code;   /* no_code for cached invalid fields */
+
+        slot() : lo(0), hi(0), length(0), code(no_code) {}
+    };
+
+    SEVAL_INLINE bool insert(slot& s, const uint64_t* key, const char* field, size_t length, T& value, uint32_t& code) {
+        bool valid = evaluate_field<T>(field, length, value);
+        tick();
+
+        if (used_ * 4 >= slots_.size() * 3) return valid; /* keep probe chains short: stop filling at 75% */
+
+        s.lo = key[0];
+        s.hi = key[1];
+        s.length = static_cast<uint32_t>(length);
+        if (valid) {
+            s.code = static_cast<uint32_t>(values_.size());
+            values_.push_back(value);
+            code = s.code;
+        }
+        ++used_;
+        return valid;
+    }
+
+    SEVAL_INLINE void tick() {
+        if (windowLookups_ < options_.sampleSize) return;
+        if (static_cast<double>(windowHits_) < options_.minHitRate * static_cast<double>(windowLookups_)) {
+            SEVAL_STAT(DICTIONARY_DISABLES);
+            enabled_ = false;
+        }
+        windowLookups_ = 0;
+        windowHits_ = 0;
+    }
+
+    dictionary_options options_;
+    std::vector<slot> slots_;
+    std::vector<T> values_;
+    size_t mask_;
+    size_t used_;
+    size_t lookups_;
+    size_t hits_;
+    size_t windowLookups_;
+    size_t windowHits_;
+    bool enabled_;
+};
+
+template <typename T> const uint32_t dictionary_cache<T>::no_code;
+template <typename T> const size_t dictionary_cache<T>::max_key_length;
+template <typename T> const size_t dictionary_cache<T>::max_probes;
+
+/**
+ * @struct dictionary_result
+ * @brief Outcome of `parse_column_dictionary`.
+ */
+template <typename T>
+struct dictionary_result {
+    size_t errors;          /**< Number of invalid fields. */
+    size_t lookups;         /**< Lookups that went through the cache. */
+    size_t hits;            /**< Lookups answered from the cache. */
+    bool encoded;           /**< `true` if every valid field received a dictionary code. */
+    std::vector<T> dictionary; /**< Value of each dictionary code. */
+
+    dictionary_result() : errors(0), lookups(0), hits(0), encoded(true) {}
+};
+
+namespace internal {
+template <typename T>
+struct dictionary_sink {
+    dictionary_cache<T>& cache;
+    std::vector<T>& values;
+    std::vector<size_t>* errors;
+    std::vector<uint32_t>* codes;
+    size_t errorCount;
+    bool encoded;
+
+    dictionary_sink(dictionary_cache<T>& cache_, std::vector<T>& values_, std::vector<size_t>* errors_, std::vector<uint32_t>* codes_)
+        : cache(cache_), values(values_), errors(errors_), codes(codes_), errorCount(0), encoded(true) {}
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        T value = 0;
+        uint32_t code = dictionary_cache<T>::no_code;
+        bool valid = cache.lookup(field, length, value, code);
+
+        if (!valid) {
+            ++errorCount;
+            if (errors) errors->push_back(row);
+        } else if (code == dictionary_cache<T>::no_code) {
+            encoded = false;
+        }
+        values.push_back(value);
+        if (codes) codes->push_back(code);
+    }
+};
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer through a `dictionary_cache`.
+ *
+ * Produces the same `values` and `errors` as `parse_column`. When `codes` is not `NULL` it receives
+ * the dictionary code of every field (`dictionary_cache<T>::no_code` for invalid fields); the codes
+ * are only a complete encoding of the column if the returned `encoded` flag is set, i.e. the cache
+ * stayed enabled and had room for every distinct value.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ * @param codes If not `NULL`, receives one dictionary code per field.
+ * @param options Cache size and adaptive-disable thresholds.
+ *
+ * @return Error count, cache statistics and the dictionary.
+ */
+template <typename T>
+SEVAL_INLINE dictionary_result<T> parse_column_dictionary(const char* data, size_t size, char delimiter, std::vector<T>& values,
+                                                          std::vector<size_t>* errors = NULL, std::vector<uint32_t>* codes = NULL,
+                                                          const dictionary_options& options = dictionary_options()) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_DICTIONARY, size);
+    dictionary_cache<T> cache(options);
+    internal::dictionary_sink<T> sink(cache, values, errors, codes);
+    internal::for_each_field(data, size, delimiter, sink);
+
+    dictionary_result<T> result;
+    result.errors = sink.errorCount;
+    result.lookups = cache.lookups();
+    result.hits = cache.hits();
+    result.encoded = sink.encoded && cache.enabled();
+    result.dictionary = cache.values();
+    return result;
+}
+
+/**
+ * @struct zone
+ * @brief Statistics of one block of rows, gathered while the block is parsed (a zone map entry).
+ *
+ * Invalid and empty fields count as nulls and do not take part in `min`, `max` or the sortedness flags.
+ */
+template <typename T>
+struct zone {
+    size_t firstRow;   /**< Row index of the first row in the block. */
+    size_t rows;       /**< Number of rows in the block. */
+    size_t nullCount;  /**< Number of invalid or empty fields in the block. */
+    T min;             /**< Smallest valid value (meaningless if `!hasValues()`). */
+    T max;             /**< Largest valid value (meaningless if `!hasValues()`). */
+    bool ascending;    /**< Valid values are non-decreasing. */
+    bool descending;   /**< Valid values are non-increasing. */
+
+    zone() : firstRow(0), rows(0), nullCount(0), min(0), max(0), ascending(true), descending(true) {}
+
+    /** @brief Whether the block has at least one valid value. */
+    bool hasValues() const { return nullCount < rows; }
+
+    /**
+     * @brief Whether the block may hold a value in the closed range [lo, hi].
+     * @return `false` only if the block can be skipped for that range.
+     */
+    bool mayContain(T lo, T hi) const { return hasValues() && !(max < lo || hi < min); }
+};
+
+namespace internal {
+template <typename T>
+struct zone_sink {
+    column_sink<T> column;
+    std::vector<zone<T> >& zones;
+    size_t blockRows;
+    zone<T>* current;
+    T previous;
+
+    zone_sink(std::vector<T>& values_, std::vector<size_t>* errors_, std::vector<zone<T> >& zones_, size_t blockRows_)
+        : column(values_, errors_), zones(zones_), blockRows(blockRows_ ? blockRows_ : 1), current(NULL), previous(0) {}
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        if (row % blockRows == 0) {
+            zones.push_back(zone<T>());
+            current = &zones.back();
+            current->firstRow = row;
+        }
+        ++current->rows;
+
+        T value = 0;
+        if (!evaluate_field<T>(field, length, value)) {
+            ++column.errorCount;
+            ++current->nullCount;
+            if (column.errors) column.errors->push_back(row);
+        } else if (current->rows - current->nullCount == 1) {
+            current->min = current->max = previous = value;
+        } else {
+            if (value < current->min) current->min = value;
+            if (current->max < value) current->max = value;
+            current->ascending = current->ascending && !(value < previous);
+            current->descending = current->descending && !(previous < value);
+            previous = value;
+        }
+        column.values.push_back(value);
+    }
+};
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer and builds a zone map alongside.
+ *
+ * Produces the same `values` and `errors` as `parse_column`, plus one `zone` per block of
+ * `blockRows` rows, computed in the same pass as the conversion so no second scan over the
+ * parsed values is needed. Later range queries can skip blocks for which `mayContain` is `false`.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ * @param zones Receives the statistics of every block.
+ * @param blockRows The number of rows per block (default is 65536).
+ *
+ * @return The number of invalid fields.
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_column_zones(const char* data, size_t size, char delimiter, std::vector<T>& values, std::vector<size_t>* errors,
+                                       std::vector<zone<T> >& zones, size_t blockRows = 65536) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_ZONES, size);
+    internal::zone_sink<T> sink(values, errors, zones, blockRows);
+    internal::for_each_field(data, size, delimiter, sink);
+    return sink.column.errorCount;
+}
+
+/**
+ * @struct length_histogram
+ * @brief Shape of a sample of fields: how many digits the plain ones have, and how many are not plain.
+ *
+ * A plain field is an optionally signed run of 1 to `kernels::max_digits` decimal digits, the only
+ * shape the specialized kernels convert themselves.
+ */
+struct length_histogram {
+    size_t digits[kernels::max_digits + 1]; /**< Plain fields by digit count (`digits[0]` is unused). */
+    size_t other;                           /**< Fields of any other shape. */
+    size_t total;                           /**< All fields. */
+
+    length_histogram() { clear(); }
+
+    void clear() {
+        for (size_t n = 0; n <= kernels::max_digits; ++n) digits[n] = 0;
+        other = 0;
+        total = 0;
+    }
+
+    /** @brief Classifies one field as `kernels::parse_field` sees it under the `trim` options. */
+    void add(const char* field, size_t length, unsigned trim = kernels::TRIM_NONE) {
+        ++total;
+        size_t s = kernels::trim_field(field, length, trim);
+        size_t n = length - s;
+        if (n == 0 || n > kernels::max_digits) {
+            ++other;
+            return;
+        }
+        for (size_t k = s; k < length; ++k) {
+            if (!seval::internal::is_decimal_ch(field[k])) {
+                ++other;
+                return;
+            }
+        }
+        ++digits[n];
+    }
+};
+
+/**
+ * @brief Estimated cost of converting one plain field of `n` digits with a kernel.
+ *
+ * The unit is about a nanosecond on a 3 GHz x86 core, fitted to fixed-length and mixed-length
+ * columns. `mispredict` is the share of fields whose length differs from the commonest one: the
+ * per-digit loops pay a branch miss for those, the word-at-a-time kernels much less.
+ */
+SEVAL_INLINE double kernel_cost(kernels::kernel_kind kind, size_t n, double mispredict) {
+    double digits = static_cast<double>(n);
+    switch (kind) {
+    case kernels::KERNEL_LENGTH_SWITCH: return 4.0 + 1.9 * digits + 20.0 * mispredict;
+    case kernels::KERNEL_SWAR8: return 4.0 + 5.5 * static_cast<double>((n + 7) / 8) + 10.0 * mispredict;
+    case kernels::KERNEL_SIMD16: return 10.3 + (n > 16 ? 1.5 * (digits - 16.0) : 0.0) + 6.0 * mispredict;
+    default: return 2.5 + 1.6 * digits + 15.0 * mispredict;
+    }
+}
+
+/**
+ * @brief Picks the available kernel with the lowest estimated cost over a histogram.
+ *
+ * Fields that are not plain cost the same under every kernel (they go to `evaluate_field`), so only
+ * plain ones are weighed; a sample without any picks `KERNEL_SCALAR`, whose fast path is shortest.
+ */
+SEVAL_INLINE kernels::kernel_kind choose_kernel(const length_histogram& h) {
+    size_t plain = h.total - h.other, mode = 0;
+    for (size_t n = 1; n <= kernels::max_digits; ++n) {
+        if (h.digits[n] > mode) mode = h.digits[n];
+    }
+    if (plain == 0) return kernels::KERNEL_SCALAR;
+    double mispredict = 1.0 - static_cast<double>(mode) / static_cast<double>(plain);
+
+    kernels::kernel_kind best = kernels::KERNEL_SCALAR;
+    double bestCost = 0;
+    for (int k = 0; k < kernels::KERNEL_KIND_COUNT; ++k) {
+        kernels::kernel_kind kind = static_cast<kernels::kernel_kind>(k);
+        if (!kernels::available(kind)) continue;
+        double cost = 0;
+        for (size_t n = 1; n <= kernels::max_digits; ++n) {
+            cost += static_cast<double>(h.digits[n]) * kernel_cost(kind, n, mispredict);
+        }
+        if (k == 0 || cost < bestCost) {
+            best = kind;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+/**
+ * @struct adaptive_options
+ * @brief Sampling knobs of `parse_column_adaptive`.
+ */
+struct adaptive_options {
+    size_t sampleSize;       /**< Fields per sample (default 256). */
+    size_t resampleInterval; /**< Fields from the start of one sample to the next; 0 samples only once (default 65536). */
+    unsigned trim;           /**< `kernels::trim_option` flags applied to every field (default `TRIM_NONE`). */
+
+    adaptive_options() : sampleSize(256), resampleInterval(65536), trim(kernels::TRIM_NONE) {}
+};
+
+/**
+ * @struct adaptive_result
+ * @brief Outcome of `parse_column_adaptive`.
+ */
+struct adaptive_result {
+    size_t rows;                               /**< Number of fields. */
+    size_t errors;                             /**< Number of invalid fields. */
+    size_t samples;                            /**< Samples taken (kernel decisions made). */
+    size_t fields[kernels::KERNEL_KIND_COUNT]; /**< Fields converted under each kernel. */
+    kernels::kernel_kind kernel;               /**< The kernel in use at the end. */
+
+    adaptive_result() : rows(0), errors(0), samples(0), kernel(kernels::KERNEL_SCALAR) {
+        for (int k = 0; k < kernels::KERNEL_KIND_COUNT; ++k) fields[k] = 0;
+    }
+};
+
+namespace internal {
+template <typename T>
+struct adaptive_sink {
+    const char* data;
+    std::vector<T>& values;
+    std::vector<size_t>* errors;
+    adaptive_options options;
+    length_histogram sample;
+    adaptive_result result;
+
+    adaptive_sink(const char* data_, std::vector<T>& values_, std::vector<size_t>* errors_, const adaptive_options& options_)
+        : data(data_), values(values_), errors(errors_), options(options_) {
+        /* until the first sample is in, the kernel least hurt by mixed lengths */
+        result.kernel = kernels::available(kernels::KERNEL_SIMD16) ? kernels::KERNEL_SIMD16 :
+                        kernels::available(kernels::KERNEL_SWAR8) ? kernels::KERNEL_SWAR8 : kernels::KERNEL_SCALAR;
+        if (options.sampleSize == 0) options.sampleSize = 1;
+    }
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        size_t phase = options.resampleInterval ? row % options.resampleInterval : row;
+        if (phase < options.sampleSize) {
+            sample.add(field, length, options.trim);
+            if (phase + 1 == options.sampleSize) {
+                result.kernel = choose_kernel(sample);
+                ++result.samples;
+                SEVAL_STAT(ADAPTIVE_SAMPLES);
+                sample.clear();
+            }
+        }
+
+        T value = 0;
+        if (!kernels::parse_field<T>(result.kernel, field, length, static_cast<size_t>(field - data), value, options.trim)) {
+            ++result.errors;
+            if (errors) errors->push_back(row);
+        }
+        ++result.rows;
+        ++result.fields[result.kernel];
+        values.push_back(value);
+    }
+};
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer, choosing the conversion kernel from the data.
+ *
+ * The first `sampleSize` fields (and as many again every `resampleInterval` fields) are classified
+ * into a `length_histogram`, and `choose_kernel` picks the kernel for the fields that follow, so
+ * a column of short codes, one of 19-digit ids and one of decimals each get the kernel that suits
+ * them. Produces the same `values` and `errors` as `parse_column`, except that `options.trim`
+ * may accept fields with leading whitespace.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ * @param options Sample size and interval, and what to trim in front of the digits.
+ *
+ * @return Error count, the kernels used and the number of samples.
+ */
+template <typename T>
+SEVAL_INLINE adaptive_result parse_column_adaptive(const char* data, size_t size, char delimiter, std::vector<T>& values,
+                                                   std::vector<size_t>* errors = NULL, const adaptive_options& options = adaptive_options()) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_ADAPTIVE, size);
+    SEVAL_STAT(ADAPTIVE_CALLS);
+    internal::adaptive_sink<T> sink(data, values, errors, options);
+    internal::for_each_field(data, size, delimiter, sink);
+    SEVAL_STAT_ADD(ADAPTIVE_FIELDS, sink.result.rows);
+    SEVAL_STAT_ADD(ADAPTIVE_SCALAR, sink.result.fields[kernels::KERNEL_SCALAR]);
+    SEVAL_STAT_ADD(ADAPTIVE_LENGTH_SWITCH, sink.result.fields[kernels::KERNEL_LENGTH_SWITCH]);
+    SEVAL_STAT_ADD(ADAPTIVE_SWAR8, sink.result.fields[kernels::KERNEL_SWAR8]);
+    SEVAL_STAT_ADD(ADAPTIVE_SIMD16, sink.result.fields[kernels::KERNEL_SIMD16]);
+    return sink.result;
+}
+
+namespace internal {
+/**
+ * @brief Converts the fields of one length bucket: each is an optional sign and exactly `N` bytes
+ *        that should be digits. Fields that turn out not to be go to `failed`.
+ */
+template <typename T, size_t N>
+SEVAL_INLINE void convert_bucket(const char* const* fields, const uint16_t* slots, size_t count, T* out, std::vector<uint16_t>& failed) {
+    for (size_t k = 0; k < count; ++k) {
+        uint16_t slot = slots[k];
+        const char* p = fields[slot];
+        size_t s = (p[0] == '-') | (p[0] == '+');
+        uint64_t magnitude = 0;
+        if (!kernels::internal::fixed_words<N>(p + s, magnitude) ||
+            !kernels::signed_value<T>(magnitude, p[0] == '-' ? seval::internal::SIGN_NEGATIVE : seval::internal::SIGN_POSITIVE, out[slot])) {
+            failed.push_back(slot);
+        }
+    }
+}
+
+template <typename T>
+SEVAL_INLINE void convert_bucket(size_t n, const char* const* fields, const uint16_t* slots, size_t count, T* out, std::vector<uint16_t>& failed) {
+    switch (n) {
+    case 1: convert_bucket<T, 1>(fields, slots, count, out, failed); break;
+    case 2: convert_bucket<T, 2>(fields, slots, count, out, failed); break;
+    case 3: convert_bucket<T, 3>(fields, slots, count, out, failed); break;
+    case 4: convert_bucket<T, 4>(fields, slots, count, out, failed); break;
+    case 5: convert_bucket<T, 5>(fields, slots, count, out, failed); break;
+    case 6: convert_bucket<T, 6>(fields, slots, count, out, failed); break;
+    case 7: convert_bucket<T, 7>(fields, slots, count, out, failed); break;
+    case 8: convert_bucket<T, 8>(fields, slots, count, out, failed); break;
+    case 9: convert_bucket<T, 9>(fields, slots, count, out, failed); break;
+    case 10: convert_bucket<T, 10>(fields, slots, count, out, failed); break;
+    case 11: convert_bucket<T, 11>(fields, slots, count, out, failed); break;
+    case 12: convert_bucket<T, 12>(fields, slots, count, out, failed); break;
+    case 13: convert_bucket<T, 13>(fields, slots, count, out, failed); break;
+    case 14: convert_bucket<T, 14>(fields, slots, count, out, failed); break;
+    case 15: convert_bucket<T, 15>(fields, slots, count, out, failed); break;
+    case 16: convert_bucket<T, 16>(fields, slots, count, out, failed); break;
+    case 17: convert_bucket<T, 17>(fields, slots, count, out, failed); break;
+    case 18: convert_bucket<T, 18>(fields, slots, count, out, failed); break;
+    case 19: convert_bucket<T, 19>(fields, slots, count, out, failed); break;
+    default: failed.insert(failed.end(), slots, slots + count); break;
+    }
+}
+
+/**
+ * @brief Field functor that gathers a block of fields, then converts it bucket by bucket.
+ */
+template <typename T>
+struct bucket_sink {
+    enum { block = 1024 };
+
+    std::vector<T>& values;
+    std::vector<size_t>* errors;
+    size_t errorCount;
+    size_t rows;         /* fields flushed so far */
+    size_t plain;        /* ... of them converted in a bucket */
+    size_t first;        /* row of the first field of the block */
+    size_t count;        /* fields in the block */
+    std::vector<const char*> fields;
+    std::vector<size_t> lengths;
+    std::vector<unsigned char> buckets;
+    std::vector<uint16_t> slots;
+    std::vector<uint16_t> failed;
+
+    bucket_sink(std::vector<T>& values_, std::vector<size_t>* errors_)
+        : values(values_), errors(errors_), errorCount(0), rows(0), plain(0), first(0), count(0),
+          fields(block), lengths(block), buckets(block), slots(block) {
+        failed.reserve(block);
+    }
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        if (count == 0) first = row;
+        fields[count] = field;
+        lengths[count] = length;
+        if (++count == block) flush();
+    }
+
+    /* buckets the block by digit count (0 for the fields evaluate_field takes), converts every
+       bucket with its own kernel, then evaluates the leftovers in row order */
+    void flush() {
+        if (count == 0) return;
+        const size_t limit = kernels::exact_digits<T>();
+        size_t starts[kernels::max_digits + 2] = { 0 };
+        for (size_t k = 0; k < count; ++k) {
+            const char* p = fields[k];
+            size_t length = lengths[k];
+            size_t n = length - (length != 0 && (p[0] == '-' || p[0] == '+') ? 1 : 0);
+            size_t b = n != 0 && n <= limit ? n : 0;
+            buckets[k] = static_cast<unsigned char>(b);
+            ++starts[b + 1];
+        }
+        for (size_t b = 1; b <= kernels::max_digits + 1; ++b) starts[b] += starts[b - 1];
+        size_t next[kernels::max_digits + 1];
+        for (size_t b = 0; b <= kernels::max_digits; ++b) next[b] = starts[b];
+        for (size_t k = 0; k < count; ++k) slots[next[buckets[k]]++] = static_cast<uint16_t>(k);
+
+        size_t base = values.size();
+        values.resize(base + count, T(0));
+        T* out = &values[base];
+        failed.assign(slots.begin(), slots.begin() + static_cast<std::ptrdiff_t>(starts[1]));
+        for (size_t n = 1; n <= kernels::max_digits; ++n) {
+            if (starts[n + 1] != starts[n]) convert_bucket<T>(n, &fields[0], &slots[starts[n]], starts[n + 1] - starts[n], out, failed);
+        }
+        rows += count;
+        plain += count - failed.size();
+
+        std::sort(failed.begin(), failed.end());
+        for (size_t k = 0; k < failed.size(); ++k) {
+            uint16_t slot = failed[k];
+            T value = 0;
+            if (!evaluate_field<T>(fields[slot], lengths[slot], value)) {
+                ++errorCount;
+                if (errors) errors->push_back(first + slot);
+            }
+            out[slot] = value;
+        }
+        count = 0;
+    }
+};
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer, converting fields of equal length together.
+ *
+ * Fields are split off as in `parse_column` and gathered in blocks of 1024. Each optionally signed
+ * run of `n` digits (up to `kernels::exact_digits<T>()`) in a block goes into bucket `n`, every
+ * bucket is converted in one pass by the straight-line kernel for `n` digits, and the values are
+ * scattered back to their rows. Columns that mix lengths at random (say 1-digit and 19-digit ids)
+ * thus take one predictable branch per bucket instead of a mispredicted one per field. Other
+ * fields go to `evaluate_field`. Produces the same `values` and `errors` as `parse_column`.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ *
+ * @return The number of invalid fields.
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_column_bucketed(const char* data, size_t size, char delimiter, std::vector<T>& values,
+                                          std::vector<size_t>* errors = NULL) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_BUCKETED, size);
+    SEVAL_STAT(BUCKETED_CALLS);
+    internal::bucket_sink<T> sink(values, errors);
+    internal::for_each_field(data, size, delimiter, sink);
+    sink.flush();
+    SEVAL_STAT_ADD(BUCKETED_FIELDS, sink.rows);
+    SEVAL_STAT_ADD(BUCKETED_PLAIN, sink.plain);
+    SEVAL_STAT_ADD(BUCKETED_FALLBACK, sink.rows - sink.plain);
+    return sink.errorCount;
+}
+
+namespace internal {
+/**
+ * @brief Field functor that gathers `W` fields at a time and converts their digit runs in lockstep.
+ */
+template <typename T, size_t W>
+struct interleave_sink {
+    std::vector<T>& values;
+    std::vector<size_t>* errors;
+    size_t errorCount;
+    size_t rows;   /* fields flushed so far */
+    size_t plain;  /* ... of them converted in lockstep */
+    size_t first;  /* row of the first gathered field */
+    size_t count;  /* fields gathered */
+    const char* fields[W];
+    size_t lengths[W];
+
+    interleave_sink(std::vector<T>& values_, std::vector<size_t>* errors_)
+        : values(values_), errors(errors_), errorCount(0), rows(0), plain(0), first(0), count(0) {}
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        if (count == 0) first = row;
+        fields[count] = field;
+        lengths[count] = length;
+        if (++count == W) flush();
+    }
+
+    /* the digit runs go through parse_digits_interleaved, everything else through evaluate_field */
+    void flush() {
+        if (count == 0) return;
+        const size_t limit = kernels::exact_digits<T>();
+        const char* digits[W];
+        size_t n[W];
+        uint64_t magnitude[W];
+        for (size_t i = 0; i < W; ++i) {
+            size_t s = i < count && lengths[i] != 0 && (fields[i][0] == '-' || fields[i][0] == '+') ? 1 : 0;
+            digits[i] = i < count ? fields[i] + s : NULL;
+            n[i] = i < count && lengths[i] - s <= limit ? lengths[i] - s : 0;
+        }
+        uint32_t valid = kernels::parse_digits_interleaved<W>(digits, n, magnitude);
+
+        for (size_t i = 0; i < count; ++i) {
+            T value = 0;
+            if ((valid & (1u << i)) &&
+                kernels::signed_value<T>(magnitude[i], fields[i][0] == '-' ? seval::internal::SIGN_NEGATIVE : seval::internal::SIGN_POSITIVE, value)) {
+                ++plain;
+            } else if (!evaluate_field<T>(fields[i], lengths[i], value)) {
+                ++errorCount;
+                if (errors) errors->push_back(first + i);
+            }
+            values.push_back(value);
+        }
+        rows += count;
+        count = 0;
+    }
+
+private:
+    interleave_sink(const interleave_sink&);
+    interleave_sink& operator=(const interleave_sink&);
+};
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer, converting `W` neighbouring fields at once.
+ *
+ * The digit loop of a single field is one long dependency chain (each step multiplies the previous
+ * value by 10). Here `W` consecutive fields advance in lockstep with their own accumulators (see
+ * `kernels::parse_digits_interleaved`), so the core overlaps their chains. Needs neither SWAR nor
+ * SIMD and makes no assumption about field lengths; optionally signed digit runs (up to
+ * `kernels::exact_digits<T>()`) take the lockstep path, other fields go to `evaluate_field`.
+ * Produces the same `values` and `errors` as `parse_column`.
+ *
+ * @tparam W Fields in flight, 2 to 32; 4 suits most cores, 8 those with many registers.
+ *
+ * @param data The buffer holding the column.
+ * @param size The size of the buffer in bytes.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ *
+ * @return The number of invalid fields.
+ *
+ * @throws _StatAssert If `W` is not between 2 and 32.
+ */
+template <typename T, size_t W>
+SEVAL_INLINE size_t parse_column_interleaved(const char* data, size_t size, char delimiter, std::vector<T>& values,
+                                             std::vector<size_t>* errors = NULL) {
+    _StatAssert(W >= 2 && W <= 32, "Template parameter W must be between 2 and 32: one field is not interleaved, the mask holds 32.");
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_INTERLEAVED, size);
+    SEVAL_STAT(INTERLEAVED_CALLS);
+    internal::interleave_sink<T, W> sink(values, errors);
+    internal::for_each_field(data, size, delimiter, sink);
+    sink.flush();
+    SEVAL_STAT_ADD(INTERLEAVED_FIELDS, sink.rows);
+    SEVAL_STAT_ADD(INTERLEAVED_PLAIN, sink.plain);
+    SEVAL_STAT_ADD(INTERLEAVED_FALLBACK, sink.rows - sink.plain);
+    return sink.errorCount;
+}
+
+/**
+ * @brief `parse_column_interleaved` with 4 fields in flight.
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_column_interleaved(const char* data, size_t size, char delimiter, std::vector<T>& values,
+                                             std::vector<size_t>* errors = NULL) {
+    return parse_column_interleaved<T, 4>(data, size, delimiter, values, errors);
+}
+
+/**
+ * @class padded_buffer
+ * @brief A byte buffer followed by `kernels::padding` zero bytes, the input `parse_column_padded`
+ *        requires.
+ */
+class padded_buffer {
+public:
+    padded_buffer() : data_(NULL), size_(0) {}
+    ~padded_buffer() { free(data_); }
+
+    /**
+     * @brief Makes room for `size` bytes (with undefined contents) plus the zeroed padding.
+     * @return `false` if the allocation failed; the buffer is then empty.
+     */
+    bool allocate(size_t size) {
+        free(data_);
+        size_ = 0;
+        data_ = static_cast<char*>(malloc(size + kernels::padding));
+        if (!data_) return false;
+        memset(data_ + size, 0, kernels::padding);
+        size_ = size;
+        return true;
+    }
+
+    /**
+     * @brief Replaces the contents with a copy of `size` bytes.
+     * @return `false` if the allocation failed; the buffer is then empty.
+     */
+    bool assign(const char* data, size_t size) {
+        if (!allocate(size)) return false;
+        if (size != 0) memcpy(data_, data, size);
+        return true;
+    }
+
+    char* data() { return data_; }                /**< The bytes; `NULL` before the first allocation. */
+    const char* data() const { return data_; }    /**< Same. */
+    size_t size() const { return size_; }         /**< Number of bytes, padding excluded. */
+
+private:
+    padded_buffer(const padded_buffer&);
+    padded_buffer& operator=(const padded_buffer&);
+
+    char* data_;
+    size_t size_;
+};
+
+namespace internal {
+/**
+ * @brief Field functor for `parse_column_padded` (`Padded`) and `parse_column_page_safe`.
+ */
+template <typename T, bool Padded>
+struct padded_sink {
+    std::vector<T>& values;
+    std::vector<size_t>* errors;
+    size_t errorCount;
+    size_t first; /* size of `values` before the column */
+
+    padded_sink(std::vector<T>& values_, std::vector<size_t>* errors_)
+        : values(values_), errors(errors_), errorCount(0), first(values_.size()) {}
+
+    SEVAL_INLINE void operator()(size_t row, const char* field, size_t length) {
+        T value = 0;
+        bool ok = Padded ? kernels::parse_field_padded<T>(field, length, value) : kernels::parse_field_page_safe<T>(field, length, value);
+        if (!ok) {
+            ++errorCount;
+            if (errors) errors->push_back(row);
+        }
+        values.push_back(value);
+    }
+};
+} /* internal */
+
+/**
+ * @brief Evaluates every field of a delimited buffer that is followed by `kernels::padding`
+ *        readable bytes, such as a `padded_buffer`.
+ *
+ * Digit runs are converted with unconditional 8-byte loads (see `kernels::parse_field_padded`),
+ * skipping the checks that keep the other parsers inside the buffer. Produces the same `values`
+ * and `errors` as `parse_column`.
+ *
+ * @param data The buffer holding the column; `data[size]` to `data[size + kernels::padding - 1]`
+ *        must be readable.
+ * @param size The size of the buffer in bytes, padding excluded.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ *
+ * @return The number of invalid fields.
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_column_padded(const char* data, size_t size, char delimiter, std::vector<T>& values, std::vector<size_t>* errors = NULL) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_PADDED, size);
+    SEVAL_STAT(PADDED_CALLS);
+    internal::padded_sink<T, true> sink(values, errors);
+    internal::for_each_field(data, size, delimiter, sink);
+    SEVAL_STAT_ADD(PADDED_FIELDS, values.size() - sink.first);
+    return sink.errorCount;
+}
+
+/**
+ * @brief `parse_column_padded` for a buffer without padding: the loads past the end of the buffer
+ *        stay within its last page, and fields too close to the end of a page are loaded byte by byte
+ *        (see `kernels::parse_field_page_safe`).
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_column_page_safe(const char* data, size_t size, char delimiter, std::vector<T>& values, std::vector<size_t>* errors = NULL) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_COLUMN_PAGE_SAFE, size);
+    SEVAL_STAT(PAGE_SAFE_CALLS);
+    internal::padded_sink<T, false> sink(values, errors);
+    internal::for_each_field(data, size, delimiter, sink);
+    SEVAL_STAT_ADD(PAGE_SAFE_FIELDS, values.size() - sink.first);
+    return sink.errorCount;
+}
+
+} /* batch */
+
+/**
+ * @brief Evaluates strings scattered in memory, such as the string column of a row store or the
+ *        tokens of a tokenizer.
+ *
+ * While string `i` is converted, string `i + SEVAL_GATHER_DISTANCE` is prefetched (its first and
+ * last byte), so the cache misses of a pointer chase overlap with useful work instead of stalling
+ * every call. Optionally signed digit runs (up to `kernels::exact_digits<T>()`) are converted by
+ * the kernel for their exact length, which reads nothing outside the string; other strings go to
+ * `evaluate_field`, so every value is the one `evaluate_field` would produce.
+ *
+ * @param ptrs The strings; `ptrs[i]` may be `NULL` when `lens[i]` is 0.
+ * @param lens Their lengths.
+ * @param n The number of strings.
+ * @param out Receives one value per string; invalid strings are stored as 0.
+ * @param errors If not `NULL`, receives the index of every invalid string.
+ *
+ * @return The number of invalid strings.
+ */
+template <typename T>
+SEVAL_INLINE size_t parse_gather(const char* const* ptrs, const size_t* lens, size_t n, T* out, std::vector<size_t>* errors = NULL) {
+    SEVAL_TRACE_CALL(KERNEL_PARSE_GATHER, n);
+    SEVAL_STAT(GATHER_CALLS);
+    const size_t limit = kernels::exact_digits<T>();
+    size_t errorCount = 0, plain = 0;
+
+    for (size_t i = 0; i < n && i < SEVAL_GATHER_DISTANCE; ++i) SEVAL_BATCH_PREFETCH(ptrs[i]);
+    for (size_t i = 0; i < n; ++i) {
+        if (i + SEVAL_GATHER_DISTANCE < n) {
+            const char* ahead = ptrs[i + SEVAL_GATHER_DISTANCE];
+            size_t aheadLength = lens[i + SEVAL_GATHER_DISTANCE];
+            SEVAL_BATCH_PREFETCH(ahead);
+            if (aheadLength > 1) SEVAL_BATCH_PREFETCH(ahead + aheadLength - 1);
+        }
+
+        const char* field = ptrs[i];
+        size_t length = lens[i];
+        size_t s = length != 0 && (field[0] == '-' || field[0] == '+') ? 1 : 0;
+        uint64_t magnitude = 0;
+        if (length - s <= limit && kernels::internal::words_digits(field + s, length - s, magnitude) &&
+            kernels::signed_value<T>(magnitude, s && field[0] == '-' ? seval::internal::SIGN_NEGATIVE : seval::internal::SIGN_POSITIVE, out[i])) {
+            ++plain;
+            continue;
+        }
+        T value = 0;
+        if (!evaluate_field<T>(field, length, value)) {
+            ++errorCount;
+            if (errors) errors->push_back(i);
+        }
+        out[i] = value;
+    }
+    SEVAL_STAT_ADD(GATHER_STRINGS, n);
+    SEVAL_STAT_ADD(GATHER_PLAIN, plain);
+    SEVAL_STAT_ADD(GATHER_FALLBACK, n - plain);
+    return errorCount;
+}
+
+} /* seval */
+
+#endif // SEVAL_BATCH_HPP_LOADED
@@ -0,0 +1,381 @@
+/**
+ * @file seval_cache.hpp
+ * @brief Sharded LRU cache of compiled expressions.
+ *
+ * `expression_cache` maps expression text to its compiled bytecode (see seval_vm.hpp) and, when
+ * asked to, its native code (see seval_jit.hpp), so a service that receives the same formulas over
+ * and over tokenizes, parses and compiles each of them once. Keys are spread over independently
+ * locked shards by hash, each shard evicts its least recently used entry when full, and hits,
+ * misses and evictions are counted per shard.
+ *
+ * Entries are reference counted: a `compiled_expression` handle stays valid after its entry is
+ * evicted and after the cache is destroyed. The counts are atomic in C++11; shard locking uses
+ * `std::mutex` there. Before C++11, POSIX mutexes guard both, and on other pre-C++11 platforms the
+ * cache is not thread-safe.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_CACHE_HPP_LOADED)
+#define SEVAL_CACHE_HPP_LOADED
+
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "seval_vm.hpp"
+#include "seval_jit.hpp"
+
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <mutex>
+#define SEVAL_CACHE_STD_MUTEX 1
+#define SEVAL_CACHE_ATOMIC_REFS 1
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define SEVAL_CACHE_PTHREAD_MUTEX 1
+#endif
+
+namespace seval {
+
+namespace expr {
+
+namespace internal {
+/**
+ * @brief Minimal non-recursive mutex over the best primitive available.
+ */
+class cache_mutex {
+public:
+#if defined(SEVAL_CACHE_STD_MUTEX)
+    cache_mutex() {}
+    void lock() { m_.lock(); }
+    void unlock() { m_.unlock(); }
+#elif defined(SEVAL_CACHE_PTHREAD_MUTEX)
+    cache_mutex() { pthread_mutex_init(&m_, NULL); }
+    ~cache_mutex() { pthread_mutex_destroy(&m_); }
+    void lock() { pthread_mutex_lock(&m_); }
+    void unlock() { pthread_mutex_unlock(&m_); }
+#else
+    cache_mutex() {}
+    void lock() {}
+    void unlock() {}
+#endif
+
+private:
+    cache_mutex(const cache_mutex&);
+    cache_mutex& operator=(const cache_mutex&);
+
+#if defined(SEVAL_CACHE_STD_MUTEX)
+    std::mutex m_;
+#elif defined(SEVAL_CACHE_PTHREAD_MUTEX)
+    pthread_mutex_t m_;
+#endif
+};
+
+class cache_lock {
+public:
+    explicit cache_lock(cache_mutex& m) : m_(m) { m_.lock(); }
+    ~cache_lock() { m_.unlock(); }
+
+private:
+    cache_lock(const cache_lock&);
+    cache_lock& operator=(const cache_lock&);
+
+    cache_mutex& m_;
+};
+
+/**
+ * @brief A cached compilation; owned jointly by its shard and the handles that refer to it.
+ */
+struct cache_entry {
+    std::string text;
+    program bytecode;
+    jit_program native;
+#if defined(SEVAL_CACHE_ATOMIC_REFS)
+    std::atomic<unsigned> refs;
+#else
+    cache_mutex refLock;
+    unsigned refs;
+#endif
+    cache_entry* prev; /* LRU list of the shard, most recent first */
+    cache_entry* next;
+
+    cache_entry() : refs(1), prev(NULL), next(NULL) {}
+
+#if defined(SEVAL_CACHE_ATOMIC_REFS)
+    /* a new reference is always taken from an existing one, so no ordering is needed */
+    void acquire() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    /* the last release must see every write made through the other handles before deleting */
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+#else
+    void acquire() {
+        cache_lock guard(refLock);
+        ++refs;
+    }
+
+    void release() {
+        bool last = false;
+        {
+            cache_lock guard(refLock);
+            last = --refs == 0;
+        }
+        if (last) delete this;
+    }
+#endif
+
+private:
+    cache_entry(const cache_entry&);
+    cache_entry& operator=(const cache_entry&);
+};
+
+/* FNV-1a, used to pick a shard */
+SEVAL_INLINE uint64_t text_hash(const char* text, size_t length) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<uint8_t>(text[i]);
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+} /* internal */
+
+/**
+ * @class compiled_expression
+ * @brief Shared handle to a cached compilation; cheap to copy, immutable, safe to use from any thread.
+ */
+class compiled_expression {
+public:
+    compiled_expression() : entry_(NULL) {}
+    compiled_expression(const compiled_expression& o) : entry_(o.entry_) { if (entry_) entry_->acquire(); }
+    ~compiled_expression() { if (entry_) entry_->release(); }
+
+    compiled_expression& operator=(const compiled_expression& o) {
+        if (o.entry_) o.entry_->acquire();
+        if (entry_) entry_->release();
+        entry_ = o.entry_;
+        return *this;
+    }
+
+    /** @brief Whether the handle refers to a compilation. */
+    bool valid() const { return entry_ != NULL; }
+
+    /** @brief The source text. */
+    const std::string& text() const { return entry_->text; }
+
+    /** @brief The bytecode. */
+    const program& bytecode() const { return entry_->bytecode; }
+
+    /** @brief The native code (`native().scalar()` is `false` unless the cache generates it). */
+    const jit_program& native() const { return entry_->native; }
+
+    /**
+     * @brief Evaluates one row on native code if available, otherwise on the VM.
+     * @param row The values, laid out as for `seval::expr::run(const program&, const double*, ...)`.
+     */
+    bool run(const double* row, value& result, error* err = NULL) const {
+        if (entry_->native.scalar()) {
+            entry_->native.run(row, result);
+            return true;
+        }
+        return expr::run(entry_->bytecode, row, result, err);
+    }
+
+    /**
+     * @brief Evaluates one row with variables bound by name.
+     */
+    bool run(const bindings& vars, value& result, error* err = NULL) const {
+        if (!entry_->native.scalar()) return expr::run(entry_->bytecode, vars, result, err);
+
+        std::vector<double> row;
+        if (!internal::bind_row(entry_->bytecode, vars, row, err)) return false;
+        entry_->native.run(row.empty() ? NULL : &row[0], result);
+        return true;
+    }
+
+private:
+    friend class expression_cache;
+
+    /* points the handle at `e`, taking one reference (no temporary handle, so no extra count traffic) */
+    void reset(internal::cache_entry* e) {
+        e->acquire();
+        if (entry_) entry_->release();
+        entry_ = e;
+    }
+
+    internal::cache_entry* entry_;
+};
+
+/**
+ * @struct cache_stats
+ * @brief Counters of an `expression_cache`, summed over its shards.
+ */
+struct cache_stats {
+    uint64_t hits;      /**< Lookups answered from the cache. */
+    uint64_t misses;    /**< Lookups that compiled the text (including failed compilations). */
+    uint64_t evictions; /**< Entries dropped to make room. */
+    size_t size;        /**< Entries currently cached. */
+
+    cache_stats() : hits(0), misses(0), evictions(0), size(0) {}
+};
+
+/**
+ * @class expression_cache
+ * @brief Thread-safe sharded LRU map from expression text to compiled expressions.
+ *
+ * Compilation happens outside the shard lock, so a slow compile never blocks lookups of other
+ * formulas; two threads missing on the same text at once both compile it and one result is kept.
+ * Failed compilations are not cached.
+ */
+class expression_cache {
+public:
+    /**
+     * @param capacity Maximum number of entries (default is 1024), split evenly over the shards.
+     * @param shards Number of independently locked shards (default is 16).
+     * @param native Whether entries also get native code (default is `false`).
+     * @param mode The integer overflow mode every entry is compiled with (default is `OVERFLOW_WRAP`).
+     */
+    explicit expression_cache(size_t capacity = 1024, size_t shards = 16, bool native = false, overflow_mode mode = OVERFLOW_WRAP)
+        : shards_(shards == 0 ? 1 : shards), native_(native), mode_(mode) {
+        size_t count = shards_.size();
+        perShard_ = (capacity + count - 1) / count;
+        if (perShard_ == 0) perShard_ = 1;
+    }
+
+    ~expression_cache() { clear(); }
+
+    /**
+     * @brief Returns the compilation of `text`, compiling and caching it on a miss.
+     *
+     * @param text The expression.
+     * @param out Receives the handle.
+     * @param err If not `NULL`, receives the reason of a failed compilation.
+     *
+     * @return `false` if the text does not compile.
+     */
+    bool get(const std::string& text, compiled_expression& out, error* err = NULL) {
+        shard& s = shards_[internal::text_hash(text.data(), text.size()) % shards_.size()];
+        {
+            internal::cache_lock guard(s.lock);
+            std::map<std::string, internal::cache_entry*>::iterator it = s.entries.find(text);
+            if (it != s.entries.end()) {
+                ++s.hits;
+                touch(s, it->second);
+                out.reset(it->second);
+                return true;
+            }
+            ++s.misses;
+        }
+
+        internal::cache_entry* entry = new internal::cache_entry;
+        entry->text = text;
+        if (!compile(text.c_str(), entry->bytecode, err, mode_)) {
+            entry->release();
+            return false;
+        }
+        if (native_) entry->native.compile(entry->bytecode);
+
+        internal::cache_lock guard(s.lock);
+        std::map<std::string, internal::cache_entry*>::iterator it = s.entries.find(text);
+        if (it != s.entries.end()) { /* compiled concurrently by another thread */
+            entry->release();
+            touch(s, it->second);
+            out.reset(it->second);
+            return true;
+        }
+
+        s.entries[text] = entry;
+        link_front(s, entry);
+        while (s.entries.size() > perShard_) {
+            internal::cache_entry* victim = s.tail;
+            unlink(s, victim);
+            s.entries.erase(victim->text);
+            ++s.evictions;
+            victim->release();
+        }
+        out.reset(entry);
+        return true;
+    }
+
+    /** @brief Same as `get(std::string(text), out, err)`. */
+    bool get(const char* text, compiled_expression& out, error* err = NULL) {
+        return get(std::string(text), out, err);
+    }
+
+    /** @brief Counters summed over all shards. */
+    cache_stats stats() {
+        cache_stats total;
+        for (size_t k = 0; k < shards_.size(); ++k) {
+            internal::cache_lock guard(shards_[k].lock);
+            total.hits += shards_[k].hits;
+            total.misses += shards_[k].misses;
+            total.evictions += shards_[k].evictions;
+            total.size += shards_[k].entries.size();
+        }
+        return total;
+    }
+
+    /** @brief Drops every entry (outstanding handles stay valid); counters are kept. */
+    void clear() {
+        for (size_t k = 0; k < shards_.size(); ++k) {
+            shard& s = shards_[k];
+            internal::cache_lock guard(s.lock);
+            while (s.head) {
+                internal::cache_entry* e = s.head;
+                unlink(s, e);
+                e->release();
+            }
+            s.entries.clear();
+        }
+    }
+
+private:
+    expression_cache(const expression_cache&);
+    expression_cache& operator=(const expression_cache&);
+
+    struct shard {
+        internal::cache_mutex lock;
+        std::map<std::string, internal::cache_entry*> entries;
+        internal::cache_entry* head;
+        internal::cache_entry* tail;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+
+        shard() : head(NULL), tail(NULL), hits(0), misses(0), evictions(0) {}
+        shard(const shard&) : head(NULL), tail(NULL), hits(0), misses(0), evictions(0) {} /* only copied while empty, by the vector */
+    };
+
+    static void link_front(shard& s, internal::cache_entry* e) {
+        e->prev = NULL;
+        e->next = s.head;
+        if (s.head) s.head->prev = e; else s.tail = e;
+        s.head = e;
+    }
+
+    static void unlink(shard& s, internal::cache_entry* e) {
+        if (e->prev) e->prev->next = e->next; else s.head = e->next;
+        if (e->next) e->next->prev = e->prev; else s.tail = e->prev;
+        e->prev = e->next = NULL;
+    }
+
+    static void touch(shard& s, internal::cache_entry* e) {
+        if (s.head == e) return;
+        unlink(s, e);
+        link_front(s, e);
+    }
+
+    std::vector<shard> shards_;
+    size_t perShard_;
+    bool native_;
+    overflow_mode mode_;
+};
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_CACHE_HPP_LOADED
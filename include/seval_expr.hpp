@@ -0,0 +1,1034 @@
+/**
+ * @file seval_expr.hpp
+ * @brief Arithmetic expressions over seval literals.
+ *
+ * Expressions such as `"(0x10 + 3.5e2) * -0b11 / x"` are tokenized with the literal kernels of
+ * seval.hpp (so every literal form accepted by `seval::evaluate` works inside an expression),
+ * parsed by a precedence-climbing parser (`basic_parser`, shared with the compile-time `formula` of
+ * seval_static.hpp) into a compact array-based AST, and evaluated with typed arithmetic: integer
+ * literals stay 64-bit integers until they meet a floating-point operand.
+ * Variables are doubles unless `expression::declare` makes them integers, which keeps integer
+ * inputs in integer arithmetic (see also `compile` with column bindings in seval_vm.hpp).
+ * An integer literal outside the int64 range is an error rather than wrapping around; after a
+ * unary minus, `9223372036854775808` is read together with it as INT64_MIN.
+ *
+ * Grammar:
+ *   expr    := term (('+' | '-') term)*
+ *   term    := unary (('*' | '/' | '%') unary)*
+ *   unary   := ('-' | '+') unary | primary
+ *   primary := literal | identifier | identifier '(' expr (',' expr)* ')' | '(' expr ')'
+ *
+ * Functions: pow(a, b), min(a, b), max(a, b), abs(a), sqrt(a).
+ *
+ * The type of every operation follows from the types of its operands (sqrt always yields a double),
+ * so it is known before evaluation. Integer arithmetic wraps around on overflow unless another
+ * `overflow_mode` is asked for (saturate, or fail), `pow` of two integers truncates like integer
+ * division, and integer division and modulo by zero are errors.
+ *
+ * `optimize` rewrites a parsed expression before it is compiled (seval_vm.hpp runs it on every
+ * `compile`): constant sub-expressions are folded, repeated sub-expressions are shared, and
+ * identities and cheaper equivalents replace the operations they stand for.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_EXPR_HPP_LOADED)
+#define SEVAL_EXPR_HPP_LOADED
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "seval.hpp"
+
+namespace seval {
+
+namespace expr {
+
+/**
+ * @enum value_kind
+ * @brief The type of a value.
+ */
+enum value_kind {
+    KIND_INT   = 0, /**< 64-bit signed integer */
+    KIND_FLOAT = 1, /**< double */
+};
+
+/**
+ * @struct value
+ * @brief A typed value: an integer or a double.
+ */
+struct value {
+    value_kind kind;
+    union {
+        int64_t i;
+        double f;
+    };
+
+    value() : kind(KIND_INT), i(0) {}
+
+    static value from_int(int64_t v) { value r; r.kind = KIND_INT; r.i = v; return r; }
+    static value from_float(double v) { value r; r.kind = KIND_FLOAT; r.f = v; return r; }
+
+    /** @brief The value as a double (integers are converted). */
+    double as_float() const { return kind == KIND_INT ? static_cast<double>(i) : f; }
+};
+
+/**
+ * @enum opcode
+ * @brief Node kinds of the expression AST.
+ */
+enum opcode {
+    OP_CONST = 0, /**< literal, stored in `node::constant` */
+    OP_VAR,       /**< variable, `node::a` is the index into `expression::variables` */
+    OP_NEG,       /**< -a */
+    OP_ADD,       /**< a + b */
+    OP_SUB,       /**< a - b */
+    OP_MUL,       /**< a * b */
+    OP_DIV,       /**< a / b */
+    OP_MOD,       /**< a % b (fmod for doubles) */
+    OP_POW,       /**< pow(a, b) */
+    OP_MIN,       /**< min(a, b) */
+    OP_MAX,       /**< max(a, b) */
+    OP_ABS,       /**< abs(a) */
+    OP_SQRT,      /**< sqrt(a), always a double */
+    OP_COUNT
+};
+
+/**
+ * @struct node
+ * @brief One AST node; operands refer to other nodes by index, so the tree is a flat array.
+ */
+struct node {
+    opcode op;
+    uint32_t a;        /**< First operand (node index), or the variable index for `OP_VAR`. */
+    uint32_t b;        /**< Second operand (node index) of binary operations. */
+    uint32_t position; /**< Offset of the node in the source text, for error messages. */
+    value constant;    /**< The value of `OP_CONST` nodes. */
+
+    node() : op(OP_CONST), a(0), b(0), position(0) {}
+};
+
+/**
+ * @class expression
+ * @brief A parsed expression. Operands always precede the nodes that use them.
+ */
+class expression {
+public:
+    std::vector<node> nodes;               /**< The AST; operands have smaller indexes than their users. */
+    std::vector<std::string> variables;    /**< Distinct variable names in order of first appearance. */
+    std::vector<value_kind> variableKinds; /**< Type of every variable; `KIND_FLOAT` unless declared otherwise. */
+    uint32_t root;                         /**< Index of the root node. */
+
+    expression() : root(0) {}
+
+    /** @brief Type of variable `v` (variables without a recorded type are doubles). */
+    value_kind variable_kind(size_t v) const { return v < variableKinds.size() ? variableKinds[v] : KIND_FLOAT; }
+
+    /**
+     * @brief Declares the type of a variable, e.g. `KIND_INT` for a variable bound to integers.
+     * @return `false` if the expression has no such variable.
+     */
+    bool declare(const std::string& name, value_kind kind) {
+        for (size_t v = 0; v < variables.size(); ++v) {
+            if (variables[v] != name) continue;
+            variableKinds.resize(variables.size(), KIND_FLOAT);
+            variableKinds[v] = kind;
+            return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * @struct error
+ * @brief Describes why parsing or evaluation failed.
+ */
+struct error {
+    size_t position;     /**< Offset in the source text the error refers to. */
+    const char* message; /**< Static description of the error. */
+
+    error() : position(0), message(NULL) {}
+};
+
+/**
+ * @enum overflow_mode
+ * @brief What integer arithmetic does when a result does not fit in 64 bits.
+ */
+enum overflow_mode {
+    OVERFLOW_WRAP     = 0, /**< wrap around (two's complement), the default */
+    OVERFLOW_SATURATE = 1, /**< clamp to the nearest of INT64_MIN and INT64_MAX */
+    OVERFLOW_TRAP     = 2, /**< fail with "integer overflow" */
+};
+
+/** Variable bindings by name. */
+typedef std::map<std::string, double> bindings;
+
+/** Maximum nesting depth accepted by the parser. */
+static const unsigned max_depth = 256;
+
+namespace internal {
+SEVAL_INLINE bool fail(error* err, size_t position, const char* message) {
+    if (err) {
+        err->position = position;
+        err->message = message;
+    }
+    return false;
+}
+
+/* `d` as an integer, if it is one within the int64 range */
+SEVAL_INLINE bool integral(double d, int64_t& out) {
+    if (!(d >= -9223372036854775808.0 && d < 9223372036854775808.0)) return false;
+    out = static_cast<int64_t>(d);
+    return static_cast<double>(out) == d;
+}
+
+/* a bound value in the type of its variable; integer variables take integral values only */
+SEVAL_INLINE bool bind_value(value_kind kind, double d, value& out) {
+    out.kind = kind;
+    if (kind == KIND_FLOAT) {
+        out.f = d;
+        return true;
+    }
+    return integral(d, out.i);
+}
+
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_ident_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+SEVAL_INLINE SEVAL_CONSTEXPR bool is_ident_ch(char c) {
+    return is_ident_start(c) || seval::internal::is_decimal_ch(c);
+}
+
+/** Largest magnitude of an integer literal: 2^63, which only `-9223372036854775808` may use. */
+static const uint64_t max_literal = 0x8000000000000000ULL;
+
+/**
+ * @brief Reads the digits of an integer literal in base `Radix` (after any prefix).
+ * @return `false` if the magnitude is above `max_literal`.
+ */
+template <unsigned Radix>
+SEVAL_INLINE SEVAL_CONSTEXPR bool read_integer_literal(const char* text, size_t& i, uint64_t& magnitude) {
+    magnitude = 0;
+    return seval::internal::evaluate_magnitude_n<Radix>(text, magnitude, i, static_cast<size_t>(-1)) && magnitude <= max_literal;
+}
+
+/**
+ * @brief Wrapping integer arithmetic (done in unsigned to avoid signed-overflow UB).
+ */
+SEVAL_INLINE SEVAL_CONSTEXPR int64_t wrap_add(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)); }
+SEVAL_INLINE SEVAL_CONSTEXPR int64_t wrap_sub(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)); }
+SEVAL_INLINE SEVAL_CONSTEXPR int64_t wrap_mul(int64_t a, int64_t b) { return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)); }
+SEVAL_INLINE SEVAL_CONSTEXPR int64_t wrap_neg(int64_t a) { return static_cast<int64_t>(0 - static_cast<uint64_t>(a)); }
+
+/**
+ * @brief Integer power; negative exponents truncate like integer division (only 1 and -1 survive).
+ */
+SEVAL_INLINE SEVAL_CONSTEXPR int64_t int_pow(int64_t base, int64_t exponent) {
+    if (exponent < 0) {
+        if (base == 1) return 1;
+        if (base == -1) return (exponent & 1) ? -1 : 1;
+        return 0;
+    }
+    int64_t result = 1;
+    while (exponent > 0) {
+        if (exponent & 1) result = wrap_mul(result, base);
+        base = wrap_mul(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+static const int64_t int64_max = static_cast<int64_t>(0x7FFFFFFFFFFFFFFFULL);
+static const int64_t int64_min = static_cast<int64_t>(0x8000000000000000ULL);
+
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define SEVAL_BUILTIN_OVERFLOW 1
+#endif
+
+/**
+ * @brief Overflow-detecting integer arithmetic: `r` receives the wrapped result, the return value
+ *        tells whether it differs from the exact one.
+ */
+SEVAL_INLINE SEVAL_CONSTEXPR bool add_overflows(int64_t a, int64_t b, int64_t& r) {
+#if defined(SEVAL_BUILTIN_OVERFLOW)
+    return __builtin_add_overflow(a, b, &r);
+#else
+    r = wrap_add(a, b);
+    return ((a ^ r) & (b ^ r)) < 0;
+#endif
+}
+
+SEVAL_INLINE SEVAL_CONSTEXPR bool sub_overflows(int64_t a, int64_t b, int64_t& r) {
+#if defined(SEVAL_BUILTIN_OVERFLOW)
+    return __builtin_sub_overflow(a, b, &r);
+#else
+    r = wrap_sub(a, b);
+    return ((a ^ b) & (a ^ r)) < 0;
+#endif
+}
+
+SEVAL_INLINE SEVAL_CONSTEXPR bool mul_overflows(int64_t a, int64_t b, int64_t& r) {
+#if defined(SEVAL_BUILTIN_OVERFLOW)
+    return __builtin_mul_overflow(a, b, &r);
+#else
+    r = wrap_mul(a, b);
+    return a != 0 && ((a == -1 && b == int64_min) || (b == -1 && a == int64_min) || r / a != b);
+#endif
+}
+
+/* `int_pow` that also reports overflow; only squares still needed by the result are taken */
+SEVAL_INLINE SEVAL_CONSTEXPR bool pow_overflows(int64_t base, int64_t exponent, int64_t& r) {
+    r = 1;
+    if (exponent < 0) {
+        r = int_pow(base, exponent);
+        return false;
+    }
+    bool overflow = false;
+    while (exponent > 0) {
+        if (exponent & 1) overflow |= mul_overflows(r, base, r);
+        exponent >>= 1;
+        if (exponent > 0) overflow |= mul_overflows(base, base, base);
+    }
+    return overflow;
+}
+
+/* branch-free saturating addition and subtraction, which the columnar loops vectorize */
+SEVAL_INLINE int64_t saturating_add(int64_t a, int64_t b) {
+    int64_t r = wrap_add(a, b);
+    int64_t bound = a < 0 ? int64_min : int64_max;
+    return ((a ^ r) & (b ^ r)) < 0 ? bound : r;
+}
+
+SEVAL_INLINE int64_t saturating_sub(int64_t a, int64_t b) {
+    int64_t r = wrap_sub(a, b);
+    int64_t bound = a < 0 ? int64_min : int64_max;
+    return ((a ^ b) & (a ^ r)) < 0 ? bound : r;
+}
+
+/**
+ * @brief Integer operation under an overflow mode (unary operations ignore `y`).
+ *
+ * @return `false` for division or modulo by zero, and for overflow under `OVERFLOW_TRAP`.
+ */
+SEVAL_INLINE SEVAL_CONSTEXPR bool int_apply(opcode op, int64_t x, int64_t y, overflow_mode mode, int64_t& out) {
+    int64_t r = 0;
+    bool overflow = false;
+    int64_t bound = int64_max; /* saturated result */
+
+    switch (op) {
+    case OP_NEG: overflow = x == int64_min; r = wrap_neg(x); break;
+    case OP_ABS: overflow = x == int64_min; r = x < 0 ? wrap_neg(x) : x; break;
+    case OP_ADD: overflow = add_overflows(x, y, r); bound = x < 0 ? int64_min : int64_max; break;
+    case OP_SUB: overflow = sub_overflows(x, y, r); bound = x < 0 ? int64_min : int64_max; break;
+    case OP_MUL: overflow = mul_overflows(x, y, r); bound = (x < 0) != (y < 0) ? int64_min : int64_max; break;
+    case OP_POW: overflow = pow_overflows(x, y, r); bound = x < 0 && (y & 1) ? int64_min : int64_max; break;
+    case OP_MIN: r = y < x ? y : x; break;
+    case OP_MAX: r = x < y ? y : x; break;
+    case OP_DIV:
+    case OP_MOD:
+        if (y == 0) return false;
+        if (y == -1) { /* INT64_MIN / -1 overflows */
+            overflow = op == OP_DIV && x == int64_min;
+            r = op == OP_DIV ? wrap_neg(x) : 0;
+        } else {
+            r = op == OP_DIV ? x / y : x % y;
+        }
+        break;
+    default:
+        r = x;
+        break;
+    }
+
+    if (overflow && mode != OVERFLOW_WRAP) {
+        if (mode == OVERFLOW_TRAP) return false;
+        r = bound;
+    }
+    out = r;
+    return true;
+}
+
+/**
+ * @brief Why `int_apply` failed.
+ */
+SEVAL_INLINE SEVAL_CONSTEXPR const char* int_failure(opcode op, int64_t y) {
+    return (op == OP_DIV || op == OP_MOD) && y == 0 ? "integer division by zero" : "integer overflow";
+}
+
+/**
+ * @brief Applies an operation to typed operands (unary operations get their operand twice).
+ *
+ * @return `false` for integer division or modulo by zero, and for integer overflow under
+ *         `OVERFLOW_TRAP` (see `int_failure`).
+ */
+SEVAL_INLINE bool apply(opcode op, const value& x, const value& y, value& out, overflow_mode mode = OVERFLOW_WRAP) {
+    if (x.kind == KIND_INT && y.kind == KIND_INT && op != OP_SQRT) {
+        int64_t r = 0;
+        if (!int_apply(op, x.i, y.i, mode, r)) return false;
+        out = value::from_int(r);
+        return true;
+    }
+
+    switch (op) {
+    case OP_NEG:  out = value::from_float(-x.as_float()); return true;
+    case OP_ABS:  out = value::from_float(fabs(x.as_float())); return true;
+    case OP_SQRT: out = value::from_float(sqrt(x.as_float())); return true;
+    case OP_ADD:  out = value::from_float(x.as_float() + y.as_float()); return true;
+    case OP_SUB:  out = value::from_float(x.as_float() - y.as_float()); return true;
+    case OP_MUL:  out = value::from_float(x.as_float() * y.as_float()); return true;
+    case OP_DIV:  out = value::from_float(x.as_float() / y.as_float()); return true;
+    case OP_MOD:  out = value::from_float(fmod(x.as_float(), y.as_float())); return true;
+    case OP_POW:  out = value::from_float(pow(x.as_float(), y.as_float())); return true;
+    case OP_MIN:  out = value::from_float(y.as_float() < x.as_float() ? y.as_float() : x.as_float()); return true;
+    case OP_MAX:  out = value::from_float(x.as_float() < y.as_float() ? y.as_float() : x.as_float()); return true;
+    default:
+        out = x;
+        return true;
+    }
+}
+
+/**
+ * @brief Number of operands of an opcode.
+ */
+SEVAL_INLINE SEVAL_CONSTEXPR unsigned arity(opcode op) {
+    switch (op) {
+    case OP_CONST:
+    case OP_VAR:
+        return 0;
+    case OP_NEG:
+    case OP_ABS:
+    case OP_SQRT:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+struct function_entry {
+    const char* name;
+    opcode op;
+};
+
+#if __cplusplus >= 201103L
+#define SEVAL_EXPR_TABLE constexpr /* readable while parsing in constant expressions */
+#else
+#define SEVAL_EXPR_TABLE const
+#endif
+
+static SEVAL_EXPR_TABLE function_entry functions[] = {
+    { "pow", OP_POW },
+    { "min", OP_MIN },
+    { "max", OP_MAX },
+    { "abs", OP_ABS },
+    { "sqrt", OP_SQRT },
+};
+
+#undef SEVAL_EXPR_TABLE
+
+/* the `length` characters at `text` spell the NUL-terminated `name` */
+SEVAL_INLINE SEVAL_CONSTEXPR bool name_is(const char* text, size_t length, const char* name) {
+    size_t k = 0;
+    while (k < length && name[k] == text[k]) ++k;
+    return k == length && name[k] == '\0';
+}
+
+/**
+ * @class basic_parser
+ * @brief Recursive-descent / precedence-climbing parser that hands every node to a sink.
+ *
+ * The sink builds the tree and reports errors; it provides
+ *   `bool fail(size_t position, const char* message)` (returns `false`),
+ *   `uint32_t integer(int64_t v, size_t position)`, `uint32_t real(double v, size_t position)`,
+ *   `uint32_t variable(const char* name, size_t length, size_t position)`,
+ *   `bool operation(opcode op, uint32_t a, uint32_t b, size_t position, uint32_t& result)` and
+ *   `void root(uint32_t n)`,
+ * where `uint32_t` results are node indexes and `b` is unused by unary operations. The parser
+ * itself is `constexpr` from C++14 on, so `expression_builder` (for `parse`) and the compile-time
+ * sink of seval_static.hpp (for `formula`) share its grammar and error messages.
+ */
+template <typename Sink>
+class basic_parser {
+public:
+    SEVAL_CONSTEXPR basic_parser(const char* text, Sink& out) : text_(text), i_(0), depth_(0), out_(out) {}
+
+    SEVAL_CONSTEXPR bool run() {
+        uint32_t root = 0;
+        if (!parse_binary(0, root)) return false;
+        skip_space();
+        if (text_[i_] != '\0') return out_.fail(i_, "unexpected character");
+        out_.root(root);
+        return true;
+    }
+
+private:
+    SEVAL_CONSTEXPR void skip_space() {
+        while (text_[i_] == ' ' || text_[i_] == '\t' || text_[i_] == '\n' || text_[i_] == '\r') ++i_;
+    }
+
+    static SEVAL_CONSTEXPR int precedence(char c) {
+        switch (c) {
+        case '+': case '-': return 1;
+        case '*': case '/': case '%': return 2;
+        default: return 0;
+        }
+    }
+
+    static SEVAL_CONSTEXPR opcode binary_op(char c) {
+        switch (c) {
+        case '+': return OP_ADD;
+        case '-': return OP_SUB;
+        case '*': return OP_MUL;
+        case '/': return OP_DIV;
+        default: return OP_MOD;
+        }
+    }
+
+    SEVAL_CONSTEXPR bool parse_binary(int minPrecedence, uint32_t& result) {
+        if (++depth_ > max_depth) return out_.fail(i_, "expression is nested too deeply");
+
+        uint32_t lhs = 0;
+        if (!parse_unary(lhs)) return false;
+
+        for (;;) {
+            skip_space();
+            char c = text_[i_];
+            int prec = precedence(c);
+            if (prec == 0 || prec <= minPrecedence) break;
+
+            size_t position = i_++;
+            uint32_t rhs = 0;
+            if (!parse_binary(prec, rhs)) return false;
+            if (!out_.operation(binary_op(c), lhs, rhs, position, lhs)) return false;
+        }
+
+        --depth_;
+        result = lhs;
+        return true;
+    }
+
+    SEVAL_CONSTEXPR bool parse_unary(uint32_t& result) {
+        skip_space();
+        char c = text_[i_];
+        if (c == '-' || c == '+') {
+            if (++depth_ > max_depth) return out_.fail(i_, "expression is nested too deeply");
+            size_t position = i_++;
+            uint32_t operand = 0;
+            bool folded = false;
+            skip_space();
+            bool literal = c == '-' && seval::internal::is_decimal_ch(text_[i_]);
+            if (!(literal ? parse_number(operand, position, &folded) : parse_unary(operand))) return false;
+            --depth_;
+            if (folded || c == '+') {
+                result = operand;
+                return true;
+            }
+            return out_.operation(OP_NEG, operand, 0, position, result);
+        }
+        return parse_primary(result);
+    }
+
+    SEVAL_CONSTEXPR bool parse_primary(uint32_t& result) {
+        skip_space();
+        char c = text_[i_];
+
+        if (c == '(') {
+            ++i_;
+            if (!parse_binary(0, result)) return false;
+            skip_space();
+            if (text_[i_] != ')') return out_.fail(i_, "expected ')'");
+            ++i_;
+            return true;
+        }
+        if (seval::internal::is_decimal_ch(c) || (c == '.' && seval::internal::is_decimal_ch(text_[i_ + 1]))) {
+            return parse_number(result, 0, NULL);
+        }
+        if (is_ident_start(c)) {
+            return parse_identifier(result);
+        }
+        return out_.fail(i_, c == '\0' ? "unexpected end of expression" : "expected a number, variable or '('");
+    }
+
+    /*
+     * `folded` is non-`NULL` when the literal follows a unary minus at `minus`: the literal may
+     * then be 2^63, which is read together with the minus as INT64_MIN (and `*folded` set).
+     */
+    SEVAL_CONSTEXPR bool parse_number(uint32_t& result, size_t minus, bool* folded) {
+        size_t start = i_;
+        size_t i = i_;
+        bool integer = true;
+        bool fits = true;
+        uint64_t number = 0;
+        double real = 0;
+
+        if (seval::internal::has_binary_prefix<const char*>(text_, i)) {
+            seval::internal::skip_(i, 2);
+            fits = read_integer_literal<2>(text_, i, number);
+            if (i == start + 2) return out_.fail(start, "expected binary digits");
+        } else if (seval::internal::has_hexadecimal_prefix<const char*>(text_, i)) {
+            seval::internal::skip_(i, 2);
+            fits = read_integer_literal<16>(text_, i, number);
+            if (i == start + 2) return out_.fail(start, "expected hexadecimal digits");
+        } else {
+            fits = read_integer_literal<10>(text_, i, number);
+
+            if (text_[i] == '.' || text_[i] == 'e' || text_[i] == 'E') {
+                integer = false;
+                i = start;
+                seval::internal::evaluate_decimal_literal<double, const char*>(text_, real, i);
+                if (text_[i] == '.') {
+                    seval::internal::next_(i);
+                    seval::internal::evaluate_floatpoint_literal<double, const char*>(text_, real, i, 0.1);
+                }
+                if (text_[i] == 'e' || text_[i] == 'E') {
+                    size_t digit = i + 1 + ((text_[i + 1] == '-' || text_[i + 1] == '+') ? 1 : 0);
+                    if (!seval::internal::is_decimal_ch(text_[digit])) return out_.fail(i, "malformed exponent");
+                    seval::internal::evaluate_exponent_literal<double, const char*>(text_, real, i);
+                }
+            }
+        }
+
+        if (is_ident_ch(text_[i]) || text_[i] == '.') return out_.fail(i, "invalid character in number");
+        if (integer && (!fits || (number == max_literal && !folded))) return out_.fail(start, "integer literal out of range");
+
+        i_ = i;
+        if (!integer) {
+            result = out_.real(real, start);
+        } else if (number == max_literal) { /* -9223372036854775808, already negative */
+            *folded = true;
+            result = out_.integer(int64_min, minus);
+        } else {
+            result = out_.integer(static_cast<int64_t>(number), start);
+        }
+        return true;
+    }
+
+    SEVAL_CONSTEXPR bool parse_identifier(uint32_t& result) {
+        size_t start = i_;
+        while (is_ident_ch(text_[i_])) ++i_;
+        size_t length = i_ - start;
+
+        size_t after = i_;
+        skip_space();
+        if (text_[i_] != '(') {
+            i_ = after;
+            result = out_.variable(text_ + start, length, start);
+            return true;
+        }
+
+        const function_entry* function = NULL;
+        for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); ++f) {
+            if (name_is(text_ + start, length, functions[f].name)) function = &functions[f];
+        }
+        if (!function) return out_.fail(start, "unknown function");
+
+        ++i_;
+        uint32_t args[2] = { 0, 0 };
+        unsigned expected = arity(function->op);
+        for (unsigned n = 0; n < expected; ++n) {
+            if (n != 0) {
+                skip_space();
+                if (text_[i_] != ',') return out_.fail(i_, "expected ','");
+                ++i_;
+            }
+            if (!parse_binary(0, args[n])) return false;
+        }
+        skip_space();
+        if (text_[i_] != ')') return out_.fail(i_, text_[i_] == ',' ? "too many arguments" : "expected ')'");
+        ++i_;
+
+        return out_.operation(function->op, args[0], args[1], start, result);
+    }
+
+    const char* text_;
+    size_t i_;
+    unsigned depth_;
+    Sink& out_;
+};
+
+/**
+ * @class expression_builder
+ * @brief `basic_parser` sink that appends the nodes to an `expression`.
+ */
+class expression_builder {
+public:
+    expression_builder(expression& out, error* err) : out_(out), err_(err) {
+        out_.nodes.clear();
+        out_.variables.clear();
+        out_.variableKinds.clear();
+        out_.root = 0;
+    }
+
+    bool fail(size_t position, const char* message) { return internal::fail(err_, position, message); }
+
+    uint32_t integer(int64_t v, size_t position) { return constant(value::from_int(v), position); }
+
+    uint32_t real(double v, size_t position) { return constant(value::from_float(v), position); }
+
+    uint32_t variable(const char* name, size_t length, size_t position) {
+        uint32_t index = 0;
+        while (index < out_.variables.size() && !(out_.variables[index].size() == length && name_is(name, length, out_.variables[index].c_str()))) ++index;
+        if (index == out_.variables.size()) {
+            out_.variables.push_back(std::string(name, length));
+            out_.variableKinds.push_back(KIND_FLOAT);
+        }
+        return add(OP_VAR, index, 0, position);
+    }
+
+    bool operation(opcode op, uint32_t a, uint32_t b, size_t position, uint32_t& result) {
+        result = add(op, a, b, position);
+        return true;
+    }
+
+    void root(uint32_t n) { out_.root = n; }
+
+private:
+    uint32_t add(opcode op, uint32_t a, uint32_t b, size_t position) {
+        node n;
+        n.op = op;
+        n.a = a;
+        n.b = b;
+        n.position = static_cast<uint32_t>(position);
+        out_.nodes.push_back(n);
+        return static_cast<uint32_t>(out_.nodes.size() - 1);
+    }
+
+    uint32_t constant(const value& v, size_t position) {
+        uint32_t index = add(OP_CONST, 0, 0, position);
+        out_.nodes[index].constant = v;
+        return index;
+    }
+
+    expression& out_;
+    error* err_;
+};
+} /* internal */
+
+/**
+ * @brief Parses an expression.
+ *
+ * @param text The NUL-terminated expression text.
+ * @param out Receives the AST.
+ * @param err If not `NULL`, receives the reason and position of a failure.
+ *
+ * @return `true` on success, otherwise `false`.
+ */
+SEVAL_INLINE bool parse(const char* text, expression& out, error* err = NULL) {
+    internal::expression_builder builder(out, err);
+    return internal::basic_parser<internal::expression_builder>(text, builder).run();
+}
+
+/**
+ * @brief Evaluates a parsed expression by walking its AST.
+ *
+ * @param e The expression.
+ * @param vars The variable bindings; every variable of the expression must be bound, and
+ *        variables declared `KIND_INT` to integral values.
+ * @param result Receives the value of the expression.
+ * @param err If not `NULL`, receives the reason and position of a failure.
+ * @param mode What integer overflow does (default is `OVERFLOW_WRAP`).
+ *
+ * @return `false` for unbound variables, non-integral values of integer variables, integer
+ *         division by zero and trapped integer overflow, otherwise `true`.
+ */
+SEVAL_INLINE bool evaluate(const expression& e, const bindings& vars, value& result, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    if (e.nodes.empty()) return internal::fail(err, 0, "empty expression");
+
+    std::vector<value> slots(e.variables.size());
+    for (size_t v = 0; v < e.variables.size(); ++v) {
+        bindings::const_iterator it = vars.find(e.variables[v]);
+        if (it != vars.end() && internal::bind_value(e.variable_kind(v), it->second, slots[v])) continue;
+
+        size_t position = 0;
+        for (size_t n = 0; n < e.nodes.size(); ++n) {
+            if (e.nodes[n].op == OP_VAR && e.nodes[n].a == v) { position = e.nodes[n].position; break; }
+        }
+        return internal::fail(err, position, it == vars.end() ? "unbound variable" : "integer variable bound to a non-integer value");
+    }
+
+    /* operands precede their users, so one forward pass evaluates every node */
+    std::vector<value> results(e.nodes.size());
+    for (size_t n = 0; n < e.nodes.size(); ++n) {
+        const node& nd = e.nodes[n];
+        switch (nd.op) {
+        case OP_CONST:
+            results[n] = nd.constant;
+            break;
+        case OP_VAR:
+            results[n] = slots[nd.a];
+            break;
+        default:
+            const value& y = internal::arity(nd.op) == 2 ? results[nd.b] : results[nd.a];
+            if (!internal::apply(nd.op, results[nd.a], y, results[n], mode)) {
+                return internal::fail(err, nd.position, internal::int_failure(nd.op, y.i));
+            }
+        }
+    }
+
+    result = results[e.root];
+    return true;
+}
+
+/**
+ * @brief Parses and evaluates an expression in one call.
+ */
+SEVAL_INLINE bool evaluate(const char* text, const bindings& vars, value& result, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    expression e;
+    return parse(text, e, err) && evaluate(e, vars, result, err, mode);
+}
+
+namespace internal {
+/**
+ * @class optimizer
+ * @brief Rebuilds an expression bottom-up, simplifying every node and hash-consing the result.
+ */
+class optimizer {
+public:
+    optimizer(const expression& in, expression& out, overflow_mode mode) : in_(in), out_(out), mode_(mode) {}
+
+    void run() {
+        nodes_.clear();
+        kinds_.clear();
+        fails_.clear();
+        interned_.clear();
+
+        std::vector<uint32_t> map(in_.nodes.size(), 0);
+        for (size_t n = 0; n < in_.nodes.size(); ++n) {
+            node nd = in_.nodes[n];
+            unsigned args = arity(nd.op);
+            if (args >= 1) nd.a = map[nd.a];
+            if (args >= 2) nd.b = map[nd.b];
+            map[n] = simplify(nd);
+        }
+
+        /* keep only what the root reaches; operands still precede their users */
+        std::vector<uint8_t> live(nodes_.size(), 0);
+        uint32_t root = in_.nodes.empty() ? 0 : map[in_.root];
+        if (!nodes_.empty()) live[root] = 1;
+        for (size_t n = nodes_.size(); n-- > 0;) {
+            if (!live[n]) continue;
+            unsigned args = arity(nodes_[n].op);
+            if (args >= 1) live[nodes_[n].a] = 1;
+            if (args >= 2) live[nodes_[n].b] = 1;
+        }
+
+        std::vector<node> nodes;
+        std::vector<uint32_t> index(nodes_.size(), 0);
+        for (size_t n = 0; n < nodes_.size(); ++n) {
+            if (!live[n]) continue;
+            node nd = nodes_[n];
+            unsigned args = arity(nd.op);
+            if (args >= 1) nd.a = index[nd.a];
+            if (args >= 2) nd.b = index[nd.b];
+            index[n] = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(nd);
+        }
+
+        out_.nodes.swap(nodes);
+        out_.variables = in_.variables;
+        out_.variableKinds = in_.variableKinds;
+        out_.root = nodes_.empty() ? 0 : index[root];
+    }
+
+private:
+    struct key {
+        int op;
+        uint32_t a, b;
+        uint64_t bits;
+
+        bool operator<(const key& o) const {
+            if (op != o.op) return op < o.op;
+            if (a != o.a) return a < o.a;
+            if (b != o.b) return b < o.b;
+            return bits < o.bits;
+        }
+    };
+
+    bool is_const(uint32_t n) const { return nodes_[n].op == OP_CONST; }
+
+    /* constant node `n` equals `v` (either type) */
+    bool is_value(uint32_t n, double v) const { return is_const(n) && nodes_[n].constant.as_float() == v; }
+
+    /* constant node `n` is a zero of the given sign; integer zeros count as +0 */
+    bool is_zero(uint32_t n, bool negative) const {
+        if (!is_value(n, 0)) return false;
+        if (nodes_[n].constant.kind == KIND_INT) return !negative;
+        uint64_t bits = 0;
+        memcpy(&bits, &nodes_[n].constant.f, sizeof(bits));
+        return (bits >> 63 != 0) == negative;
+    }
+
+    /* whether evaluating `nd` alone can fail (integer division by zero, trapped overflow) */
+    bool may_fail(const node& nd, value_kind kind) const {
+        if (kind != KIND_INT || arity(nd.op) == 0) return false;
+        switch (nd.op) {
+        case OP_DIV:
+        case OP_MOD:  return true;
+        case OP_MIN:
+        case OP_MAX:  return false;
+        default:      return mode_ == OVERFLOW_TRAP;
+        }
+    }
+
+    value_kind kind_of(const node& nd) const {
+        switch (nd.op) {
+        case OP_CONST: return nd.constant.kind;
+        case OP_VAR:   return in_.variable_kind(nd.a);
+        case OP_SQRT:  return KIND_FLOAT;
+        case OP_NEG:
+        case OP_ABS:   return kinds_[nd.a];
+        default:       return (kinds_[nd.a] == KIND_INT && kinds_[nd.b] == KIND_INT) ? KIND_INT : KIND_FLOAT;
+        }
+    }
+
+    /* returns the existing node equal to `nd`, or appends it */
+    uint32_t intern(const node& nd) {
+        key k;
+        k.op = nd.op;
+        k.a = arity(nd.op) >= 1 || nd.op == OP_VAR ? nd.a : 0;
+        k.b = arity(nd.op) >= 2 ? nd.b : 0;
+        k.bits = 0;
+        if (nd.op == OP_CONST) {
+            k.a = nd.constant.kind;
+            memcpy(&k.bits, nd.constant.kind == KIND_INT ? static_cast<const void*>(&nd.constant.i) : static_cast<const void*>(&nd.constant.f), sizeof(k.bits));
+        }
+
+        std::map<key, uint32_t>::const_iterator it = interned_.find(k);
+        if (it != interned_.end()) return it->second;
+
+        uint32_t n = static_cast<uint32_t>(nodes_.size());
+        value_kind kind = kind_of(nd);
+        unsigned args = arity(nd.op);
+        kinds_.push_back(kind);
+        fails_.push_back(may_fail(nd, kind) || (args >= 1 && fails_[nd.a]) || (args >= 2 && fails_[nd.b]));
+        nodes_.push_back(nd);
+        interned_[k] = n;
+        return n;
+    }
+
+    uint32_t constant(const value& v, uint32_t position) {
+        node nd;
+        nd.op = OP_CONST;
+        nd.position = position;
+        nd.constant = v;
+        return intern(nd);
+    }
+
+    uint32_t binary(opcode op, uint32_t a, uint32_t b, uint32_t position) {
+        node nd;
+        nd.op = op;
+        nd.a = a;
+        nd.b = b;
+        nd.position = position;
+        return intern(nd);
+    }
+
+    /* `nd` with operands already rebuilt; returns the node that replaces it */
+    uint32_t simplify(node nd) {
+        unsigned args = arity(nd.op);
+        if (args == 0) return intern(nd);
+
+        uint32_t a = nd.a, b = args == 2 ? nd.b : nd.a;
+        value_kind kind = kind_of(nd);
+
+        /* folding; integer division by zero and trapped overflow are left for evaluation to report */
+        if (is_const(a) && is_const(b)) {
+            value folded;
+            if (apply(nd.op, nodes_[a].constant, nodes_[b].constant, folded, mode_)) return constant(folded, nd.position);
+        }
+
+        bool keepsA = kinds_[a] == kind, keepsB = kinds_[b] == kind;
+        switch (nd.op) {
+        case OP_NEG:
+            if (nodes_[a].op == OP_NEG && (kind == KIND_FLOAT || mode_ == OVERFLOW_WRAP)) return nodes_[a].a; /* -(-x) */
+            break;
+        case OP_ABS:
+            if (nodes_[a].op == OP_ABS) return a;                                /* abs(abs(x)) */
+            if (nodes_[a].op == OP_NEG) nd.a = nodes_[a].a;                      /* abs(-x) */
+            break;
+        case OP_ADD: /* -0 + +0 is +0, so only integer zeros and -0.0 vanish */
+            if (is_value(b, 0) && keepsA && (kind == KIND_INT || is_zero(b, true))) return a; /* x + 0 */
+            if (is_value(a, 0) && keepsB && (kind == KIND_INT || is_zero(a, true))) return b;
+            break;
+        case OP_SUB: /* -0 - -0 is +0 */
+            if (is_value(b, 0) && keepsA && (kind == KIND_INT || is_zero(b, false))) return a; /* x - 0 */
+            break;
+        case OP_MUL:
+            if (is_value(b, 1) && keepsA) return a;                              /* x * 1 */
+            if (is_value(a, 1) && keepsB) return b;
+            break;
+        case OP_DIV:
+            if (is_value(b, 1) && keepsA) return a;                              /* x / 1 */
+            if (kind == KIND_FLOAT && is_const(b)) {                             /* x / 2^k -> x * 2^-k */
+                double c = nodes_[b].constant.as_float();
+                double r = 1.0 / c;
+                int exponent = 0;
+                if (c != 0 && fabs(frexp(c, &exponent)) == 0.5 && fabs(r) <= DBL_MAX && c * r == 1.0) {
+                    return binary(OP_MUL, a, constant(value::from_float(r), nodes_[b].position), nd.position);
+                }
+            }
+            break;
+        case OP_POW:
+            if (is_value(b, 2) && keepsA) return binary(OP_MUL, a, a, nd.position); /* pow(x, 2) -> x * x */
+            if (is_value(b, 1) && keepsA) return a;
+            if (is_value(b, 0) && !fails_[a]) return constant(kind == KIND_INT ? value::from_int(1) : value::from_float(1.0), nd.position);
+            break;
+        case OP_MIN:
+        case OP_MAX:
+            if (a == b) return a;
+            break;
+        default:
+            break;
+        }
+
+        /* + and * commute exactly, so order their operands to let CSE see both spellings */
+        if ((nd.op == OP_ADD || nd.op == OP_MUL) && nd.b < nd.a) {
+            uint32_t t = nd.a;
+            nd.a = nd.b;
+            nd.b = t;
+        }
+        return intern(nd);
+    }
+
+    const expression& in_;
+    expression& out_;
+    overflow_mode mode_;
+    std::vector<node> nodes_;
+    std::vector<value_kind> kinds_;
+    std::vector<bool> fails_; /* the node's subtree can fail, so it must not be dropped */
+    std::map<key, uint32_t> interned_;
+};
+} /* internal */
+
+/**
+ * @brief Optimizes a parsed expression.
+ *
+ * Constant sub-expressions are folded (except integer division by zero, which evaluation still
+ * reports), identical sub-expressions become one shared node, and `x + 0`, `x - 0`, `x * 1`,
+ * `x / 1`, `-(-x)`, `abs(-x)`, `min(x, x)`, `pow(x, 0|1|2)` and division by a power of two are
+ * rewritten to cheaper forms. Rewrites keep the type of every result and are exact in IEEE
+ * arithmetic, except that `pow(x, 2)` becomes the correctly rounded `x * x`: a floating-point
+ * `x + 0` is kept (it turns -0 into +0) unless the zero is -0.0, and `pow(x, 0)` is kept when `x`
+ * can fail, so its error is still reported. Variables are kept in the same order even if they no longer occur.
+ *
+ * @param in The expression.
+ * @param out Receives the optimized expression (may be `in`).
+ * @param mode The integer overflow mode constants are folded under (default is `OVERFLOW_WRAP`).
+ */
+SEVAL_INLINE void optimize(const expression& in, expression& out, overflow_mode mode = OVERFLOW_WRAP) {
+    if (&in == &out) {
+        expression copy(in);
+        internal::optimizer(copy, out, mode).run();
+    } else {
+        internal::optimizer(in, out, mode).run();
+    }
+}
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_EXPR_HPP_LOADED
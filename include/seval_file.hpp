@@ -0,0 +1,449 @@
+/**
+ * @file seval_file.hpp
+ * @brief Evaluating columns stored in text files, with an optional binary cache.
+ *
+ * `parse_file` maps a text file and evaluates it as a delimited column. `load_column` does the same
+ * but can keep the typed result in a compact binary cache file keyed by the source file's device
+ * and inode, size, modification time and content hash; later loads map the cache file directly instead of parsing.
+ *
+ * Files are memory-mapped on POSIX systems and read into memory elsewhere.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_FILE_HPP_LOADED)
+#define SEVAL_FILE_HPP_LOADED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define SEVAL_FILE_MMAP 1
+#endif
+
+#include "seval_batch.hpp"
+
+namespace seval {
+
+namespace file {
+
+/**
+ * @class mapped_file
+ * @brief Read-only view of a whole file (memory-mapped where supported).
+ */
+class mapped_file {
+public:
+    mapped_file() : data_(NULL), size_(0), mtime_(0), mtimeNsec_(0), device_(0), inode_(0), mapped_(false) {}
+    ~mapped_file() { close(); }
+
+    /**
+     * @brief Opens and maps a file, closing any previously opened one.
+     * @param path The path of the file.
+     * @return `true` on success, otherwise `false`.
+     */
+    bool open(const char* path) {
+        close();
+
+        struct stat st;
+        if (stat(path, &st) != 0) return false;
+        size_ = static_cast<size_t>(st.st_size);
+        mtime_ = static_cast<int64_t>(st.st_mtime);
+#if defined(__APPLE__)
+        mtimeNsec_ = static_cast<uint32_t>(st.st_mtimespec.tv_nsec);
+#elif defined(__unix__)
+        mtimeNsec_ = static_cast<uint32_t>(st.st_mtim.tv_nsec);
+#endif
+        device_ = static_cast<uint64_t>(st.st_dev);
+        inode_ = static_cast<uint64_t>(st.st_ino);
+        if (size_ == 0) return true;
+
+#if defined(SEVAL_FILE_MMAP)
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        void* p = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        data_ = static_cast<const char*>(p);
+        mapped_ = true;
+        return true;
+#else
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        char* buffer = static_cast<char*>(malloc(size_));
+        bool ok = buffer && fread(buffer, 1, size_, f) == size_;
+        fclose(f);
+        if (!ok) {
+            free(buffer);
+            return false;
+        }
+        data_ = buffer;
+        return true;
+#endif
+    }
+
+    /** @brief Unmaps the file. */
+    void close() {
+        if (data_) {
+#if defined(SEVAL_FILE_MMAP)
+            if (mapped_) munmap(const_cast<char*>(data_), size_);
+#else
+            free(const_cast<char*>(data_));
+#endif
+        }
+        data_ = NULL;
+        size_ = 0;
+        mtime_ = 0;
+        mtimeNsec_ = 0;
+        device_ = 0;
+        inode_ = 0;
+        mapped_ = false;
+    }
+
+    const char* data() const { return data_; } /**< The contents (`NULL` for empty files). */
+    size_t size() const { return size_; }      /**< The size in bytes. */
+    int64_t mtime() const { return mtime_; }   /**< The modification time in seconds since the epoch. */
+    uint32_t mtime_nsec() const { return mtimeNsec_; } /**< ... and its nanoseconds (0 where the platform has none). */
+    uint64_t device() const { return device_; } /**< The device holding the file. */
+    uint64_t inode() const { return inode_; }   /**< The file's inode (0 where the platform has none). */
+
+private:
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+
+    const char* data_;
+    size_t size_;
+    int64_t mtime_;
+    uint32_t mtimeNsec_;
+    uint64_t device_;
+    uint64_t inode_;
+    bool mapped_;
+};
+
+namespace internal {
+/**
+ * @brief 64-bit hash of a byte range, four independent 8-byte lanes per step.
+ */
+SEVAL_INLINE uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) {
+    static const uint64_t k0 = 0x9E3779B97F4A7C15ULL;
+    static const uint64_t k1 = 0xC2B2AE3D27D4EB4FULL;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t lanes[4] = { seed ^ k0, seed ^ k1, seed + k0, seed - k1 };
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * l, 8);
+            lanes[l] = (lanes[l] ^ w) * k1;
+            lanes[l] = (lanes[l] << 31) | (lanes[l] >> 33);
+        }
+    }
+
+    uint64_t h = lanes[0] ^ (lanes[1] * k0) ^ ((lanes[2] << 17) | (lanes[2] >> 47)) ^ (lanes[3] * k1) ^ static_cast<uint64_t>(size);
+    for (; i < size; ++i) {
+        h = (h ^ p[i]) * k0;
+    }
+    h ^= h >> 29;
+    h *= k1;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief Header of a cache file; the values and error rows follow at the recorded offsets.
+ */
+struct cache_header {
+    char magic[8];         /* "SEVALCOL" */
+    uint32_t version;
+    uint32_t byteOrder;    /* 0x01020304 as written by the producing machine */
+    uint32_t typeTag;      /* sizeof(T), integral and signedness bits */
+    uint32_t delimiter;
+    uint64_t sourceId;     /* see source_id */
+    uint64_t fileSize;
+    int64_t mtime;
+    uint32_t mtimeNsec;
+    uint32_t reserved;
+    uint64_t contentHash;
+    uint64_t rows;
+    uint64_t errorCount;
+    uint64_t valuesOffset;
+    uint64_t errorsOffset;
+};
+
+static const uint32_t cache_version = 2;
+static const uint32_t cache_byte_order = 0x01020304u;
+static const size_t cache_alignment = 64;
+
+template <typename T>
+SEVAL_INLINE uint32_t type_tag() {
+    return static_cast<uint32_t>(sizeof(T)) | (_TypeTraitsSpace::is_integral<T>::value ? 0x100u : 0u) |
+           (_TypeTraitsSpace::is_floating_point<T>::value ? 0x200u : 0u) | (static_cast<T>(-1) < static_cast<T>(0) ? 0x400u : 0u);
+}
+
+SEVAL_INLINE size_t align_up(size_t n) {
+    return (n + cache_alignment - 1) & ~(cache_alignment - 1);
+}
+
+/* alignment of T without alignof, which C++98 lacks */
+template <typename T>
+struct alignment_ {
+    struct probe {
+        char c;
+        T t;
+    };
+    static const size_t value = sizeof(probe) - sizeof(T);
+};
+
+/* whether `count` elements of `element` bytes at `offset` lie inside `size` bytes, without overflowing */
+SEVAL_INLINE bool fits(uint64_t offset, uint64_t count, size_t element, size_t size) {
+    return offset <= size && count <= (size - static_cast<size_t>(offset)) / element;
+}
+
+/**
+ * @brief Identifies the file behind `path`: its device and inode, so that links and differently
+ *        spelled paths share a cache file, or the path itself where there are no inodes.
+ */
+SEVAL_INLINE uint64_t source_id(const mapped_file& source, const char* path) {
+    if (source.inode() == 0) return hash_bytes(path, strlen(path));
+    uint64_t id[2] = { source.device(), source.inode() };
+    return hash_bytes(id, sizeof(id));
+}
+
+/* the cache file name's key: one file per source, element type and delimiter */
+SEVAL_INLINE uint64_t cache_key(uint64_t sourceId, uint32_t typeTag, char delimiter) {
+    return sourceId ^ (static_cast<uint64_t>(typeTag) << 32) ^ static_cast<unsigned char>(delimiter);
+}
+} /* internal */
+
+/**
+ * @brief Evaluates a text file as a delimited column.
+ *
+ * @param path The path of the file.
+ * @param delimiter The field delimiter.
+ * @param values Receives one value per field; invalid fields are stored as 0.
+ * @param errors If not `NULL`, receives the row index of every invalid field.
+ *
+ * @return `true` if the file could be read, otherwise `false`.
+ */
+template <typename T>
+SEVAL_INLINE bool parse_file(const char* path, char delimiter, std::vector<T>& values, std::vector<size_t>* errors = NULL) {
+    mapped_file source;
+    if (!source.open(path)) return false;
+    batch::parse_column<T>(source.data(), source.size(), delimiter, values, errors);
+    return true;
+}
+
+/**
+ * @struct cache_options
+ * @brief Where and how `load_column` caches parsed columns.
+ */
+struct cache_options {
+    std::string directory; /**< Directory of the cache files (must exist). */
+    bool verifyContent;    /**< Also compare the content hash, not just path, size and mtime (default is `true`). */
+
+    explicit cache_options(const std::string& directory_ = ".") : directory(directory_), verifyContent(true) {}
+};
+
+template <typename T>
+class column;
+
+template <typename T>
+SEVAL_INLINE bool load_column(const char* path, char delimiter, column<T>& out, const cache_options* cache = NULL);
+
+/**
+ * @class column
+ * @brief Typed column loaded by `load_column`: either mapped from a cache file or freshly parsed.
+ */
+template <typename T>
+class column {
+public:
+    column() : values_(NULL), errors_(NULL), size_(0), errorCount_(0), fromCache_(false) {}
+
+    const T* values() const { return values_; }               /**< One value per row (0 for invalid fields). */
+    size_t size() const { return size_; }                     /**< Number of rows. */
+    const uint64_t* errors() const { return errors_; }        /**< Row indexes of the invalid fields, ascending. */
+    size_t errorCount() const { return errorCount_; }         /**< Number of invalid fields. */
+    bool fromCache() const { return fromCache_; }             /**< Whether the column was mapped from a cache file. */
+
+    T operator[](size_t row) const { return values_[row]; }
+
+private:
+    column(const column&);
+    column& operator=(const column&);
+
+    template <typename U>
+    friend bool load_column(const char* path, char delimiter, column<U>& out, const cache_options* cache);
+
+    void reset() {
+        cache_.close();
+        parsedValues_.clear();
+        parsedErrors_.clear();
+        values_ = NULL;
+        errors_ = NULL;
+        size_ = 0;
+        errorCount_ = 0;
+        fromCache_ = false;
+    }
+
+    mapped_file cache_;
+    std::vector<T> parsedValues_;
+    std::vector<uint64_t> parsedErrors_;
+    const T* values_;
+    const uint64_t* errors_;
+    size_t size_;
+    size_t errorCount_;
+    bool fromCache_;
+};
+
+namespace internal {
+SEVAL_INLINE std::string cache_path(const cache_options& cache, uint64_t key) {
+    static const char digits[] = "0123456789abcdef";
+    std::string path = cache.directory;
+    if (!path.empty() && path[path.size() - 1] != '/') path += '/';
+    path += "seval-";
+    for (int shift = 60; shift >= 0; shift -= 4) path += digits[(key >> shift) & 0xF];
+    path += ".col";
+    return path;
+}
+
+/**
+ * @brief Writes a cache file next to its final name and renames it into place.
+ */
+template <typename T>
+SEVAL_INLINE bool write_cache(const std::string& path, cache_header header, const std::vector<T>& values, const std::vector<uint64_t>& errors) {
+    header.valuesOffset = align_up(sizeof(cache_header));
+    header.errorsOffset = align_up(static_cast<size_t>(header.valuesOffset) + values.size() * sizeof(T));
+
+    std::string temporary = path + ".tmp";
+#if defined(SEVAL_FILE_MMAP)
+    char pid[24];
+    snprintf(pid, sizeof(pid), ".%ld", static_cast<long>(getpid()));
+    temporary += pid;
+#endif
+
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (!f) return false;
+
+    static const char zeros[cache_alignment] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && fwrite(zeros, 1, static_cast<size_t>(header.valuesOffset) - sizeof(header), f) == static_cast<size_t>(header.valuesOffset) - sizeof(header);
+    ok = ok && (values.empty() || fwrite(&values[0], sizeof(T), values.size(), f) == values.size());
+    size_t padding = static_cast<size_t>(header.errorsOffset - header.valuesOffset) - values.size() * sizeof(T);
+    ok = ok && fwrite(zeros, 1, padding, f) == padding;
+    ok = ok && (errors.empty() || fwrite(&errors[0], sizeof(uint64_t), errors.size(), f) == errors.size());
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+} /* internal */
+
+/**
+ * @brief Loads a text file as a typed column, optionally through a binary cache.
+ *
+ * Without `cache` this is `parse_file` with the result stored in `out`. With `cache`, a cache file
+ * named after the file (its device and inode), element type and delimiter is looked up in
+ * `cache->directory`. It is used only if it was produced from the same file with the same size,
+ * modification time (to the nanosecond where the platform records it) and (when `verifyContent`
+ * is set) content hash, and its sections are in bounds and aligned for `T`; it is then
+ * memory-mapped and nothing is parsed. Otherwise the file is parsed and the cache file is
+ * (re)written; failing to write it is not an error.
+ *
+ * Cache files use the native byte order and type layout and are rejected on other machines.
+ *
+ * @param path The path of the text file.
+ * @param delimiter The field delimiter.
+ * @param out Receives the column.
+ * @param cache The cache settings, or `NULL` to parse unconditionally.
+ *
+ * @return `true` if the column could be loaded, otherwise `false`.
+ */
+template <typename T>
+SEVAL_INLINE bool load_column(const char* path, char delimiter, column<T>& out, const cache_options* cache) {
+    out.reset();
+
+    mapped_file source;
+    if (!source.open(path)) return false;
+
+    internal::cache_header key;
+    memset(&key, 0, sizeof(key));
+    memcpy(key.magic, "SEVALCOL", 8);
+    key.version = internal::cache_version;
+    key.byteOrder = internal::cache_byte_order;
+    key.typeTag = internal::type_tag<T>();
+    key.delimiter = static_cast<unsigned char>(delimiter);
+    key.sourceId = internal::source_id(source, path);
+    key.fileSize = source.size();
+    key.mtime = source.mtime();
+    key.mtimeNsec = source.mtime_nsec();
+
+    std::string cachePath;
+    bool contentHashed = false;
+
+    if (cache) {
+        cachePath = internal::cache_path(*cache, internal::cache_key(key.sourceId, key.typeTag, delimiter));
+
+        if (out.cache_.open(cachePath.c_str()) && out.cache_.size() >= sizeof(internal::cache_header)) {
+            internal::cache_header header;
+            memcpy(&header, out.cache_.data(), sizeof(header));
+
+            bool match = memcmp(header.magic, key.magic, 8) == 0 && header.version == key.version && header.byteOrder == key.byteOrder &&
+                         header.typeTag == key.typeTag && header.delimiter == key.delimiter && header.sourceId == key.sourceId &&
+                         header.fileSize == key.fileSize && header.mtime == key.mtime && header.mtimeNsec == key.mtimeNsec &&
+                         internal::fits(header.valuesOffset, header.rows, sizeof(T), out.cache_.size()) &&
+                         internal::fits(header.errorsOffset, header.errorCount, sizeof(uint64_t), out.cache_.size()) &&
+                         header.valuesOffset % internal::alignment_<T>::value == 0 &&
+                         header.errorsOffset % internal::alignment_<uint64_t>::value == 0;
+
+            if (match && cache->verifyContent) {
+                key.contentHash = internal::hash_bytes(source.data(), source.size());
+                contentHashed = true;
+                match = header.contentHash == key.contentHash;
+            }
+
+            if (match) {
+                out.values_ = reinterpret_cast<const T*>(out.cache_.data() + header.valuesOffset);
+                out.errors_ = reinterpret_cast<const uint64_t*>(out.cache_.data() + header.errorsOffset);
+                out.size_ = static_cast<size_t>(header.rows);
+                out.errorCount_ = static_cast<size_t>(header.errorCount);
+                out.fromCache_ = true;
+                return true;
+            }
+        }
+        out.cache_.close();
+    }
+
+    std::vector<size_t> errors;
+    batch::parse_column<T>(source.data(), source.size(), delimiter, out.parsedValues_, &errors);
+    out.parsedErrors_.assign(errors.begin(), errors.end());
+
+    out.values_ = out.parsedValues_.empty() ? NULL : &out.parsedValues_[0];
+    out.errors_ = out.parsedErrors_.empty() ? NULL : &out.parsedErrors_[0];
+    out.size_ = out.parsedValues_.size();
+    out.errorCount_ = out.parsedErrors_.size();
+
+    if (cache) {
+        if (!contentHashed) key.contentHash = internal::hash_bytes(source.data(), source.size());
+        key.rows = out.size_;
+        key.errorCount = out.errorCount_;
+        internal::write_cache<T>(cachePath, key, out.parsedValues_, out.parsedErrors_);
+    }
+    return true;
+}
+
+} /* file */
+
+} /* seval */
+
+#endif // SEVAL_FILE_HPP_LOADED
@@ -0,0 +1,571 @@
+/**
+ * @file seval_jit.hpp
+ * @brief Native x86-64 tier for hot compiled expressions.
+ *
+ * `jit_program` translates a bytecode `program` (see seval_vm.hpp) to SSE2 machine code: a scalar
+ * function that evaluates one row on the VM's register file, and, for programs without library
+ * calls, a packed function that evaluates two rows per iteration over whole `double` columns. The
+ * code is written to anonymous pages that are made executable only after they are filled, so no
+ * page is ever writable and executable at once, and no JIT library is needed.
+ *
+ * `tiered_program` starts every program on the bytecode VM and switches to native code once it has
+ * evaluated `threshold` rows. Integer arithmetic on literals is folded at translation time under
+ * the program's `overflow_mode`. Programs with integer variables (see `expression::declare`), an
+ * integer division by zero or a trapped integer overflow, which the VM reports, platforms other
+ * than x86-64 System V, and builds defining `SEVAL_NO_JIT` keep running on the VM with identical
+ * results.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_JIT_HPP_LOADED)
+#define SEVAL_JIT_HPP_LOADED
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "seval_vm.hpp"
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__)) && !defined(SEVAL_NO_JIT)
+#define SEVAL_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace seval {
+
+namespace expr {
+
+namespace internal {
+/* out-of-line targets for the calls emitted for VM_MOD_F and VM_POW_F */
+SEVAL_INLINE double jit_fmod(double x, double y) { return fmod(x, y); }
+SEVAL_INLINE double jit_pow(double x, double y) { return pow(x, y); }
+
+/**
+ * @brief Byte buffer with the handful of SSE2 encodings the JIT needs.
+ *
+ * The register file is addressed as `[rbx + disp32]`; `xmm0` is the accumulator and `xmm1` a
+ * scratch register. `Prefix` 0xF2 selects the scalar (`sd`) forms and 0x66 the packed (`pd`) ones.
+ */
+class assembler {
+public:
+    std::vector<uint8_t> code;
+
+    void byte(uint8_t b) { code.push_back(b); }
+
+    void bytes(const uint8_t* b, size_t n) { code.insert(code.end(), b, b + n); }
+
+    void u32(uint32_t v) {
+        for (int k = 0; k < 4; ++k) byte(static_cast<uint8_t>(v >> (8 * k)));
+    }
+
+    void u64(uint64_t v) {
+        for (int k = 0; k < 8; ++k) byte(static_cast<uint8_t>(v >> (8 * k)));
+    }
+
+    /* <prefix> 0F <op> xmm, [rbx + disp32] */
+    void sse_mem(uint8_t prefix, uint8_t op, unsigned xmm, uint32_t disp) {
+        byte(prefix);
+        byte(0x0F);
+        byte(op);
+        byte(static_cast<uint8_t>(0x83 | (xmm << 3)));
+        u32(disp);
+    }
+
+    /* 66 0F <op> xmm0, xmm1 */
+    void sse_xmm0_xmm1(uint8_t op) {
+        static const uint8_t prefix[] = { 0x66, 0x0F };
+        bytes(prefix, sizeof(prefix));
+        byte(op);
+        byte(0xC1);
+    }
+
+    /* xmm1 = all ones shifted into the abs (0x7FF...) or sign (0x800...) mask */
+    void mask(bool sign) {
+        static const uint8_t ones[] = { 0x66, 0x0F, 0x76, 0xC9 };        /* pcmpeqd xmm1, xmm1 */
+        static const uint8_t shr[] = { 0x66, 0x0F, 0x73, 0xD1, 0x01 };   /* psrlq xmm1, 1 */
+        static const uint8_t shl[] = { 0x66, 0x0F, 0x73, 0xF1, 0x3F };   /* psllq xmm1, 63 */
+        bytes(ones, sizeof(ones));
+        if (sign) bytes(shl, sizeof(shl)); else bytes(shr, sizeof(shr));
+    }
+
+    void prologue() {
+        static const uint8_t b[] = { 0x53, 0x48, 0x89, 0xFB };          /* push rbx; mov rbx, rdi */
+        bytes(b, sizeof(b));
+    }
+
+    void epilogue() {
+        static const uint8_t b[] = { 0x5B, 0xC3 };                      /* pop rbx; ret */
+        bytes(b, sizeof(b));
+    }
+
+    /* mov rax, imm64; mov [rbx + disp32], rax (once per lane) */
+    void store_immediate(const slot& value, uint32_t disp, uint32_t lanes) {
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        byte(0x48);
+        byte(0xB8);
+        u64(bits);
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            byte(0x48);
+            byte(0x89);
+            byte(0x83);
+            u32(disp + 8 * lane);
+        }
+    }
+
+    /* patches the rel32 ending at `end` to jump to `target` */
+    void patch(size_t end, size_t target) {
+        uint32_t rel = static_cast<uint32_t>(static_cast<int32_t>(target) - static_cast<int32_t>(end));
+        for (int k = 0; k < 4; ++k) code[end - 4 + k] = static_cast<uint8_t>(rel >> (8 * k));
+    }
+};
+
+/**
+ * @brief Finds the instructions whose operands are all constants and evaluates them on the VM.
+ *
+ * `known[k]` tells whether instruction `k` was folded and `values[k]` holds its result; the JIT
+ * stores such results as immediates, which is how integer sub-expressions of literals (the only
+ * integer arithmetic of a program without integer variables) reach native code.
+ */
+SEVAL_INLINE void fold_constants(const program& p, std::vector<uint8_t>& known, std::vector<slot>& values) {
+    std::vector<uint8_t> regKnown(p.registers, 0);
+    std::vector<slot> regs(p.registers);
+    for (size_t k = 0; k < p.constants.size(); ++k) {
+        regKnown[k] = 1;
+        regs[k] = p.constants[k];
+    }
+
+    known.assign(p.code.size(), 0);
+    values.resize(p.code.size());
+
+    program step;
+    step.registers = p.registers;
+    step.overflow = p.overflow;
+    step.positions.assign(2, 0);
+    step.code.resize(2);
+    step.code[1].op = VM_RET;
+
+    for (size_t k = 0; k + 1 < p.code.size(); ++k) {
+        const instruction& in = p.code[k];
+        if (regKnown[in.a] && regKnown[in.b]) {
+            step.code[0] = in;
+            step.code[1].a = in.dst;
+            known[k] = execute(step, &regs[0], values[k], NULL) ? 1 : 0;
+        }
+        regKnown[in.dst] = known[k];
+    }
+}
+
+/**
+ * @brief Emits the body of a program. Returns `false` on an instruction the JIT does not handle.
+ *
+ * Scalar code stores folded results as immediates where the VM would compute them. Packed code runs
+ * in a loop, so folded results get registers of their own after `p.registers`, which the caller
+ * fills once before the loop in `fold_constants` order.
+ *
+ * @param packed Two rows per register (16-byte registers, `pd` forms, no library calls).
+ * @param result Receives the register holding the result.
+ */
+SEVAL_INLINE bool emit_body(const program& p, assembler& as, bool packed, uint32_t& result) {
+    const uint8_t prefix = packed ? 0x66 : 0xF2;
+    const uint32_t stride = packed ? 16 : 8;
+    uint32_t live = 0xFFFFFFFFu; /* register whose value is still in xmm0 */
+
+    std::vector<uint8_t> known;
+    std::vector<slot> values;
+    fold_constants(p, known, values);
+
+    std::vector<uint32_t> alias(p.registers); /* where the current value of each register lives */
+    for (uint32_t r = 0; r < p.registers; ++r) alias[r] = r;
+    uint32_t shadow = p.registers;
+
+    for (size_t k = 0; k < p.code.size(); ++k) {
+        const instruction& in = p.code[k];
+        uint32_t a = alias[in.a], b = alias[in.b];
+        uint8_t op = 0;
+
+        if (known[k]) {
+            if (packed) {
+                alias[in.dst] = shadow++;
+            } else {
+                as.store_immediate(values[k], static_cast<uint32_t>(in.dst) * stride, 1);
+                if (live == in.dst) live = 0xFFFFFFFFu;
+            }
+            continue;
+        }
+
+        switch (in.op) {
+        case VM_RET:
+            result = a;
+            return k + 1 == p.code.size();
+
+        case VM_CVT: {
+            if (packed) return false; /* no packed int64 conversion in SSE2 */
+            static const uint8_t cvt[] = { 0xF2, 0x48, 0x0F, 0x2A, 0x83 }; /* cvtsi2sd xmm0, qword [rbx + disp32] */
+            as.bytes(cvt, sizeof(cvt));
+            as.u32(a * stride);
+            break;
+        }
+
+        case VM_ADD_F: op = 0x58; break;
+        case VM_MUL_F: op = 0x59; break;
+        case VM_SUB_F: op = 0x5C; break;
+        case VM_DIV_F: op = 0x5E; break;
+        case VM_MIN_F: op = 0x5D; a = alias[in.b]; b = alias[in.a]; break; /* minsd keeps the second operand unless the first is lower */
+        case VM_MAX_F: op = 0x5F; a = alias[in.b]; b = alias[in.a]; break;
+
+        case VM_SQRT_F:
+            as.sse_mem(prefix, 0x51, 0, a * stride);
+            break;
+
+        case VM_NEG_F:
+        case VM_ABS_F:
+            if (live != a) as.sse_mem(prefix, 0x10, 0, a * stride);
+            as.mask(in.op == VM_NEG_F);
+            as.sse_xmm0_xmm1(in.op == VM_NEG_F ? 0x57 : 0x54); /* xorpd / andpd */
+            break;
+
+        case VM_MOD_F:
+        case VM_POW_F: {
+            if (packed) return false;
+            double (*target)(double, double) = in.op == VM_MOD_F ? &jit_fmod : &jit_pow;
+            if (live != a) as.sse_mem(0xF2, 0x10, 0, a * stride);
+            as.sse_mem(0xF2, 0x10, 1, b * stride);
+            as.byte(0x48);                                                  /* mov rax, imm64 */
+            as.byte(0xB8);
+            as.u64(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(target)));
+            as.byte(0xFF);                                                  /* call rax */
+            as.byte(0xD0);
+            break;
+        }
+
+        default:
+            return false;
+        }
+
+        if (op != 0) {
+            if (live != a) as.sse_mem(prefix, 0x10, 0, a * stride);
+            as.sse_mem(prefix, op, 0, b * stride);
+        }
+        as.sse_mem(prefix, 0x11, 0, static_cast<uint32_t>(in.dst) * stride);
+        alias[in.dst] = in.dst;
+        live = in.dst;
+    }
+    return false;
+}
+
+/**
+ * @brief `void f(slot* r)`: runs the program on a register file; the result stays in its register.
+ */
+SEVAL_INLINE bool emit_scalar(const program& p, assembler& as) {
+    uint32_t result = 0;
+    as.prologue();
+    if (!emit_body(p, as, false, result)) return false;
+    as.epilogue();
+    return true;
+}
+
+/**
+ * @brief `void f(slot* r, const double* const* columns, double* out, size_t pairs)`: evaluates
+ * `2 * pairs` rows; `r` holds every register twice and must be 16-byte aligned.
+ *
+ * @param registers Receives the number of registers the function uses.
+ */
+SEVAL_INLINE bool emit_packed(const program& p, assembler& as, uint32_t& registers) {
+    static const uint8_t enter[] = {
+        0x48, 0x85, 0xC9,                   /* test rcx, rcx */
+        0x0F, 0x84, 0, 0, 0, 0,             /* jz done */
+        0x45, 0x31, 0xC0,                   /* xor r8d, r8d */
+    };
+    static const uint8_t load[] = { 0x66, 0x42, 0x0F, 0x10, 0x04, 0x00 };  /* movupd xmm0, [rax + r8] */
+    static const uint8_t store[] = { 0x66, 0x42, 0x0F, 0x11, 0x04, 0x02 }; /* movupd [rdx + r8], xmm0 */
+    static const uint8_t next[] = {
+        0x49, 0x83, 0xC0, 0x10,             /* add r8, 16 */
+        0x48, 0xFF, 0xC9,                   /* dec rcx */
+        0x0F, 0x85, 0, 0, 0, 0,             /* jnz loop */
+    };
+
+    if (p.resultKind != KIND_FLOAT) return false;
+
+    as.prologue();
+
+    std::vector<uint8_t> known;
+    std::vector<slot> values;
+    fold_constants(p, known, values);
+    registers = p.registers;
+    for (size_t k = 0; k < known.size(); ++k) {
+        if (known[k]) as.store_immediate(values[k], registers++ * 16, 2);
+    }
+
+    as.bytes(enter, sizeof(enter));
+    size_t skip = as.code.size() - 3;
+    size_t loop = as.code.size();
+
+    uint32_t base = p.variable_base();
+    for (size_t v = 0; v < p.variables.size(); ++v) {
+        as.byte(0x48);                      /* mov rax, [rsi + disp32] */
+        as.byte(0x8B);
+        as.byte(0x86);
+        as.u32(static_cast<uint32_t>(v * sizeof(const double*)));
+        as.bytes(load, sizeof(load));
+        as.sse_mem(0x66, 0x11, 0, static_cast<uint32_t>(base + v) * 16);
+    }
+    uint32_t result = 0;
+    if (!emit_body(p, as, true, result)) return false;
+
+    as.sse_mem(0x66, 0x10, 0, result * 16);
+    as.bytes(store, sizeof(store));
+    as.bytes(next, sizeof(next));
+    as.patch(as.code.size(), loop);
+    as.patch(skip, as.code.size());
+    as.epilogue();
+    return true;
+}
+
+/**
+ * @brief Read-only executable copy of generated code; unmapped on destruction.
+ */
+class native_code {
+public:
+    native_code() : mem_(NULL), size_(0) {}
+    ~native_code() { reset(); }
+
+    bool load(const std::vector<uint8_t>& code) {
+        reset();
+#if defined(SEVAL_JIT)
+        long page = sysconf(_SC_PAGESIZE);
+        size_t size = (code.size() + static_cast<size_t>(page) - 1) & ~(static_cast<size_t>(page) - 1);
+        void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (mem == MAP_FAILED) return false;
+        memcpy(mem, &code[0], code.size());
+        if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(mem, size);
+            return false;
+        }
+        mem_ = mem;
+        size_ = size;
+        return true;
+#else
+        (void)code;
+        return false;
+#endif
+    }
+
+    void reset() {
+#if defined(SEVAL_JIT)
+        if (mem_) munmap(mem_, size_);
+#endif
+        mem_ = NULL;
+        size_ = 0;
+    }
+
+    uintptr_t entry() const { return reinterpret_cast<uintptr_t>(mem_); }
+
+private:
+    native_code(const native_code&);
+    native_code& operator=(const native_code&);
+
+    void* mem_;
+    size_t size_;
+};
+} /* internal */
+
+/**
+ * @brief Whether this build can generate native code.
+ */
+SEVAL_INLINE bool jit_available() {
+#if defined(SEVAL_JIT)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @class jit_program
+ * @brief Native code for one program.
+ *
+ * The program is copied, so the source may be discarded. Not copyable.
+ */
+class jit_program {
+public:
+    typedef void (*scalar_fn)(slot*);
+    typedef void (*packed_fn)(slot*, const double* const*, double*, size_t);
+
+    jit_program() : scalar_(NULL), packed_(NULL), packedRegisters_(0) {}
+
+    /**
+     * @brief Translates a program.
+     * @return `true` if at least the scalar function was generated; programs with integer
+     *         variables are left to the VM, which checks the values they are bound to.
+     */
+    bool compile(const program& p) {
+        scalar_ = NULL;
+        packed_ = NULL;
+        program_ = p;
+        if (!jit_available() || p.code.empty()) return false;
+        for (size_t v = 0; v < p.variables.size(); ++v) {
+            if (p.variable_kind(v) != KIND_FLOAT) return false;
+        }
+
+        internal::assembler scalar;
+        if (!internal::emit_scalar(p, scalar) || !scalarCode_.load(scalar.code)) return false;
+        scalar_ = reinterpret_cast<scalar_fn>(scalarCode_.entry());
+
+        internal::assembler packed;
+        if (internal::emit_packed(p, packed, packedRegisters_) && packedCode_.load(packed.code)) {
+            packed_ = reinterpret_cast<packed_fn>(packedCode_.entry());
+        }
+        return true;
+    }
+
+    /** @brief Whether a scalar function is available. */
+    bool scalar() const { return scalar_ != NULL; }
+
+    /** @brief Whether a packed column function is available. */
+    bool packed() const { return packed_ != NULL; }
+
+    /** @brief The translated program. */
+    const program& source() const { return program_; }
+
+    /**
+     * @brief Evaluates one row (laid out as for `seval::expr::run(const program&, const double*, ...)`).
+     */
+    void run(const double* row, value& result) const {
+        internal::register_file regs(program_);
+        slot* r = regs.get();
+        internal::load_row(program_, row, r, NULL); /* only double variables, which take any value */
+
+        scalar_(r);
+        const slot& s = r[program_.code.back().a];
+        result.kind = program_.resultKind;
+        if (program_.resultKind == KIND_INT) result.i = s.i; else result.f = s.f;
+    }
+
+    /**
+     * @brief Evaluates `rows` rows of `double` columns (requires `packed()`).
+     */
+    void run_columns(const double* const* columns, size_t rows, double* out) const {
+        std::vector<slot> storage(2 * static_cast<size_t>(packedRegisters_) + 2);
+        slot* r = &storage[0];
+        if (reinterpret_cast<uintptr_t>(r) & 15) ++r;
+        for (size_t k = 0; k < program_.constants.size(); ++k) r[2 * k] = r[2 * k + 1] = program_.constants[k];
+
+        packed_(r, columns, out, rows / 2);
+        if (rows & 1) {
+            internal::register_file regs(program_);
+            slot* last = regs.get();
+            uint32_t base = program_.variable_base();
+            for (size_t v = 0; v < program_.variables.size(); ++v) last[base + v].f = columns[v][rows - 1];
+            scalar_(last);
+            out[rows - 1] = last[program_.code.back().a].f;
+        }
+    }
+
+private:
+    jit_program(const jit_program&);
+    jit_program& operator=(const jit_program&);
+
+    program program_;
+    internal::native_code scalarCode_;
+    internal::native_code packedCode_;
+    scalar_fn scalar_;
+    packed_fn packed_;
+    uint32_t packedRegisters_;
+};
+
+/**
+ * @class tiered_program
+ * @brief Runs a program on the bytecode VM until it is hot, then on native code.
+ *
+ * Not copyable, and not safe to run from several threads at once (the row counter and the tier-up
+ * are unsynchronized).
+ */
+class tiered_program {
+public:
+    /**
+     * @param p The program (copied).
+     * @param threshold Rows evaluated on the VM before the JIT is tried (default is 1000; 0 compiles
+     *        on the first run).
+     */
+    explicit tiered_program(const program& p, uint64_t threshold = 1000)
+        : program_(p), threshold_(threshold), rows_(0), tried_(false) {}
+
+    /**
+     * @brief Evaluates one row (laid out as for `seval::expr::run(const program&, const double*, ...)`).
+     * @return `false` for integer division or modulo by zero and trapped overflow (only possible on the VM tier).
+     */
+    bool run(const double* row, value& result, error* err = NULL) {
+        if (tier_up(1)) {
+            jit_.run(row, result);
+            return true;
+        }
+        return expr::run(program_, row, result, err);
+    }
+
+    /**
+     * @brief Evaluates one row with variables bound by name.
+     */
+    bool run(const bindings& vars, value& result, error* err = NULL) {
+        std::vector<double> row;
+        if (!internal::bind_row(program_, vars, row, err)) return false;
+        return run(row.empty() ? NULL : &row[0], result, err);
+    }
+
+    /**
+     * @brief Evaluates every row of a set of columns (see `seval::expr::run_columns`); the packed
+     * native code is used once hot if every column holds doubles.
+     */
+    bool run_columns(const column_ref* columns, size_t rows, double* out, error* err = NULL) {
+        if (tier_up(rows) && jit_.packed()) {
+            std::vector<const double*> ptrs(program_.variables.size());
+            bool doubles = true;
+            for (size_t v = 0; v < ptrs.size(); ++v) {
+                doubles = doubles && columns[v].kind == KIND_FLOAT;
+                ptrs[v] = static_cast<const double*>(columns[v].data);
+            }
+            if (doubles) {
+                jit_.run_columns(ptrs.empty() ? NULL : &ptrs[0], rows, out);
+                return true;
+            }
+        }
+        return expr::run_columns(program_, columns, rows, out, err);
+    }
+
+    /** @brief The program. */
+    const program& source() const { return program_; }
+
+    /** @brief Whether native code is in use. */
+    bool native() const { return jit_.scalar(); }
+
+    /** @brief Rows evaluated so far. */
+    uint64_t rows() const { return rows_; }
+
+private:
+    tiered_program(const tiered_program&);
+    tiered_program& operator=(const tiered_program&);
+
+    /* counts rows and compiles once the threshold is crossed; true if native code is ready */
+    bool tier_up(size_t rows) {
+        rows_ += rows;
+        if (!tried_ && rows_ > threshold_) {
+            tried_ = true;
+            jit_.compile(program_);
+        }
+        return jit_.scalar();
+    }
+
+    program program_;
+    jit_program jit_;
+    uint64_t threshold_;
+    uint64_t rows_;
+    bool tried_;
+};
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_JIT_HPP_LOADED
@@ -0,0 +1,669 @@
+/**
+ * @file seval_kernels.hpp
+ * @brief Specialized kernels for the commonest field shape: an optionally signed run of decimal digits.
+ *
+ * Each kernel turns up to 19 digits into a `uint64_t` and reports whether every byte was a digit:
+ * - `KERNEL_SCALAR` loops over the digits one by one.
+ * - `KERNEL_LENGTH_SWITCH` jumps into an unrolled ladder on the digit count.
+ * - `KERNEL_SWAR8` converts 8 digits at a time inside a 64-bit register.
+ * - `KERNEL_SIMD16` converts up to 16 digits at once with SSE2.
+ *
+ * SWAR8 and SIMD16 load whole words that end at the end of the field and mask off the bytes before
+ * it, so they need that many readable bytes in front of the field (`lead`); batch callers know the
+ * start of their buffer and pass the distance to it. When the lead is too short, the kernels
+ * handle the first digits one by one instead.
+ *
+ * `parse_field` puts a kernel behind the exact contract of `seval::evaluate_field`: fields that are
+ * not plain digits (prefixes, fractions, exponents, errors) or too long to convert exactly go
+ * to `evaluate_field` itself, so results never depend on the kernel.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_KERNELS_HPP_LOADED)
+#define SEVAL_KERNELS_HPP_LOADED
+
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEVAL_KERNELS_SSE2 1
+#endif
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+#define SEVAL_KERNELS_LITTLE_ENDIAN 1
+#endif
+
+/* The page-safe loads may read past the end of a buffer, within its last page. */
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define SEVAL_KERNELS_NO_SANITIZE __attribute__((no_sanitize("address", "hwaddress")))
+#elif defined(__GNUC__)
+#define SEVAL_KERNELS_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define SEVAL_KERNELS_NO_SANITIZE
+#endif
+
+/* Smallest page size of the supported targets. */
+#if !defined(SEVAL_KERNELS_PAGE_SIZE)
+#define SEVAL_KERNELS_PAGE_SIZE 4096
+#endif // SEVAL_KERNELS_PAGE_SIZE
+
+#include "seval.hpp"
+
+namespace seval {
+
+namespace kernels {
+
+/**
+ * @brief The digit-run kernels.
+ */
+enum kernel_kind {
+    KERNEL_SCALAR = 0,    /**< One digit per step. */
+    KERNEL_LENGTH_SWITCH, /**< Unrolled, entered through a switch on the digit count. */
+    KERNEL_SWAR8,         /**< 8 digits per 64-bit word (little-endian targets). */
+    KERNEL_SIMD16,        /**< 16 digits per SSE2 register. */
+    KERNEL_KIND_COUNT     /**< Number of kernels. */
+};
+
+/**
+ * @brief Name of a kernel, as used in reports.
+ */
+SEVAL_INLINE const char* kernel_name(kernel_kind k) {
+    static const char* const names[KERNEL_KIND_COUNT] = { "scalar", "length_switch", "swar8", "simd16" };
+    return names[k];
+}
+
+/**
+ * @brief Whether a kernel is compiled for this target (the others fall back to `KERNEL_SCALAR`).
+ */
+SEVAL_INLINE bool available(kernel_kind k) {
+    switch (k) {
+#if !defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+    case KERNEL_SWAR8: return false;
+#endif
+#if !defined(SEVAL_KERNELS_SSE2)
+    case KERNEL_SIMD16: return false;
+#endif
+    default: return k < KERNEL_KIND_COUNT;
+    }
+}
+
+/** Longest digit run the kernels convert; 19 digits always fit in 64 bits. */
+static const size_t max_digits = 19;
+
+/** Readable bytes the padded entry points may read past the end of their input. */
+static const size_t padding = 64;
+
+/**
+ * @brief What `parse_field` may skip in front of the digits of a field; combine with `|`.
+ */
+enum trim_option {
+    TRIM_NONE = 0,       /**< Nothing: the exact contract of `evaluate_field`. */
+    TRIM_WHITESPACE = 1, /**< Leading ASCII whitespace (" \t\n\v\f\r"), which `evaluate_field` rejects. */
+    TRIM_ZEROS = 2       /**< Leading zeros of a decimal run ("0000012345"); the value is unchanged. */
+};
+
+namespace internal {
+/**
+ * @brief Counts the trailing zero bits of a non-zero mask.
+ */
+SEVAL_INLINE unsigned ctz32_(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+/**
+ * @brief Converts `n` digits one by one.
+ * @return `false` if a byte is not a digit.
+ */
+SEVAL_INLINE bool scalar_digits(const char* p, size_t n, uint64_t& v) {
+    uint64_t x = 0;
+    for (size_t k = 0; k < n; ++k) {
+        unsigned d = static_cast<unsigned>(static_cast<unsigned char>(p[k])) - '0';
+        if (d > 9) return false;
+        x = x * 10 + d;
+    }
+    v = x;
+    return true;
+}
+
+/**
+ * @brief Converts exactly `N` digits in straight-line code: the loop has a constant trip count and
+ *        is unrolled, and validity is tested once at the end.
+ */
+template <size_t N>
+SEVAL_INLINE bool fixed_digits(const char* p, uint64_t& v) {
+    uint64_t x = 0;
+    unsigned bad = 0;
+    for (size_t k = 0; k < N; ++k) {
+        unsigned d = static_cast<unsigned>(static_cast<unsigned char>(p[k])) - '0';
+        bad |= d > 9;
+        x = x * 10 + d;
+    }
+    v = x;
+    return bad == 0;
+}
+
+template <>
+SEVAL_INLINE bool fixed_digits<0>(const char*, uint64_t& v) {
+    v = 0;
+    return true;
+}
+
+/**
+ * @brief Converts `n <= max_digits` digits with one jump to the `fixed_digits` of that length.
+ */
+SEVAL_INLINE bool switch_digits(const char* p, size_t n, uint64_t& v) {
+    switch (n) {
+    case 1: return fixed_digits<1>(p, v);
+    case 2: return fixed_digits<2>(p, v);
+    case 3: return fixed_digits<3>(p, v);
+    case 4: return fixed_digits<4>(p, v);
+    case 5: return fixed_digits<5>(p, v);
+    case 6: return fixed_digits<6>(p, v);
+    case 7: return fixed_digits<7>(p, v);
+    case 8: return fixed_digits<8>(p, v);
+    case 9: return fixed_digits<9>(p, v);
+    case 10: return fixed_digits<10>(p, v);
+    case 11: return fixed_digits<11>(p, v);
+    case 12: return fixed_digits<12>(p, v);
+    case 13: return fixed_digits<13>(p, v);
+    case 14: return fixed_digits<14>(p, v);
+    case 15: return fixed_digits<15>(p, v);
+    case 16: return fixed_digits<16>(p, v);
+    case 17: return fixed_digits<17>(p, v);
+    case 18: return fixed_digits<18>(p, v);
+    case 19: return fixed_digits<19>(p, v);
+    default: return false;
+    }
+}
+
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+/* whether all 8 bytes of a little-endian word are ASCII digits */
+SEVAL_INLINE bool swar_all_digits(uint64_t x) {
+    return (((x & 0xF0F0F0F0F0F0F0F0ULL) | (((x + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+/* value of 8 digits loaded little-endian (first digit in the lowest byte) */
+SEVAL_INLINE uint32_t swar_eight(uint64_t x) {
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    x = ((x & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    return static_cast<uint32_t>(((x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+
+/* the 8 bytes ending at `end`, with the first `pad` of them replaced by '0' */
+SEVAL_INLINE uint64_t swar_load_tail(const char* end, size_t pad) {
+    uint64_t x;
+    memcpy(&x, end - 8, 8);
+    if (pad != 0) {
+        uint64_t mask = (1ULL << (8 * pad)) - 1;
+        x = (x & ~mask) | (0x3030303030303030ULL & mask);
+    }
+    return x;
+}
+#endif
+
+/**
+ * @brief Converts `n <= max_digits` digits 8 at a time. The first, partial word is loaded with the
+ *        bytes in front of it masked to '0' when `lead` allows, and digit by digit otherwise.
+ */
+SEVAL_INLINE bool swar_digits(const char* p, size_t n, size_t lead, uint64_t& v) {
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+    if (n == 0 || n > max_digits) return false;
+    size_t head = (n - 1) % 8 + 1; /* digits in the first word */
+    uint64_t x = 0;
+    if (head == 8 || lead >= 8 - head) {
+        uint64_t word = swar_load_tail(p + head, 8 - head);
+        if (!swar_all_digits(word)) return false;
+        x = swar_eight(word);
+    } else if (!scalar_digits(p, head, x)) {
+        return false;
+    }
+    for (size_t k = head; k < n; k += 8) {
+        uint64_t word;
+        memcpy(&word, p + k, 8);
+        if (!swar_all_digits(word)) return false;
+        x = x * 100000000ULL + swar_eight(word);
+    }
+    v = x;
+    return true;
+#else
+    (void)lead;
+    return n <= max_digits && scalar_digits(p, n, v);
+#endif
+}
+
+/**
+ * @brief Converts exactly `N` digits without reading outside them: the first `N % 8` one by one,
+ *        the rest as whole 8-byte words. Without word loads this is `fixed_digits<N>`.
+ */
+template <size_t N>
+SEVAL_INLINE bool fixed_words(const char* p, uint64_t& v) {
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+    uint64_t x = 0;
+    unsigned ok = fixed_digits<N % 8>(p, x);
+    for (size_t k = N % 8; k < N; k += 8) {
+        uint64_t word;
+        memcpy(&word, p + k, 8);
+        ok &= swar_all_digits(word);
+        x = x * 100000000ULL + swar_eight(word);
+    }
+    v = x;
+    return ok != 0;
+#else
+    return fixed_digits<N>(p, v);
+#endif
+}
+
+/**
+ * @brief Converts `n <= max_digits` digits with one jump to the `fixed_words` of that length;
+ *        reads nothing outside the digits.
+ */
+SEVAL_INLINE bool words_digits(const char* p, size_t n, uint64_t& v) {
+    switch (n) {
+    case 1: return fixed_words<1>(p, v);
+    case 2: return fixed_words<2>(p, v);
+    case 3: return fixed_words<3>(p, v);
+    case 4: return fixed_words<4>(p, v);
+    case 5: return fixed_words<5>(p, v);
+    case 6: return fixed_words<6>(p, v);
+    case 7: return fixed_words<7>(p, v);
+    case 8: return fixed_words<8>(p, v);
+    case 9: return fixed_words<9>(p, v);
+    case 10: return fixed_words<10>(p, v);
+    case 11: return fixed_words<11>(p, v);
+    case 12: return fixed_words<12>(p, v);
+    case 13: return fixed_words<13>(p, v);
+    case 14: return fixed_words<14>(p, v);
+    case 15: return fixed_words<15>(p, v);
+    case 16: return fixed_words<16>(p, v);
+    case 17: return fixed_words<17>(p, v);
+    case 18: return fixed_words<18>(p, v);
+    case 19: return fixed_words<19>(p, v);
+    default: return false;
+    }
+}
+
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+/* value of the first `head` bytes of `word`, which must be digits; the rest is ignored */
+SEVAL_INLINE bool padded_head(uint64_t word, size_t head, uint64_t& v) {
+    word <<= 8 * (8 - head);
+    word |= 0x3030303030303030ULL & ~(~0ULL << (8 * (8 - head)));
+    if (!swar_all_digits(word)) return false;
+    v = swar_eight(word);
+    return true;
+}
+#endif
+
+/**
+ * @brief Converts `n <= max_digits` digits 8 at a time with forward loads only: the first,
+ *        partial word is loaded from `p` and shifted so its digits end at the top, so runs
+ *        shorter than 8 read up to `8 - n` bytes past their end, which must be readable.
+ */
+SEVAL_KERNELS_NO_SANITIZE SEVAL_INLINE bool padded_digits(const char* p, size_t n, uint64_t& v) {
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+    if (n == 0 || n > max_digits) return false;
+    size_t head = (n - 1) % 8 + 1; /* digits in the first word */
+    uint64_t word, x;
+    memcpy(&word, p, 8);
+    if (!padded_head(word, head, x)) return false;
+    for (size_t k = head; k < n; k += 8) {
+        memcpy(&word, p + k, 8);
+        if (!swar_all_digits(word)) return false;
+        x = x * 100000000ULL + swar_eight(word);
+    }
+    v = x;
+    return true;
+#else
+    return n <= max_digits && scalar_digits(p, n, v);
+#endif
+}
+
+/**
+ * @brief `padded_digits` for a run without padding: short runs whose 8-byte load would cross into
+ *        the next page are loaded byte-exactly instead.
+ */
+SEVAL_INLINE bool page_safe_digits(const char* p, size_t n, uint64_t& v) {
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+    if (n != 0 && n < 8 && (reinterpret_cast<uintptr_t>(p) & (SEVAL_KERNELS_PAGE_SIZE - 1)) > SEVAL_KERNELS_PAGE_SIZE - 8) {
+        uint64_t word = 0;
+        memcpy(&word, p, n);
+        return padded_head(word, n, v);
+    }
+#endif
+    return padded_digits(p, n, v);
+}
+
+SEVAL_INLINE bool is_space_ch(char c) {
+    return c == ' ' || static_cast<unsigned>(static_cast<unsigned char>(c)) - 9u <= 4u;
+}
+
+/**
+ * @brief Number of leading ASCII whitespace bytes among the first `n` bytes of `p`: a vector
+ *        compare and a bit scan per 16 bytes, then byte by byte. Reads nothing past `p + n`.
+ */
+SEVAL_INLINE size_t space_run(const char* p, size_t n) {
+    size_t k = 0;
+#if defined(SEVAL_KERNELS_SSE2)
+    for (; k + 16 <= n; k += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k));
+        __m128i control = _mm_sub_epi8(chunk, _mm_set1_epi8(9)); /* '\t' to '\r' become 0 to 4 */
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                     _mm_cmpeq_epi8(_mm_min_epu8(control, _mm_set1_epi8(4)), control));
+        uint32_t other = static_cast<uint32_t>(_mm_movemask_epi8(space)) ^ 0xFFFFu;
+        if (other != 0) return k + ctz32_(other);
+    }
+#endif
+    while (k < n && is_space_ch(p[k])) ++k;
+    return k;
+}
+
+/**
+ * @brief Number of leading '0' bytes among the first `n` bytes of `p`: 16 bytes per vector
+ *        compare, then 8 per 64-bit word, then byte by byte. Reads nothing past `p + n`.
+ */
+SEVAL_INLINE size_t zero_run(const char* p, size_t n) {
+    size_t k = 0;
+#if defined(SEVAL_KERNELS_SSE2)
+    for (; k + 16 <= n; k += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k));
+        uint32_t other = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('0')))) ^ 0xFFFFu;
+        if (other != 0) return k + ctz32_(other);
+    }
+#endif
+#if defined(SEVAL_KERNELS_LITTLE_ENDIAN)
+    for (; k + 8 <= n; k += 8) {
+        uint64_t x;
+        memcpy(&x, p + k, 8);
+        x ^= 0x3030303030303030ULL;
+        /* the top bit of every byte that was not '0' */
+        uint64_t other = (((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | x) & 0x8080808080808080ULL;
+        if (other != 0) {
+            uint32_t low = static_cast<uint32_t>(other);
+            return k + (low != 0 ? ctz32_(low) : 32 + ctz32_(static_cast<uint32_t>(other >> 32))) / 8;
+        }
+    }
+#endif
+    while (k < n && p[k] == '0') ++k;
+    return k;
+}
+
+#if defined(SEVAL_KERNELS_SSE2)
+/* value of the 16 digits of a register; `false` if a byte is not a digit */
+SEVAL_INLINE bool simd_sixteen(__m128i chunk, uint64_t& v) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i d = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+    __m128i bad = _mm_or_si128(_mm_cmplt_epi8(d, zero), _mm_cmpgt_epi8(d, _mm_set1_epi8(9)));
+    if (_mm_movemask_epi8(bad) != 0) return false;
+
+    __m128i pairs = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(d, zero), _mm_set1_epi32(0x0001000A)),
+                                    _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), _mm_set1_epi32(0x0001000A)));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+    __m128i octets = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set1_epi32(0x00012710));
+    uint64_t hi = static_cast<uint32_t>(_mm_cvtsi128_si32(octets));
+    uint64_t lo = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(octets, 4)));
+    v = hi * 100000000ULL + lo;
+    return true;
+}
+#endif
+
+/**
+ * @brief Converts `n <= max_digits` digits with one 16-byte register for the last 16 of them;
+ *        needs `16 - n` readable bytes in front of short runs, otherwise it uses `swar_digits`.
+ */
+SEVAL_INLINE bool simd_digits(const char* p, size_t n, size_t lead, uint64_t& v) {
+#if defined(SEVAL_KERNELS_SSE2)
+    if (n == 0 || n > max_digits) return false;
+    size_t tail = n < 16 ? n : 16;
+    size_t head = n - tail;
+    if (head == 0 && lead + n < 16) return swar_digits(p, n, lead, v);
+
+    static const unsigned char leadMask[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n - 16));
+    __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(leadMask + tail));
+    chunk = _mm_or_si128(_mm_andnot_si128(mask, chunk), _mm_and_si128(mask, _mm_set1_epi8('0')));
+
+    uint64_t low = 0, high = 0;
+    if (!simd_sixteen(chunk, low)) return false;
+    if (head != 0 && !scalar_digits(p, head, high)) return false;
+    v = high * 10000000000000000ULL + low;
+    return true;
+#else
+    return swar_digits(p, n, lead, v);
+#endif
+}
+
+/**
+ * @brief The accumulators of `parse_digits_interleaved`, one member per lane so they live in
+ *        registers: a `lanes<W>` handles the first of `W` runs and hands the others on to `rest`.
+ */
+template <size_t W>
+struct lanes {
+    _StatAssert(W <= 32, "A lanes<W> holds at most 32 runs, one per bit of the result mask.");
+
+    const char* p;
+    uint64_t x;
+    unsigned top; /* largest byte - '0' seen (as unsigned), above 9 once a byte was not a digit */
+    lanes<W - 1> rest;
+
+    SEVAL_INLINE void init(const char* const* runs) {
+        p = runs[0];
+        x = 0;
+        top = 0;
+        rest.init(runs + 1);
+    }
+
+    /* digit k of every run; all of them are longer than k */
+    SEVAL_INLINE void step(size_t k) {
+        unsigned d = static_cast<unsigned>(static_cast<unsigned char>(p[k])) - '0';
+        top = d > top ? d : top;
+        x = x * 10 + d;
+        rest.step(k);
+    }
+
+    /* digits k to n[0] of the first run, and so on */
+    SEVAL_INLINE void finish(size_t k, const size_t* n) {
+        for (size_t j = k; j < n[0]; ++j) {
+            unsigned d = static_cast<unsigned>(static_cast<unsigned char>(p[j])) - '0';
+            top = d > top ? d : top;
+            x = x * 10 + d;
+        }
+        rest.finish(k, n + 1);
+    }
+
+    /* the values, and bit `bit` up of the mask for the runs that were all digits */
+    SEVAL_INLINE uint32_t store(uint64_t* v, uint32_t bit) const {
+        v[0] = x;
+        return (top <= 9 ? bit : 0) | rest.store(v + 1, bit << 1);
+    }
+};
+
+template <>
+struct lanes<0> {
+    SEVAL_INLINE void init(const char* const*) {}
+    SEVAL_INLINE void step(size_t) {}
+    SEVAL_INLINE void finish(size_t, const size_t*) {}
+    SEVAL_INLINE uint32_t store(uint64_t*, uint32_t) const { return 0; }
+};
+} /* internal */
+
+/**
+ * @brief Converts a run of `n` decimal digits with the given kernel.
+ *
+ * @param kind The kernel (unavailable ones run as `KERNEL_SCALAR`).
+ * @param p The first digit.
+ * @param n The number of digits, at most `max_digits`.
+ * @param lead How many bytes in front of `p` may be read (see the file comment).
+ * @param v Receives the value.
+ *
+ * @return `false` if `n` is 0 or above `max_digits`, or a byte is not a digit.
+ */
+SEVAL_INLINE bool parse_digits(kernel_kind kind, const char* p, size_t n, size_t lead, uint64_t& v) {
+    if (n == 0 || n > max_digits) return false;
+    switch (kind) {
+    case KERNEL_LENGTH_SWITCH: return internal::switch_digits(p, n, v);
+    case KERNEL_SWAR8: return internal::swar_digits(p, n, lead, v);
+    case KERNEL_SIMD16: return internal::simd_digits(p, n, lead, v);
+    default: return internal::scalar_digits(p, n, v);
+    }
+}
+
+/**
+ * @brief Converts `W` independent digit runs in lockstep, for up to 32 runs.
+ *
+ * Step `k` takes digit `k` of every run, with one accumulator per run, so the `W` multiply
+ * chains do not wait on each other and the core overlaps them. The steps run in one loop up to the
+ * shortest usable run; the longer runs then finish one after the other. Plain scalar code, so it
+ * applies on targets without SWAR or SIMD and to fields too irregular for a specialized kernel.
+ *
+ * @param p The first digit of every run.
+ * @param n The number of digits of every run.
+ * @param v Receives the value of every run; only those whose bit is set in the result are valid.
+ *
+ * @return A mask with bit `i` set if run `i` has 1 to `max_digits` digits and nothing else.
+ *
+ * @throws _StatAssert If `W` is not between 1 and 32 (the width of the mask).
+ */
+template <size_t W>
+SEVAL_INLINE uint32_t parse_digits_interleaved(const char* const* p, const size_t* n, uint64_t* v) {
+    _StatAssert(W >= 1 && W <= 32, "Template parameter W must be between 1 and 32, one run per bit of the result mask.");
+    static const char zeros[max_digits + 1] = "0000000000000000000"; /* what unusable runs read */
+    const char* runs[W];
+    size_t ends[W];
+    uint32_t usable = 0;
+    size_t shortest = max_digits;
+    for (size_t i = 0; i < W; ++i) {
+        bool ok = n[i] != 0 && n[i] <= max_digits;
+        runs[i] = ok ? p[i] : zeros;
+        ends[i] = ok ? n[i] : 0;
+        usable |= static_cast<uint32_t>(ok) << i;
+        shortest = ok && n[i] < shortest ? n[i] : shortest;
+    }
+
+    internal::lanes<W> l;
+    l.init(runs);
+    for (size_t k = 0; k < shortest; ++k) l.step(k);
+    l.finish(shortest, ends);
+    return l.store(v, 1) & usable;
+}
+
+/**
+ * @brief Longest digit run of `T` that `parse_field` converts itself: the kernels build the
+ *        value exactly, so for floating-point types it must be exact in `T` at every step, as it
+ *        is in `evaluate_field`.
+ */
+template <typename T>
+SEVAL_INLINE size_t exact_digits() {
+    if (!_TypeTraitsSpace::is_floating_point<T>::value) return max_digits;
+    return sizeof(T) < sizeof(double) ? 7 : 15;
+}
+
+/**
+ * @brief Converts an integer magnitude to `T` with its sign, exactly as `evaluate_field` would.
+ * @return `false` (leaving `out` untouched) if the value is out of the range of `T`, which
+ *         `evaluate_field` rejects.
+ */
+template <typename T>
+SEVAL_INLINE bool signed_value(uint64_t magnitude, seval::internal::Sign sign, T& out) {
+    if (!seval::internal::integer_range_<T>::fits(magnitude, sign)) return false;
+    out = seval::internal::apply_sign_<T>(static_cast<T>(magnitude), sign);
+    return true;
+}
+
+/**
+ * @brief Applies the `trim` options to a field and finds where its digit run starts.
+ *
+ * With `TRIM_WHITESPACE`, `field` and `length` are advanced past leading whitespace. The result is
+ * the offset of the digits in what remains: after the sign, and with `TRIM_ZEROS` after the
+ * leading zeros too, keeping the last byte so that "000" still has a digit. Zero-padded fields
+ * thus fit the kernels' 8- and 16-digit words, and ones longer than `max_digits` still convert.
+ *
+ * @return The bytes in front of the digit run.
+ */
+SEVAL_INLINE size_t trim_field(const char*& field, size_t& length, unsigned trim) {
+    if (trim & TRIM_WHITESPACE) {
+        size_t w = internal::space_run(field, length);
+        field += w;
+        length -= w;
+    }
+    size_t s = length != 0 && (field[0] == '-' || field[0] == '+') ? 1 : 0;
+    if ((trim & TRIM_ZEROS) && length > s + 1) s += internal::zero_run(field + s, length - s - 1);
+    return s;
+}
+
+/**
+ * @brief Evaluates a field like `seval::evaluate_field`, taking the kernel's fast path for
+ *        optionally signed digit runs.
+ *
+ * @param kind The kernel.
+ * @param field The start of the field.
+ * @param length The length of the field.
+ * @param lead How many bytes in front of `field` may be read.
+ * @param out Receives the value if the field is valid; left untouched otherwise.
+ * @param trim `trim_option` flags (see `trim_field`); with `TRIM_WHITESPACE`, fields that are
+ *        not plain digits are evaluated without their leading whitespace.
+ *
+ * @return `true` if the field is a valid literal for `T`.
+ */
+template <typename T>
+SEVAL_INLINE bool parse_field(kernel_kind kind, const char* field, size_t length, size_t lead, T& out, unsigned trim = TRIM_NONE) {
+    const char* start = field;
+    size_t s = trim_field(field, length, trim);
+    lead += static_cast<size_t>(field - start);
+    uint64_t magnitude = 0;
+    if (length - s <= exact_digits<T>() && parse_digits(kind, field + s, length - s, lead + s, magnitude) &&
+        signed_value<T>(magnitude, s != 0 && field[0] == '-' ? seval::internal::SIGN_NEGATIVE : seval::internal::SIGN_POSITIVE, out)) {
+        return true;
+    }
+    return evaluate_field<T>(field, length, out);
+}
+
+/**
+ * @brief `parse_field` for input followed by at least `padding` readable bytes (see
+ *        `batch::padded_buffer`): digit runs are converted with unconditional 8-byte loads, with
+ *        no lead, page or tail checks.
+ */
+template <typename T>
+SEVAL_INLINE bool parse_field_padded(const char* field, size_t length, T& out) {
+    size_t s = length != 0 && (field[0] == '-' || field[0] == '+') ? 1 : 0;
+    uint64_t magnitude = 0;
+    if (length - s <= exact_digits<T>() && internal::padded_digits(field + s, length - s, magnitude) &&
+        signed_value<T>(magnitude, s && field[0] == '-' ? seval::internal::SIGN_NEGATIVE : seval::internal::SIGN_POSITIVE, out)) {
+        return true;
+    }
+    return evaluate_field<T>(field, length, out);
+}
+
+/**
+ * @brief `parse_field_padded` for input without padding guarantees: the loads past the end of a
+ *        field stay within its last page (which is mapped), and fields too close to the end of a
+ *        page are loaded byte by byte. Such reads are invisible to AddressSanitizer but not to Valgrind.
+ */
+template <typename T>
+SEVAL_INLINE bool parse_field_page_safe(const char* field, size_t length, T& out) {
+    size_t s = length != 0 && (field[0] == '-' || field[0] == '+') ? 1 : 0;
+    uint64_t magnitude = 0;
+    if (length - s <= exact_digits<T>() && internal::page_safe_digits(field + s, length - s, magnitude) &&
+        signed_value<T>(magnitude, s && field[0] == '-' ? seval::internal::SIGN_NEGATIVE : seval::internal::SIGN_POSITIVE, out)) {
+        return true;
+    }
+    return evaluate_field<T>(field, length, out);
+}
+
+} /* kernels */
+
+} /* seval */
+
+#endif // SEVAL_KERNELS_HPP_LOADED
@@ -0,0 +1,115 @@
+/**
+ * @file seval_lazy.hpp
+ * @brief Lazily evaluated columns.
+ *
+ * A `lazy_column` indexes a delimited buffer once (see `seval::batch::index_fields`) and evaluates
+ * a field only when it is accessed, so opening a huge column costs a delimiter scan rather than a
+ * full parse. Results can optionally be memoized.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_LAZY_HPP_LOADED)
+#define SEVAL_LAZY_HPP_LOADED
+
+#include <vector>
+
+#include "seval_batch.hpp"
+
+namespace seval {
+
+namespace batch {
+
+/**
+ * @class lazy_column
+ * @brief Column view over a delimited buffer that evaluates fields on first access.
+ *
+ * The buffer is not copied and must outlive the column. Memoization writes to internal state from
+ * `const` accessors, so a memoizing column must not be read from several threads at once; a column
+ * constructed with `memoize = false` has no mutable state and may be shared freely.
+ */
+template <typename T>
+class lazy_column {
+public:
+    /**
+     * @brief Indexes the fields of a buffer; no field is evaluated yet.
+     *
+     * @param data The buffer holding the column.
+     * @param size The size of the buffer in bytes.
+     * @param delimiter The field delimiter (default is '\n'; a trailing '\r' is then ignored).
+     * @param memoize Whether evaluated fields are remembered (default is `true`).
+     */
+    lazy_column(const char* data, size_t size, char delimiter = '\n', bool memoize = true)
+        : data_(data), delimiter_(delimiter), memoize_(memoize) {
+        index_fields(data, size, delimiter, index_);
+    }
+
+    /** @brief Number of fields (rows). */
+    size_t size() const { return index_.size(); }
+
+    /**
+     * @brief Returns the raw bytes of a field.
+     * @param row The row index (must be below `size()`).
+     * @param length Receives the length of the field.
+     * @return A pointer to the first byte of the field.
+     */
+    const char* field(size_t row, size_t& length) const {
+        const char* p = data_ + index_.begin(row);
+        length = index_.length(row);
+        if (delimiter_ == '\n' && length != 0 && p[length - 1] == '\r') --length;
+        return p;
+    }
+
+    /**
+     * @brief Evaluates (or recalls) a field.
+     * @param row The row index (must be below `size()`).
+     * @param value Receives the value; 0 if the field is invalid.
+     * @return `true` if the field is a valid literal, otherwise `false`.
+     */
+    bool get(size_t row, T& value) const {
+        if (memoize_) {
+            if (state_.empty()) {
+                state_.resize(size(), STATE_PENDING);
+                values_.resize(size());
+            }
+            if (state_[row] != STATE_PENDING) {
+                value = values_[row];
+                return state_[row] == STATE_VALID;
+            }
+        }
+
+        size_t length = 0;
+        const char* p = field(row, length);
+        value = 0;
+        bool valid = evaluate_field<T>(p, length, value);
+
+        if (memoize_) {
+            values_[row] = value;
+            state_[row] = valid ? STATE_VALID : STATE_INVALID;
+        }
+        return valid;
+    }
+
+    /** @brief Evaluates (or recalls) a field; invalid fields read as 0. */
+    T operator[](size_t row) const {
+        T value = 0;
+        get(row, value);
+        return value;
+    }
+
+private:
+    enum State { STATE_PENDING = 0, STATE_VALID = 1, STATE_INVALID = 2 };
+
+    const char* data_;
+    char delimiter_;
+    bool memoize_;
+    field_index index_;
+    mutable std::vector<T> values_;
+    mutable std::vector<uint8_t> state_;
+};
+
+} /* batch */
+
+} /* seval */
+
+#endif // SEVAL_LAZY_HPP_LOADED
@@ -0,0 +1,259 @@
+/**
+ * @file seval_parallel.hpp
+ * @brief Parallel evaluation of many independent (expression, bindings) pairs.
+ *
+ * `evaluation_pool` owns a fixed set of worker threads and evaluates batches of tasks on them. A
+ * batch is ordered by expression text before it is split into chunks, so each worker looks every
+ * expression up in the shared `expression_cache` (see seval_cache.hpp) once per chunk and then
+ * runs the same bytecode back to back, with its registers and code hot in cache. Results are
+ * written in input order. The calling thread works on the batch too.
+ *
+ * Threads need C++11; before that the pool has no workers and evaluates batches on the calling
+ * thread, with the same results.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_PARALLEL_HPP_LOADED)
+#define SEVAL_PARALLEL_HPP_LOADED
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "seval_cache.hpp"
+
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#define SEVAL_PARALLEL_THREADS 1
+#endif
+
+namespace seval {
+
+namespace expr {
+
+/**
+ * @struct evaluation_task
+ * @brief One expression to evaluate with one set of bindings.
+ */
+struct evaluation_task {
+    std::string text;     /**< The expression. */
+    const bindings* vars; /**< Its variables (not owned); `NULL` binds none. */
+
+    evaluation_task() : vars(NULL) {}
+    evaluation_task(const std::string& t, const bindings* v) : text(t), vars(v) {}
+};
+
+/**
+ * @struct evaluation_result
+ * @brief Outcome of one `evaluation_task`.
+ */
+struct evaluation_result {
+    bool ok;      /**< Whether the expression compiled and evaluated. */
+    value result; /**< The value, if `ok`. */
+    error err;    /**< Why not, otherwise. */
+
+    evaluation_result() : ok(false) {}
+};
+
+namespace internal {
+/* orders task indexes by expression text, keeping input order among equal texts */
+struct task_order {
+    const std::vector<evaluation_task>* tasks;
+
+    bool operator()(uint32_t x, uint32_t y) const {
+        int c = (*tasks)[x].text.compare((*tasks)[y].text);
+        return c != 0 ? c < 0 : x < y;
+    }
+};
+} /* internal */
+
+/**
+ * @class evaluation_pool
+ * @brief Thread pool evaluating batches of expressions through a shared cache.
+ */
+class evaluation_pool {
+public:
+    /**
+     * @param cache The cache the workers compile through; must outlive the pool.
+     * @param threads Worker threads besides the caller (default is one less than the hardware
+     *        threads; ignored before C++11).
+     * @param chunk Tasks a worker claims at a time (default is 64).
+     */
+    explicit evaluation_pool(expression_cache& cache, unsigned threads = default_threads(), size_t chunk = 64)
+        : cache_(cache), chunk_(chunk == 0 ? 1 : chunk), tasks_(NULL), results_(NULL), chunks_(0) {
+#if defined(SEVAL_PARALLEL_THREADS)
+        generation_ = 0;
+        busy_ = 0;
+        stop_ = false;
+        next_ = 0;
+        for (unsigned t = 0; t < threads; ++t) workers_.push_back(std::thread(&evaluation_pool::work, this));
+#else
+        (void)threads;
+#endif
+    }
+
+    ~evaluation_pool() {
+#if defined(SEVAL_PARALLEL_THREADS)
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (size_t t = 0; t < workers_.size(); ++t) workers_[t].join();
+#endif
+    }
+
+    /** @brief One less than the hardware threads (the caller is the last one), or 0 before C++11. */
+    static unsigned default_threads() {
+#if defined(SEVAL_PARALLEL_THREADS)
+        unsigned n = std::thread::hardware_concurrency();
+        return n > 1 ? n - 1 : 0;
+#else
+        return 0;
+#endif
+    }
+
+    /** @brief Number of worker threads. */
+    size_t threads() const {
+#if defined(SEVAL_PARALLEL_THREADS)
+        return workers_.size();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Evaluates every task; `results[i]` belongs to `tasks[i]`.
+     *
+     * Batches are evaluated one at a time; concurrent calls are serialized.
+     *
+     * @return `true` if every task evaluated successfully.
+     */
+    bool evaluate(const std::vector<evaluation_task>& tasks, std::vector<evaluation_result>& results) {
+        results.assign(tasks.size(), evaluation_result());
+        if (tasks.empty()) return true;
+
+#if defined(SEVAL_PARALLEL_THREADS)
+        std::lock_guard<std::mutex> serial(batch_);
+#endif
+        order_.resize(tasks.size());
+        for (size_t k = 0; k < tasks.size(); ++k) order_[k] = static_cast<uint32_t>(k);
+        internal::task_order byText;
+        byText.tasks = &tasks;
+        std::sort(order_.begin(), order_.end(), byText);
+
+        tasks_ = &tasks;
+        results_ = &results;
+        chunks_ = (tasks.size() + chunk_ - 1) / chunk_;
+
+#if defined(SEVAL_PARALLEL_THREADS)
+        next_ = 0;
+        if (!workers_.empty()) {
+            std::lock_guard<std::mutex> guard(lock_);
+            busy_ = workers_.size();
+            ++generation_;
+        }
+        wake_.notify_all();
+        drain();
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            while (busy_ != 0) done_.wait(guard);
+        }
+#else
+        for (size_t c = 0; c < chunks_; ++c) run_chunk(c);
+#endif
+
+        tasks_ = NULL;
+        results_ = NULL;
+        for (size_t k = 0; k < results.size(); ++k) {
+            if (!results[k].ok) return false;
+        }
+        return true;
+    }
+
+private:
+    evaluation_pool(const evaluation_pool&);
+    evaluation_pool& operator=(const evaluation_pool&);
+
+    /* evaluates the tasks of sorted chunk `c`, looking each distinct text up once */
+    void run_chunk(size_t c) {
+        static const bindings none;
+        const std::vector<evaluation_task>& tasks = *tasks_;
+        std::vector<evaluation_result>& results = *results_;
+        size_t end = (c + 1) * chunk_ < order_.size() ? (c + 1) * chunk_ : order_.size();
+
+        compiled_expression current;
+        const std::string* text = NULL;
+        bool compiled = false;
+        error compileErr;
+
+        for (size_t k = c * chunk_; k < end; ++k) {
+            const evaluation_task& task = tasks[order_[k]];
+            evaluation_result& r = results[order_[k]];
+            if (!text || *text != task.text) {
+                text = &task.text;
+                compiled = cache_.get(task.text, current, &compileErr);
+            }
+            if (!compiled) {
+                r.err = compileErr;
+                continue;
+            }
+            r.ok = current.run(task.vars ? *task.vars : none, r.result, &r.err);
+        }
+    }
+
+#if defined(SEVAL_PARALLEL_THREADS)
+    /* claims and runs chunks of the current batch until none is left */
+    void drain() {
+        for (;;) {
+            size_t c = next_.fetch_add(1);
+            if (c >= chunks_) return;
+            run_chunk(c);
+        }
+    }
+
+    void work() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                while (!stop_ && generation_ == seen) wake_.wait(guard);
+                if (stop_) return;
+                seen = generation_;
+            }
+            drain();
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                if (--busy_ == 0) done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex batch_;               /* one batch at a time */
+    std::mutex lock_;                /* guards generation_, busy_ and stop_ */
+    std::condition_variable wake_;   /* a batch was published, or the pool stops */
+    std::condition_variable done_;   /* the last worker left the batch */
+    uint64_t generation_;
+    size_t busy_;                    /* workers still in the current batch */
+    bool stop_;
+    std::atomic<size_t> next_;       /* next unclaimed chunk */
+#endif
+
+    expression_cache& cache_;
+    size_t chunk_;
+    const std::vector<evaluation_task>* tasks_;
+    std::vector<evaluation_result>* results_;
+    std::vector<uint32_t> order_;
+    size_t chunks_;
+};
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_PARALLEL_HPP_LOADED
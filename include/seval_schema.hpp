@@ -0,0 +1,226 @@
+/**
+ * @file seval_schema.hpp
+ * @brief Variable schemas with perfect-hash name resolution.
+ *
+ * A `schema` fixes the layout of an input row: every variable name gets a slot index. Names are
+ * looked up through a perfect hash built once with hash-and-displace (every name has its own table
+ * cell, found with one hash, one displacement and one string comparison). Compiling an expression
+ * against a schema resolves its identifiers to slots at compile time, so evaluation only indexes
+ * into a flat `double` array (see `seval::expr::run(const program&, const double*, ...)`).
+ */
+
+#pragma once
+
+#if !defined(SEVAL_SCHEMA_HPP_LOADED)
+#define SEVAL_SCHEMA_HPP_LOADED
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "seval_vm.hpp"
+
+namespace seval {
+
+namespace expr {
+
+namespace internal {
+/* seeded FNV-1a with a 64-bit finalizer, so nearby names spread over the whole table */
+SEVAL_INLINE uint64_t name_hash(const char* name, size_t length, uint64_t seed) {
+    uint64_t h = 0xCBF29CE484222325ULL ^ seed;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<uint8_t>(name[i]);
+        h *= 0x100000001B3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/* cell of a name with hash `h` under displacement `d` */
+SEVAL_INLINE size_t displaced_cell(uint64_t h, uint32_t d, size_t mask) {
+    uint64_t x = h ^ (static_cast<uint64_t>(d) * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 32;
+    return static_cast<size_t>(x) & mask;
+}
+
+/* orders buckets by decreasing size, so the crowded ones are placed while the table is empty */
+struct bucket_order {
+    const std::vector<std::vector<uint32_t> >* buckets;
+
+    bool operator()(uint32_t x, uint32_t y) const {
+        size_t sx = (*buckets)[x].size(), sy = (*buckets)[y].size();
+        return sx != sy ? sx > sy : x < y;
+    }
+};
+} /* internal */
+
+/**
+ * @class schema
+ * @brief Ordered set of variable names with a perfect hash from name to slot.
+ */
+class schema {
+public:
+    /** Returned by `find` for names outside the schema. */
+    enum { npos = 0xFFFFFFFFu };
+
+    schema() {}
+
+    /**
+     * @brief Builds a schema; slot `i` is `names[i]`. Duplicates make the schema empty (see `build`).
+     */
+    explicit schema(const std::vector<std::string>& names) { build(names); }
+
+    /**
+     * @brief Replaces the names and rebuilds the perfect hash.
+     * @return `false` (leaving the schema empty) if a name occurs twice.
+     */
+    bool build(const std::vector<std::string>& names) {
+        std::vector<std::string> sorted(names);
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            clear();
+            return false;
+        }
+
+        names_ = names;
+        size_t n = names_.size();
+        size_t cells = 1;
+        while (cells < n) cells <<= 1;
+        size_t bucketCount = n / 2 + 1;
+
+        std::vector<uint64_t> hashes(n);
+        std::vector<std::vector<uint32_t> > buckets(bucketCount);
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = internal::name_hash(names_[i].data(), names_[i].size(), 0);
+            buckets[(hashes[i] >> 32) % bucketCount].push_back(static_cast<uint32_t>(i));
+        }
+
+        std::vector<uint32_t> order(bucketCount);
+        for (size_t b = 0; b < bucketCount; ++b) order[b] = static_cast<uint32_t>(b);
+        internal::bucket_order byDecreasingSize;
+        byDecreasingSize.buckets = &buckets;
+        std::sort(order.begin(), order.end(), byDecreasingSize);
+
+        /* hash-and-displace; a bucket that finds no displacement doubles the table */
+        for (;;) {
+            table_.assign(cells, static_cast<uint32_t>(npos));
+            displacements_.assign(bucketCount, 0);
+            bool placed = true;
+
+            for (size_t k = 0; k < bucketCount && placed; ++k) {
+                const std::vector<uint32_t>& bucket = buckets[order[k]];
+                if (bucket.empty()) break;
+
+                placed = false;
+                for (uint32_t d = 0; d < max_displacement && !placed; ++d) {
+                    size_t j = 0;
+                    for (; j < bucket.size(); ++j) {
+                        size_t cell = internal::displaced_cell(hashes[bucket[j]], d, cells - 1);
+                        if (table_[cell] != npos) break;
+                        table_[cell] = bucket[j];
+                    }
+                    if (j == bucket.size()) {
+                        displacements_[order[k]] = d;
+                        placed = true;
+                    } else {
+                        while (j-- > 0) table_[internal::displaced_cell(hashes[bucket[j]], d, cells - 1)] = static_cast<uint32_t>(npos);
+                    }
+                }
+            }
+            if (placed) return true;
+            cells <<= 1;
+        }
+    }
+
+    /** @brief Removes every name. */
+    void clear() {
+        names_.clear();
+        table_.clear();
+        displacements_.clear();
+    }
+
+    /** @brief Number of slots. */
+    size_t size() const { return names_.size(); }
+
+    /** @brief Name of a slot. */
+    const std::string& name(size_t slot) const { return names_[slot]; }
+
+    /** @brief The names in slot order. */
+    const std::vector<std::string>& names() const { return names_; }
+
+    /**
+     * @brief Looks a name up.
+     * @return Its slot, or `npos`.
+     */
+    uint32_t find(const char* name, size_t length) const {
+        if (names_.empty()) return static_cast<uint32_t>(npos);
+        uint64_t h = internal::name_hash(name, length, 0);
+        uint32_t d = displacements_[(h >> 32) % displacements_.size()];
+        uint32_t slot = table_[internal::displaced_cell(h, d, table_.size() - 1)];
+        if (slot == npos) return slot;
+        const std::string& candidate = names_[slot];
+        return candidate.size() == length && memcmp(candidate.data(), name, length) == 0 ? slot : static_cast<uint32_t>(npos);
+    }
+
+    /** @brief Looks a name up. */
+    uint32_t find(const std::string& name) const { return find(name.data(), name.size()); }
+
+    /** @brief Looks a NUL-terminated name up. */
+    uint32_t find(const char* name) const { return find(name, strlen(name)); }
+
+private:
+    /* displacements tried per bucket before the table grows */
+    enum { max_displacement = 1u << 16 };
+
+    std::vector<std::string> names_;
+    std::vector<uint32_t> table_;
+    std::vector<uint32_t> displacements_;
+};
+
+/**
+ * @brief Compiles an expression against a schema: every variable is resolved to its slot once.
+ *
+ * The program's `slots` map variables to schema slots, so it runs on rows laid out by the schema
+ * (`seval::expr::run(const program&, const double*, ...)`, `jit_program::run`, ...).
+ *
+ * @return `false` if the expression uses a name outside the schema (or does not compile).
+ */
+SEVAL_INLINE bool compile(const expression& e, const schema& vars, program& out, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    if (!compile(e, out, err, mode)) return false;
+
+    out.slots.resize(out.variables.size());
+    for (size_t v = 0; v < out.variables.size(); ++v) {
+        out.slots[v] = vars.find(out.variables[v]);
+        if (out.slots[v] == schema::npos) {
+            size_t position = 0;
+            for (size_t n = 0; n < e.nodes.size(); ++n) {
+                if (e.nodes[n].op == OP_VAR && e.variables[e.nodes[n].a] == out.variables[v]) { position = e.nodes[n].position; break; }
+            }
+            out.slots.clear();
+            out.code.clear(); /* nothing runnable is left behind, as after a failed compile */
+            return internal::fail(err, position, "unknown variable");
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Parses and compiles an expression against a schema in one call.
+ */
+SEVAL_INLINE bool compile(const char* text, const schema& vars, program& out, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    expression e;
+    return parse(text, e, err) && compile(e, vars, out, err, mode);
+}
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_SCHEMA_HPP_LOADED
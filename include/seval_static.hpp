@@ -0,0 +1,331 @@
+/**
+ * @file seval_static.hpp
+ * @brief Formulas parsed and folded at compile time (C++20).
+ *
+ * `formula<"a * 2 + 0x10">` parses its text while the program is being compiled, with the parser
+ * behind `seval::expr::parse` (`basic_parser`, which is `constexpr` from C++14 on like the literal
+ * kernels of seval.hpp) feeding a compile-time sink, so grammar, function names, error messages and
+ * typing rules are the same. The AST becomes a type: every node is a template instance, so
+ * evaluating the formula is a chain of inline calls that the compiler flattens into straight-line
+ * code, with no tokenizing, no dispatch and no register file at run time. Constant sub-expressions
+ * are folded while parsing, so a formula over literals is itself a constant expression:
+ *
+ *   static_assert(seval::expr::formula<"(1 + 2) * 0x10">::eval() == 48);
+ *   double y = seval::expr::formula<"a * 2 + 0x10">::eval(x);
+ *
+ * Variables are passed positionally, in order of first appearance (as in `expression::variables`).
+ * A text that does not parse, divides an integer by zero or overflows under `OVERFLOW_TRAP` sets
+ * `valid` to `false` (with `message` and `position` as `parse` or `evaluate` would report them) and
+ * fails the build on the first evaluation. Needs class-type non-type template parameters;
+ * `SEVAL_STATIC_FORMULA` is defined when they are available.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_STATIC_HPP_LOADED)
+#define SEVAL_STATIC_HPP_LOADED
+
+#include <math.h>
+#include <string>
+
+#include "seval_expr.hpp"
+
+#if __cplusplus >= 202002L
+#define SEVAL_STATIC_FORMULA 1
+#include <bit>
+#endif
+
+#if defined(SEVAL_STATIC_FORMULA)
+
+namespace seval {
+
+namespace expr {
+
+namespace internal {
+/**
+ * @brief String literal usable as a template argument.
+ */
+template <size_t N>
+struct fixed_string {
+    char text[N] = {};
+
+    constexpr fixed_string(const char (&s)[N]) {
+        for (size_t k = 0; k < N; ++k) text[k] = s[k];
+    }
+};
+
+/* one AST node; constants keep both representations so folding needs no union */
+struct static_node {
+    opcode op = OP_CONST;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t position = 0;
+    value_kind kind = KIND_INT;
+    int64_t i = 0;
+    double f = 0;
+};
+
+/**
+ * @brief Parse result of an `N`-character text; a node never takes less than one character.
+ */
+template <size_t N>
+struct static_tree {
+    static_node nodes[N] = {};
+    uint32_t count = 0;
+    uint32_t root = 0;
+    uint32_t names[N] = {};   /* offset of each variable name in the text */
+    uint32_t lengths[N] = {}; /* and its length */
+    uint32_t variables = 0;
+    const char* message = nullptr;
+    size_t position = 0;
+};
+
+/**
+ * @brief `basic_parser` sink building a `static_tree`; folds every operation whose operands are
+ *        constant and whose result `apply` would compute exactly (library calls are left to run time).
+ */
+template <size_t N>
+class static_builder {
+public:
+    constexpr static_builder(const char* text, overflow_mode mode, static_tree<N>& out) : text_(text), mode_(mode), out_(out) {}
+
+    constexpr bool fail(size_t position, const char* message) {
+        out_.message = message;
+        out_.position = position;
+        return false;
+    }
+
+    constexpr uint32_t integer(int64_t v, size_t position) {
+        static_node n;
+        n.kind = KIND_INT;
+        n.i = v;
+        n.position = static_cast<uint32_t>(position);
+        return add(n);
+    }
+
+    constexpr uint32_t real(double v, size_t position) {
+        static_node n;
+        n.kind = KIND_FLOAT;
+        n.f = v;
+        n.position = static_cast<uint32_t>(position);
+        return add(n);
+    }
+
+    constexpr uint32_t variable(const char* name, size_t length, size_t position) {
+        uint32_t index = 0;
+        while (index < out_.variables && !(out_.lengths[index] == length && same_name(text_ + out_.names[index], name, length))) ++index;
+        if (index == out_.variables) {
+            out_.names[index] = static_cast<uint32_t>(name - text_);
+            out_.lengths[index] = static_cast<uint32_t>(length);
+            ++out_.variables;
+        }
+
+        static_node n;
+        n.op = OP_VAR;
+        n.a = index;
+        n.kind = KIND_FLOAT;
+        n.position = static_cast<uint32_t>(position);
+        return add(n);
+    }
+
+    /* adds an operation, or its value when the operands are constant */
+    constexpr bool operation(opcode op, uint32_t a, uint32_t b, size_t position, uint32_t& result) {
+        const static_node& x = out_.nodes[a];
+        const static_node& y = out_.nodes[arity(op) == 2 ? b : a];
+
+        if (x.op == OP_CONST && y.op == OP_CONST) {
+            if (x.kind == KIND_INT && y.kind == KIND_INT && op != OP_SQRT) {
+                int64_t r = 0;
+                if (!int_apply(op, x.i, y.i, mode_, r)) return fail(position, int_failure(op, y.i));
+                result = integer(r, position);
+                return true;
+            }
+
+            double xf = x.kind == KIND_INT ? static_cast<double>(x.i) : x.f;
+            double yf = y.kind == KIND_INT ? static_cast<double>(y.i) : y.f;
+            switch (op) {
+            case OP_NEG: result = real(-xf, position); return true;
+            case OP_ABS: result = real(std::bit_cast<double>(std::bit_cast<uint64_t>(xf) & 0x7FFFFFFFFFFFFFFFULL), position); return true;
+            case OP_ADD: result = real(xf + yf, position); return true;
+            case OP_SUB: result = real(xf - yf, position); return true;
+            case OP_MUL: result = real(xf * yf, position); return true;
+            case OP_DIV: result = real(xf / yf, position); return true;
+            case OP_MIN: result = real(yf < xf ? yf : xf, position); return true;
+            case OP_MAX: result = real(xf < yf ? yf : xf, position); return true;
+            default: break; /* fmod, pow and sqrt are library calls */
+            }
+        }
+
+        static_node n;
+        n.op = op;
+        n.a = a;
+        n.b = b;
+        n.kind = KIND_FLOAT; /* integer operations are always folded */
+        n.position = static_cast<uint32_t>(position);
+        result = add(n);
+        return true;
+    }
+
+    constexpr void root(uint32_t n) { out_.root = n; }
+
+private:
+    constexpr uint32_t add(const static_node& n) {
+        out_.nodes[out_.count] = n;
+        return out_.count++;
+    }
+
+    static constexpr bool same_name(const char* x, const char* y, size_t length) {
+        for (size_t k = 0; k < length; ++k) {
+            if (x[k] != y[k]) return false;
+        }
+        return true;
+    }
+
+    const char* text_;
+    overflow_mode mode_;
+    static_tree<N>& out_;
+};
+
+template <size_t N>
+constexpr static_tree<N> parse_static(const fixed_string<N>& s, overflow_mode mode) {
+    static_tree<N> tree;
+    static_builder<N> builder(s.text, mode, tree);
+    basic_parser<static_builder<N> >(s.text, builder).run();
+    return tree;
+}
+
+template <fixed_string Text, overflow_mode Mode>
+inline constexpr auto static_tree_of = parse_static(Text, Mode);
+
+/**
+ * @brief AST node types. `run` is `constexpr`, so formulas without library calls fold completely.
+ */
+template <int64_t Value>
+struct static_int {
+    typedef int64_t type;
+    static constexpr int64_t run(const double*) { return Value; }
+};
+
+template <uint64_t Bits> /* a double, by bit pattern */
+struct static_float {
+    typedef double type;
+    static constexpr double run(const double*) { return std::bit_cast<double>(Bits); }
+};
+
+template <uint32_t Slot>
+struct static_variable {
+    typedef double type;
+    static constexpr double run(const double* row) { return row[Slot]; }
+};
+
+template <opcode Op, typename A>
+struct static_unary {
+    typedef double type;
+    static constexpr double run(const double* row) {
+        double x = static_cast<double>(A::run(row));
+        if constexpr (Op == OP_NEG) return -x;
+        else if constexpr (Op == OP_ABS) return ::fabs(x);
+        else return ::sqrt(x);
+    }
+};
+
+template <opcode Op, typename A, typename B>
+struct static_binary {
+    typedef double type;
+    static constexpr double run(const double* row) {
+        double x = static_cast<double>(A::run(row));
+        double y = static_cast<double>(B::run(row));
+        if constexpr (Op == OP_ADD) return x + y;
+        else if constexpr (Op == OP_SUB) return x - y;
+        else if constexpr (Op == OP_MUL) return x * y;
+        else if constexpr (Op == OP_DIV) return x / y;
+        else if constexpr (Op == OP_MOD) return ::fmod(x, y);
+        else if constexpr (Op == OP_POW) return ::pow(x, y);
+        else if constexpr (Op == OP_MIN) return y < x ? y : x;
+        else return x < y ? y : x;
+    }
+};
+
+/* stands in for the AST of a text that does not parse */
+struct static_invalid {
+    typedef double type;
+    static constexpr double run(const double*) { return 0; }
+};
+
+template <const auto& Tree, uint32_t Index>
+constexpr auto static_type() {
+    constexpr static_node n = Tree.nodes[Index];
+    if constexpr (n.op == OP_CONST && n.kind == KIND_INT) return static_int<n.i>();
+    else if constexpr (n.op == OP_CONST) return static_float<std::bit_cast<uint64_t>(n.f)>();
+    else if constexpr (n.op == OP_VAR) return static_variable<n.a>();
+    else if constexpr (arity(n.op) == 1) return static_unary<n.op, decltype(static_type<Tree, n.a>())>();
+    else return static_binary<n.op, decltype(static_type<Tree, n.a>()), decltype(static_type<Tree, n.b>())>();
+}
+
+template <const auto& Tree>
+constexpr auto static_root() {
+    if constexpr (Tree.message == nullptr) return static_type<Tree, Tree.root>();
+    else return static_invalid();
+}
+} /* internal */
+
+/**
+ * @class formula
+ * @brief An expression compiled with the program; see the file documentation.
+ *
+ * @tparam Text The expression, as a string literal.
+ * @tparam Mode What integer overflow does while folding (default is `OVERFLOW_WRAP`); under
+ *         `OVERFLOW_TRAP` an overflowing formula is not `valid`.
+ */
+template <internal::fixed_string Text, overflow_mode Mode = OVERFLOW_WRAP>
+class formula {
+    static constexpr const auto& tree = internal::static_tree_of<Text, Mode>;
+
+public:
+    /** The AST as a type: nested `static_unary`, `static_binary`, `static_variable`, ... */
+    typedef decltype(internal::static_root<tree>()) type;
+
+    /** `int64_t` for formulas that fold to an integer, otherwise `double`. */
+    typedef typename type::type result_type;
+
+    /** Whether the text parses and folds. */
+    static constexpr bool valid = tree.message == nullptr;
+
+    /** Why the text is not `valid` (the message `parse` or `evaluate` reports), else `nullptr`. */
+    static constexpr const char* message = tree.message;
+
+    /** Offset in the text the `message` refers to. */
+    static constexpr size_t position = tree.position;
+
+    /** Number of distinct variables. */
+    static constexpr size_t variable_count = tree.variables;
+
+    /** @brief Name of variable `k`, in order of first appearance. */
+    static std::string variable(size_t k) { return std::string(Text.text + tree.names[k], tree.lengths[k]); }
+
+    /**
+     * @brief Evaluates the formula on a row holding the variables in order of first appearance.
+     */
+    static constexpr result_type run(const double* row) {
+        static_assert(valid, "seval::expr::formula: the text does not parse (see formula<...>::message and ::position)");
+        return type::run(row);
+    }
+
+    /**
+     * @brief Evaluates the formula; the arguments are the variables in order of first appearance.
+     */
+    template <typename... Args>
+    static constexpr result_type eval(Args... args) {
+        static_assert(sizeof...(Args) == variable_count, "seval::expr::formula: one argument per variable is expected");
+        const double row[sizeof...(Args) + 1] = { static_cast<double>(args)..., 0 };
+        return run(row);
+    }
+};
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_STATIC_FORMULA
+
+#endif // SEVAL_STATIC_HPP_LOADED
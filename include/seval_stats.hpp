@@ -0,0 +1,551 @@
+/**
+ * @file seval_stats.hpp
+ * @brief Opt-in counters of the paths the parsing kernels take.
+ *
+ * Defining `SEVAL_STATS` before including seval.hpp makes `evaluate`, `evaluate_n`,
+ * `evaluate_field` and the batch helpers count which literal forms, fallbacks and errors real data
+ * hits (see `counter`). Without it the hooks expand to nothing and every counter reads 0.
+ *
+ * Counters are per thread: each thread owns a block of them, padded so that no two blocks share a
+ * cache line, and only ever writes its own. `collect` sums the blocks of every live thread plus
+ * what exited threads left behind. Before C++11 thread-local blocks need GCC, Clang or MSVC;
+ * elsewhere all threads share one block and counts may be lost under contention.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_STATS_HPP_LOADED)
+#define SEVAL_STATS_HPP_LOADED
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(SEVAL_INLINE)
+#define SEVAL_INLINE inline
+#endif // SEVAL_INLINE
+
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#define SEVAL_STATS_STD_THREADS 1
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define SEVAL_STATS_PTHREAD_MUTEX 1
+#endif
+
+#if !defined(SEVAL_STATS_STD_THREADS)
+#if defined(__GNUC__)
+#define SEVAL_STATS_TLS __thread
+#elif defined(_MSC_VER)
+#define SEVAL_STATS_TLS __declspec(thread)
+#endif
+#endif
+
+namespace seval {
+
+namespace stats {
+
+/**
+ * @brief Every counted event; `describe` gives the kernel and path of each.
+ */
+enum counter {
+    EVALUATE_CALLS = 0,      /**< `evaluate` calls. */
+    EVALUATE_BYTES,          /**< Characters consumed by `evaluate`. */
+    EVALUATE_DECIMAL,        /**< ... literals without a prefix. */
+    EVALUATE_HEXADECIMAL,    /**< ... "0x" literals. */
+    EVALUATE_BINARY,         /**< ... "0b" literals. */
+    EVALUATE_SIGN,           /**< ... literals with a sign. */
+    EVALUATE_FRACTION,       /**< ... literals with a fractional part. */
+    EVALUATE_EXPONENT,       /**< ... literals with an exponent. */
+
+    EVALUATE_N_CALLS,        /**< Same for `evaluate_n`. */
+    EVALUATE_N_BYTES,
+    EVALUATE_N_DECIMAL,
+    EVALUATE_N_HEXADECIMAL,
+    EVALUATE_N_BINARY,
+    EVALUATE_N_SIGN,
+    EVALUATE_N_FRACTION,
+    EVALUATE_N_EXPONENT,
+
+    FIELD_CALLS,             /**< Same for `evaluate_field`. */
+    FIELD_BYTES,
+    FIELD_DECIMAL,
+    FIELD_HEXADECIMAL,
+    FIELD_BINARY,
+    FIELD_SIGN,
+    FIELD_FRACTION,
+    FIELD_EXPONENT,
+    FIELD_ERROR_EMPTY,       /**< Fields rejected for being empty. */
+    FIELD_ERROR_DIGITS,      /**< ... for having no digit ("-", "0x", "."). */
+    FIELD_ERROR_TRAILING,    /**< ... for characters after the literal. */
+    FIELD_ERROR_EXPONENT,    /**< ... for an exponent without digits ("1e+"). */
+    FIELD_ERROR_RANGE,       /**< ... for an integer outside the range of the type ("300" as `uint8_t`, "-1" as `unsigned`). */
+
+    INDEX_CALLS,             /**< `batch::index_fields` calls. */
+    INDEX_BYTES,             /**< Bytes indexed. */
+    INDEX_SIMD_BYTES,        /**< ... of them scanned 16 at a time with SSE2. */
+    INDEX_SCALAR_BYTES,      /**< ... of them left to the `memchr` tail. */
+
+    DICTIONARY_LOOKUPS,      /**< `dictionary_cache` lookups. */
+    DICTIONARY_HITS,         /**< ... answered from the cache. */
+    DICTIONARY_MISSES,       /**< ... that evaluated the field (and cached it if there was room). */
+    DICTIONARY_BYPASSES,     /**< ... that skipped the cache (disabled, empty or too long). */
+    DICTIONARY_DISABLES,     /**< Caches that turned themselves off for a low hit rate. */
+
+    ADAPTIVE_CALLS,          /**< `batch::parse_column_adaptive` calls. */
+    ADAPTIVE_FIELDS,         /**< ... fields they parsed. */
+    ADAPTIVE_SAMPLES,        /**< ... samples it took (kernel decisions). */
+    ADAPTIVE_SCALAR,         /**< ... fields converted under `KERNEL_SCALAR`. */
+    ADAPTIVE_LENGTH_SWITCH,  /**< ... under `KERNEL_LENGTH_SWITCH`. */
+    ADAPTIVE_SWAR8,          /**< ... under `KERNEL_SWAR8`. */
+    ADAPTIVE_SIMD16,         /**< ... under `KERNEL_SIMD16`. */
+
+    BUCKETED_CALLS,          /**< `batch::parse_column_bucketed` calls. */
+    BUCKETED_FIELDS,         /**< ... fields they parsed. */
+    BUCKETED_PLAIN,          /**< ... converted in a length bucket. */
+    BUCKETED_FALLBACK,       /**< ... left to `evaluate_field`. */
+
+    INTERLEAVED_CALLS,       /**< `batch::parse_column_interleaved` calls. */
+    INTERLEAVED_FIELDS,      /**< ... fields they parsed. */
+    INTERLEAVED_PLAIN,       /**< ... converted in lockstep with their neighbours. */
+    INTERLEAVED_FALLBACK,    /**< ... left to `evaluate_field`. */
+
+    GATHER_CALLS,            /**< `parse_gather` calls. */
+    GATHER_STRINGS,          /**< ... strings they parsed. */
+    GATHER_PLAIN,            /**< ... converted by a length-specialized kernel. */
+    GATHER_FALLBACK,         /**< ... left to `evaluate_field`. */
+
+    PADDED_CALLS,            /**< `batch::parse_column_padded` calls. */
+    PADDED_FIELDS,           /**< ... fields they parsed. */
+    PAGE_SAFE_CALLS,         /**< `batch::parse_column_page_safe` calls. */
+    PAGE_SAFE_FIELDS,        /**< ... fields they parsed. */
+
+    COUNTER_COUNT            /**< Number of counters. */
+};
+
+/**
+ * @brief What a counter measures, which decides how it is exported.
+ */
+enum family {
+    FAMILY_CALLS = 0, /**< Calls of a kernel. */
+    FAMILY_BYTES,     /**< Bytes a kernel consumed. */
+    FAMILY_FIELDS,    /**< Fields (or strings) a batch kernel parsed. */
+    FAMILY_PATH,      /**< Calls, fields or bytes that took a path; `base` is what they are a share of. */
+    FAMILY_ERROR      /**< Rejected inputs of one kind. */
+};
+
+/**
+ * @struct counter_info
+ * @brief Where a counter is incremented: `kernel` is the function, `path` what it did.
+ */
+struct counter_info {
+    family kind;
+    const char* kernel;
+    const char* path;
+    counter base; /**< The counter this one is a share of, or `COUNTER_COUNT`. */
+};
+
+/**
+ * @brief Kernel, path and family of every counter, indexed by `counter`.
+ */
+SEVAL_INLINE const counter_info& describe(counter c) {
+    static const counter_info table[COUNTER_COUNT] = {
+        { FAMILY_CALLS, "evaluate", "calls", COUNTER_COUNT },
+        { FAMILY_BYTES, "evaluate", "bytes", COUNTER_COUNT },
+        { FAMILY_PATH, "evaluate", "decimal", EVALUATE_CALLS },
+        { FAMILY_PATH, "evaluate", "hexadecimal", EVALUATE_CALLS },
+        { FAMILY_PATH, "evaluate", "binary", EVALUATE_CALLS },
+        { FAMILY_PATH, "evaluate", "sign", EVALUATE_CALLS },
+        { FAMILY_PATH, "evaluate", "fraction", EVALUATE_CALLS },
+        { FAMILY_PATH, "evaluate", "exponent", EVALUATE_CALLS },
+
+        { FAMILY_CALLS, "evaluate_n", "calls", COUNTER_COUNT },
+        { FAMILY_BYTES, "evaluate_n", "bytes", COUNTER_COUNT },
+        { FAMILY_PATH, "evaluate_n", "decimal", EVALUATE_N_CALLS },
+        { FAMILY_PATH, "evaluate_n", "hexadecimal", EVALUATE_N_CALLS },
+        { FAMILY_PATH, "evaluate_n", "binary", EVALUATE_N_CALLS },
+        { FAMILY_PATH, "evaluate_n", "sign", EVALUATE_N_CALLS },
+        { FAMILY_PATH, "evaluate_n", "fraction", EVALUATE_N_CALLS },
+        { FAMILY_PATH, "evaluate_n", "exponent", EVALUATE_N_CALLS },
+
+        { FAMILY_CALLS, "evaluate_field", "calls", COUNTER_COUNT },
+        { FAMILY_BYTES, "evaluate_field", "bytes", COUNTER_COUNT },
+        { FAMILY_PATH, "evaluate_field", "decimal", FIELD_CALLS },
+        { FAMILY_PATH, "evaluate_field", "hexadecimal", FIELD_CALLS },
+        { FAMILY_PATH, "evaluate_field", "binary", FIELD_CALLS },
+        { FAMILY_PATH, "evaluate_field", "sign", FIELD_CALLS },
+        { FAMILY_PATH, "evaluate_field", "fraction", FIELD_CALLS },
+        { FAMILY_PATH, "evaluate_field", "exponent", FIELD_CALLS },
+        { FAMILY_ERROR, "evaluate_field", "empty", FIELD_CALLS },
+        { FAMILY_ERROR, "evaluate_field", "digits", FIELD_CALLS },
+        { FAMILY_ERROR, "evaluate_field", "trailing", FIELD_CALLS },
+        { FAMILY_ERROR, "evaluate_field", "exponent", FIELD_CALLS },
+        { FAMILY_ERROR, "evaluate_field", "range", FIELD_CALLS },
+
+        { FAMILY_CALLS, "index_fields", "calls", COUNTER_COUNT },
+        { FAMILY_BYTES, "index_fields", "bytes", COUNTER_COUNT },
+        { FAMILY_PATH, "index_fields", "simd", INDEX_BYTES },
+        { FAMILY_PATH, "index_fields", "scalar", INDEX_BYTES },
+
+        { FAMILY_CALLS, "dictionary", "calls", COUNTER_COUNT },
+        { FAMILY_PATH, "dictionary", "hit", DICTIONARY_LOOKUPS },
+        { FAMILY_PATH, "dictionary", "miss", DICTIONARY_LOOKUPS },
+        { FAMILY_PATH, "dictionary", "bypass", DICTIONARY_LOOKUPS },
+        { FAMILY_PATH, "dictionary", "disable", DICTIONARY_LOOKUPS },
+
+        { FAMILY_CALLS, "adaptive", "calls", COUNTER_COUNT },
+        { FAMILY_FIELDS, "adaptive", "fields", COUNTER_COUNT },
+        { FAMILY_PATH, "adaptive", "sample", ADAPTIVE_FIELDS },
+        { FAMILY_PATH, "adaptive", "scalar", ADAPTIVE_FIELDS },
+        { FAMILY_PATH, "adaptive", "length_switch", ADAPTIVE_FIELDS },
+        { FAMILY_PATH, "adaptive", "swar8", ADAPTIVE_FIELDS },
+        { FAMILY_PATH, "adaptive", "simd16", ADAPTIVE_FIELDS },
+
+        { FAMILY_CALLS, "bucketed", "calls", COUNTER_COUNT },
+        { FAMILY_FIELDS, "bucketed", "fields", COUNTER_COUNT },
+        { FAMILY_PATH, "bucketed", "bucket", BUCKETED_FIELDS },
+        { FAMILY_PATH, "bucketed", "fallback", BUCKETED_FIELDS },
+
+        { FAMILY_CALLS, "interleaved", "calls", COUNTER_COUNT },
+        { FAMILY_FIELDS, "interleaved", "fields", COUNTER_COUNT },
+        { FAMILY_PATH, "interleaved", "lockstep", INTERLEAVED_FIELDS },
+        { FAMILY_PATH, "interleaved", "fallback", INTERLEAVED_FIELDS },
+
+        { FAMILY_CALLS, "gather", "calls", COUNTER_COUNT },
+        { FAMILY_FIELDS, "gather", "fields", COUNTER_COUNT },
+        { FAMILY_PATH, "gather", "plain", GATHER_STRINGS },
+        { FAMILY_PATH, "gather", "fallback", GATHER_STRINGS },
+
+        { FAMILY_CALLS, "padded", "calls", COUNTER_COUNT },
+        { FAMILY_FIELDS, "padded", "fields", COUNTER_COUNT },
+        { FAMILY_CALLS, "page_safe", "calls", COUNTER_COUNT },
+        { FAMILY_FIELDS, "page_safe", "fields", COUNTER_COUNT }
+    };
+    return table[c];
+}
+
+/**
+ * @struct snapshot
+ * @brief Counter values summed over all threads at one moment.
+ */
+struct snapshot {
+    uint64_t values[COUNTER_COUNT];
+
+    snapshot() {
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) values[c] = 0;
+    }
+
+    uint64_t operator[](counter c) const { return values[c]; }
+
+    /** @brief What happened between `earlier` and this snapshot. */
+    snapshot since(const snapshot& earlier) const {
+        snapshot d;
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) d.values[c] = values[c] - earlier.values[c];
+        return d;
+    }
+};
+
+namespace internal {
+#if defined(SEVAL_STATS_STD_THREADS)
+typedef std::atomic<uint64_t> stats_cell; /* written by one thread, read by `collect` */
+
+SEVAL_INLINE uint64_t load(const stats_cell& cell) { return cell.load(std::memory_order_relaxed); }
+SEVAL_INLINE void store(stats_cell& cell, uint64_t v) { cell.store(v, std::memory_order_relaxed); }
+#else
+typedef volatile uint64_t stats_cell;
+
+SEVAL_INLINE uint64_t load(const stats_cell& cell) { return cell; }
+SEVAL_INLINE void store(stats_cell& cell, uint64_t v) { cell = v; }
+#endif
+
+/**
+ * @brief The counters of one thread; the padding keeps neighbouring blocks off its cache lines.
+ */
+struct stats_block {
+    char before[64];
+    stats_cell cells[COUNTER_COUNT];
+    stats_block* prev;
+    stats_block* next;
+    char after[64];
+
+    stats_block() : prev(NULL), next(NULL) {
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) store(cells[c], 0);
+    }
+
+private:
+    stats_block(const stats_block&);
+    stats_block& operator=(const stats_block&);
+};
+
+class stats_mutex {
+public:
+#if defined(SEVAL_STATS_STD_THREADS)
+    stats_mutex() {}
+    void lock() { m_.lock(); }
+    void unlock() { m_.unlock(); }
+#elif defined(SEVAL_STATS_PTHREAD_MUTEX)
+    stats_mutex() { pthread_mutex_init(&m_, NULL); }
+    ~stats_mutex() { pthread_mutex_destroy(&m_); }
+    void lock() { pthread_mutex_lock(&m_); }
+    void unlock() { pthread_mutex_unlock(&m_); }
+#else
+    stats_mutex() {}
+    void lock() {}
+    void unlock() {}
+#endif
+
+private:
+    stats_mutex(const stats_mutex&);
+    stats_mutex& operator=(const stats_mutex&);
+
+#if defined(SEVAL_STATS_STD_THREADS)
+    std::mutex m_;
+#elif defined(SEVAL_STATS_PTHREAD_MUTEX)
+    pthread_mutex_t m_;
+#endif
+};
+
+/* every live block, and the totals of the blocks whose threads exited */
+struct stats_registry {
+    stats_mutex lock;
+    stats_block* head;
+    uint64_t retired[COUNTER_COUNT];
+
+    stats_registry() : head(NULL) {
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) retired[c] = 0;
+    }
+};
+
+SEVAL_INLINE stats_registry& registry() {
+    static stats_registry r;
+    return r;
+}
+
+SEVAL_INLINE stats_block* attach() {
+    stats_block* b = new stats_block;
+    stats_registry& r = registry();
+    r.lock.lock();
+    b->next = r.head;
+    if (r.head) r.head->prev = b;
+    r.head = b;
+    r.lock.unlock();
+    return b;
+}
+
+#if defined(SEVAL_STATS_STD_THREADS)
+/* owns the block of a thread; folds it into the retired totals when the thread exits */
+struct stats_owner {
+    stats_block* block;
+
+    stats_owner() : block(attach()) {}
+
+    ~stats_owner() {
+        stats_registry& r = registry();
+        r.lock.lock();
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) r.retired[c] += load(block->cells[c]);
+        if (block->prev) block->prev->next = block->next; else r.head = block->next;
+        if (block->next) block->next->prev = block->prev;
+        r.lock.unlock();
+        delete block;
+    }
+};
+
+SEVAL_INLINE stats_block& local() {
+    static thread_local stats_owner owner;
+    return *owner.block;
+}
+#elif defined(SEVAL_STATS_TLS)
+/* blocks of exited threads stay registered, so their counts are kept */
+SEVAL_INLINE stats_block& local() {
+    static SEVAL_STATS_TLS stats_block* block = NULL;
+    if (!block) block = attach();
+    return *block;
+}
+#else
+SEVAL_INLINE stats_block& local() {
+    static stats_block* block = attach();
+    return *block;
+}
+#endif
+
+SEVAL_INLINE void add_local(counter c, uint64_t n) {
+    stats_cell& cell = local().cells[c];
+    store(cell, load(cell) + n);
+}
+
+/**
+ * @brief Adds `n` to a counter of the calling thread; a no-op during constant evaluation.
+ */
+#if defined(__cpp_lib_is_constant_evaluated)
+constexpr void add(counter c, uint64_t n) {
+    if (std::is_constant_evaluated()) return;
+    add_local(c, n);
+}
+#else
+SEVAL_INLINE void add(counter c, uint64_t n) { add_local(c, n); }
+#endif
+} /* internal */
+
+/**
+ * @brief Sums every counter over all threads.
+ *
+ * Increments racing with the call may or may not be included.
+ */
+SEVAL_INLINE snapshot collect() {
+    snapshot s;
+    internal::stats_registry& r = internal::registry();
+    r.lock.lock();
+    for (size_t c = 0; c < COUNTER_COUNT; ++c) s.values[c] = r.retired[c];
+    for (internal::stats_block* b = r.head; b; b = b->next) {
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) s.values[c] += internal::load(b->cells[c]);
+    }
+    r.lock.unlock();
+    return s;
+}
+
+/**
+ * @brief Whether the kernels were compiled with counting enabled (`SEVAL_STATS`).
+ */
+SEVAL_INLINE bool enabled() {
+#if defined(SEVAL_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+namespace internal {
+/* appends to a caller buffer, always NUL-terminated, counting what did not fit as well */
+class text_sink {
+public:
+    text_sink(char* out, size_t capacity) : out_(out), capacity_(capacity), length_(0) {
+        if (capacity_ != 0) out_[0] = '\0';
+    }
+
+    void put(const char* text) { write(text, strlen(text)); }
+
+    void put(uint64_t v) {
+        char digits[24];
+        size_t n = sizeof(digits);
+        do {
+            digits[--n] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        write(digits + n, sizeof(digits) - n);
+    }
+
+    /* non-negative shares with six fraction digits, trailing zeros dropped; printf would follow LC_NUMERIC */
+    void put(double v) {
+        if (!(v > 0.0)) v = 0.0;
+        if (v > 1e18) v = 1e18;
+        uint64_t whole = static_cast<uint64_t>(v);
+        uint64_t micros = static_cast<uint64_t>((v - static_cast<double>(whole)) * 1000000.0 + 0.5);
+        if (micros >= 1000000) {
+            ++whole;
+            micros = 0;
+        }
+        put(whole);
+        if (micros == 0) return;
+
+        char fraction[8] = { '.' };
+        size_t n = 7;
+        for (size_t i = 6; i != 0; --i, micros /= 10) fraction[i] = static_cast<char>('0' + micros % 10);
+        while (fraction[n - 1] == '0') --n;
+        write(fraction, n);
+    }
+
+    size_t length() const { return length_; }
+
+private:
+    void write(const char* text, size_t n) {
+        if (length_ + 1 < capacity_) {
+            size_t room = capacity_ - 1 - length_;
+            size_t copied = n < room ? n : room;
+            memcpy(out_ + length_, text, copied);
+            out_[length_ + copied] = '\0';
+        }
+        length_ += n;
+    }
+
+    char* out_;
+    size_t capacity_;
+    size_t length_;
+};
+
+/* one metric family: the counters of family `kind`, then their shares if `ratio` is set */
+SEVAL_INLINE void render_family(text_sink& out, const snapshot& s, family kind, const char* name, const char* label, const char* help, bool ratio) {
+    out.put("# HELP ");
+    out.put(name);
+    out.put(" ");
+    out.put(help);
+    out.put("\n# TYPE ");
+    out.put(name);
+    out.put(ratio ? " gauge\n" : " counter\n");
+
+    for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+        const counter_info& info = describe(static_cast<counter>(c));
+        if (info.kind != kind) continue;
+
+        out.put(name);
+        out.put("{kernel=\"");
+        out.put(info.kernel);
+        if (label) {
+            out.put("\",");
+            out.put(label);
+            out.put("=\"");
+            out.put(info.path);
+        }
+        out.put("\"} ");
+        if (ratio) {
+            uint64_t base = info.base == COUNTER_COUNT ? 0 : s.values[info.base];
+            out.put(base == 0 ? 0.0 : static_cast<double>(s.values[c]) / static_cast<double>(base));
+        } else {
+            out.put(s.values[c]);
+        }
+        out.put("\n");
+    }
+}
+} /* internal */
+
+/**
+ * @brief Renders a snapshot in the Prometheus text exposition format.
+ *
+ * Families: `seval_calls_total`, `seval_bytes_total` and `seval_fields_total` per kernel,
+ * `seval_path_total` and `seval_errors_total` per kernel and path, `seval_path_ratio` (each path's
+ * share of its kernel's calls, fields or bytes) and `seval_stats_enabled`. Nothing is allocated.
+ *
+ * @param s The counters to render.
+ * @param out The buffer to write into; always NUL-terminated if `capacity` is not 0.
+ * @param capacity The size of `out` in bytes.
+ *
+ * @return The length of the full text, excluding the NUL; the text was cut short if this is not
+ *         below `capacity` (as with `snprintf`).
+ */
+SEVAL_INLINE size_t render_prometheus(const snapshot& s, char* out, size_t capacity) {
+    internal::text_sink sink(out, capacity);
+    internal::render_family(sink, s, FAMILY_CALLS, "seval_calls_total", NULL, "Calls of each seval parsing kernel.", false);
+    internal::render_family(sink, s, FAMILY_BYTES, "seval_bytes_total", NULL, "Bytes consumed by each seval parsing kernel.", false);
+    internal::render_family(sink, s, FAMILY_FIELDS, "seval_fields_total", NULL, "Fields parsed by each seval batch kernel.", false);
+    internal::render_family(sink, s, FAMILY_PATH, "seval_path_total", "path", "Calls, fields or bytes of each seval kernel that took a path.", false);
+    internal::render_family(sink, s, FAMILY_PATH, "seval_path_ratio", "path", "Share of each seval kernel's calls, fields or bytes that took a path.", true);
+    internal::render_family(sink, s, FAMILY_ERROR, "seval_errors_total", "kind", "Inputs rejected by each seval kernel, by reason.", false);
+    sink.put("# HELP seval_stats_enabled Whether seval was compiled with SEVAL_STATS.\n# TYPE seval_stats_enabled gauge\nseval_stats_enabled ");
+    sink.put(static_cast<uint64_t>(enabled() ? 1 : 0));
+    sink.put("\n");
+    return sink.length();
+}
+
+/**
+ * @brief Renders the current totals (see `collect`) in the Prometheus text exposition format.
+ */
+SEVAL_INLINE size_t render_prometheus(char* out, size_t capacity) {
+    return render_prometheus(collect(), out, capacity);
+}
+
+} /* stats */
+
+} /* seval */
+
+#endif // SEVAL_STATS_HPP_LOADED
@@ -0,0 +1,344 @@
+/**
+ * @file seval_trace.hpp
+ * @brief Opt-in per-call tracing of the parsing kernels into per-thread ring buffers.
+ *
+ * Defining `SEVAL_TRACE` before including seval.hpp makes every call of `evaluate`, `evaluate_n`,
+ * `evaluate_field` and the column parsers of seval_batch.hpp append one `trace_event` (kernel,
+ * input length, start timestamp and duration) to a ring owned by the calling thread. Writers never
+ * lock or share a cache line; a ring keeps the latest `SEVAL_TRACE_CAPACITY` events and overwrites
+ * older ones. `dump` writes every ring to a binary file for offline analysis (see `dump` for the
+ * layout). Without `SEVAL_TRACE` the hooks expand to nothing and `dump` writes empty rings.
+ *
+ * Timestamps are TSC cycles on x86, virtual counter ticks on AArch64 and nanoseconds elsewhere
+ * (see `clock_kind`).
+ */
+
+#pragma once
+
+#if !defined(SEVAL_TRACE_HPP_LOADED)
+#define SEVAL_TRACE_HPP_LOADED
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "seval_stats.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SEVAL_TRACE_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SEVAL_TRACE_RDTSC 1
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define SEVAL_TRACE_CNTVCT 1
+#elif __cplusplus >= 201103L
+#include <chrono>
+#else
+#include <time.h>
+#endif
+
+/* Events kept per thread; a power of two. */
+#if !defined(SEVAL_TRACE_CAPACITY)
+#define SEVAL_TRACE_CAPACITY 4096
+#endif // SEVAL_TRACE_CAPACITY
+
+#if defined(__cpp_lib_is_constant_evaluated)
+#define SEVAL_TRACE_CONSTEXPR constexpr
+#else
+#define SEVAL_TRACE_CONSTEXPR
+#endif
+
+namespace seval {
+
+namespace trace {
+
+/**
+ * @brief The traced entry points.
+ */
+enum kernel {
+    KERNEL_EVALUATE = 0,             /**< `seval::evaluate`; the length is the characters consumed. */
+    KERNEL_EVALUATE_N,               /**< `seval::evaluate_n`; same. */
+    KERNEL_EVALUATE_FIELD,           /**< `seval::evaluate_field`; the length is the field's. */
+    KERNEL_INDEX_FIELDS,             /**< `batch::index_fields`; the length is the buffer's. */
+    KERNEL_PARSE_COLUMN,             /**< `batch::parse_column`; same. */
+    KERNEL_PARSE_COLUMN_DICTIONARY,  /**< `batch::parse_column_dictionary`; same. */
+    KERNEL_PARSE_COLUMN_ZONES,       /**< `batch::parse_column_zones`; same. */
+    KERNEL_PARSE_COLUMN_ADAPTIVE,    /**< `batch::parse_column_adaptive`; same. */
+    KERNEL_PARSE_COLUMN_BUCKETED,    /**< `batch::parse_column_bucketed`; same. */
+    KERNEL_PARSE_COLUMN_INTERLEAVED, /**< `batch::parse_column_interleaved`; same. */
+    KERNEL_PARSE_GATHER,             /**< `parse_gather`; the length is the number of strings. */
+    KERNEL_PARSE_COLUMN_PADDED,      /**< `batch::parse_column_padded`; the length is the buffer's. */
+    KERNEL_PARSE_COLUMN_PAGE_SAFE,   /**< `batch::parse_column_page_safe`; same. */
+    KERNEL_COUNT                     /**< Number of kernels. */
+};
+
+/**
+ * @brief Name of a kernel, as used in reports.
+ */
+SEVAL_INLINE const char* kernel_name(uint32_t k) {
+    static const char* const names[KERNEL_COUNT] = {
+        "evaluate", "evaluate_n", "evaluate_field", "index_fields", "parse_column", "parse_column_dictionary", "parse_column_zones",
+        "parse_column_adaptive", "parse_column_bucketed", "parse_column_interleaved",
+        "parse_gather", "parse_column_padded", "parse_column_page_safe"
+    };
+    return k < KERNEL_COUNT ? names[k] : "unknown";
+}
+
+/**
+ * @brief Unit of the timestamps.
+ */
+enum clock_kind {
+    CLOCK_TSC = 0,         /**< x86 time-stamp counter cycles. */
+    CLOCK_CNTVCT = 1,      /**< AArch64 virtual counter ticks. */
+    CLOCK_NANOSECONDS = 2  /**< Nanoseconds of a steady clock. */
+};
+
+/**
+ * @struct trace_event
+ * @brief One traced call, 24 bytes, written to the dump as is (native byte order).
+ */
+struct trace_event {
+    uint64_t start;   /**< Timestamp at entry. */
+    uint64_t length;  /**< Input length in bytes (see `kernel`). */
+    uint32_t ticks;   /**< Duration in timestamp units, saturated at 2^32 - 1. */
+    uint32_t kernel;  /**< A `kernel`. */
+};
+
+namespace internal {
+/**
+ * @brief Current timestamp.
+ */
+SEVAL_INLINE uint64_t timestamp() {
+#if defined(SEVAL_TRACE_RDTSC)
+    return static_cast<uint64_t>(__rdtsc());
+#elif defined(SEVAL_TRACE_CNTVCT)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#elif __cplusplus >= 201103L
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+    return static_cast<uint64_t>(clock()) * (1000000000ULL / CLOCKS_PER_SEC);
+#endif
+}
+
+SEVAL_INLINE clock_kind timestamp_kind() {
+#if defined(SEVAL_TRACE_RDTSC)
+    return CLOCK_TSC;
+#elif defined(SEVAL_TRACE_CNTVCT)
+    return CLOCK_CNTVCT;
+#else
+    return CLOCK_NANOSECONDS;
+#endif
+}
+
+/**
+ * @brief The events of one thread. Only the owning thread writes; `head` counts every event ever
+ *        written, so the ring holds the last `min(head, capacity)` of them.
+ */
+struct trace_ring {
+    enum { capacity = SEVAL_TRACE_CAPACITY };
+
+    char before[64];
+    trace_event events[capacity];
+    stats::internal::stats_cell head;
+    uint32_t thread;  /* registration order, stable for the life of the ring */
+    bool live;        /* false once the owning thread exited; the ring is then reused */
+    trace_ring* next;
+    char after[64];
+
+    trace_ring() : thread(0), live(true), next(NULL) {
+        stats::internal::store(head, 0);
+    }
+
+private:
+    trace_ring(const trace_ring&);
+    trace_ring& operator=(const trace_ring&);
+};
+
+struct trace_registry {
+    stats::internal::stats_mutex lock;
+    trace_ring* head;
+    uint32_t rings;
+
+    trace_registry() : head(NULL), rings(0) {}
+};
+
+SEVAL_INLINE trace_registry& registry() {
+    static trace_registry r;
+    return r;
+}
+
+/* hands out the ring of an exited thread if there is one, a new ring otherwise */
+SEVAL_INLINE trace_ring* attach() {
+    trace_registry& r = registry();
+    r.lock.lock();
+    trace_ring* ring = r.head;
+    while (ring && ring->live) ring = ring->next;
+    if (ring) {
+        ring->live = true;
+    } else {
+        ring = new trace_ring;
+        ring->thread = r.rings++;
+        ring->next = r.head;
+        r.head = ring;
+    }
+    r.lock.unlock();
+    return ring;
+}
+
+#if defined(SEVAL_STATS_STD_THREADS)
+/* marks the ring of an exiting thread as reusable; its events stay until they are overwritten */
+struct trace_owner {
+    trace_ring* ring;
+
+    trace_owner() : ring(attach()) {}
+
+    ~trace_owner() {
+        trace_registry& r = registry();
+        r.lock.lock();
+        ring->live = false;
+        r.lock.unlock();
+    }
+};
+
+SEVAL_INLINE trace_ring& local() {
+    static thread_local trace_owner owner;
+    return *owner.ring;
+}
+#elif defined(SEVAL_STATS_TLS)
+SEVAL_INLINE trace_ring& local() {
+    static SEVAL_STATS_TLS trace_ring* ring = NULL;
+    if (!ring) ring = attach();
+    return *ring;
+}
+#else
+SEVAL_INLINE trace_ring& local() {
+    static trace_ring* ring = attach();
+    return *ring;
+}
+#endif
+
+SEVAL_INLINE void record(kernel k, uint64_t start, uint64_t end, uint64_t length) {
+    trace_ring& ring = local();
+    uint64_t h = stats::internal::load(ring.head);
+    trace_event& e = ring.events[h & (trace_ring::capacity - 1)];
+    uint64_t ticks = end - start;
+    e.start = start;
+    e.length = length;
+    e.ticks = ticks > 0xFFFFFFFFu ? 0xFFFFFFFFu : static_cast<uint32_t>(ticks);
+    e.kernel = static_cast<uint32_t>(k);
+#if defined(SEVAL_STATS_STD_THREADS)
+    ring.head.store(h + 1, std::memory_order_release);
+#else
+    stats::internal::store(ring.head, h + 1);
+#endif
+}
+
+/**
+ * @brief Traces the enclosing call: records `length` as it is when the scope ends.
+ */
+class span {
+public:
+    SEVAL_TRACE_CONSTEXPR span(kernel k, const size_t& length) : kernel_(k), length_(length), start_(0) {
+#if defined(__cpp_lib_is_constant_evaluated)
+        if (std::is_constant_evaluated()) return;
+#endif
+        start_ = timestamp();
+    }
+
+    SEVAL_TRACE_CONSTEXPR ~span() {
+#if defined(__cpp_lib_is_constant_evaluated)
+        if (std::is_constant_evaluated()) return;
+#endif
+        record(kernel_, start_, timestamp(), length_);
+    }
+
+private:
+    span(const span&);
+    span& operator=(const span&);
+
+    kernel kernel_;
+    const size_t& length_;
+    uint64_t start_;
+};
+
+template <typename V>
+SEVAL_INLINE bool write_value(FILE* f, const V& v) {
+    return fwrite(&v, sizeof(V), 1, f) == 1;
+}
+} /* internal */
+
+/**
+ * @brief Calls traced by this thread so far (0 without `SEVAL_TRACE`).
+ */
+SEVAL_INLINE uint64_t local_count() {
+#if defined(SEVAL_TRACE)
+    return stats::internal::load(internal::local().head);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Writes every ring to an open binary stream.
+ *
+ * Layout, in native byte order:
+ * - header: `"SEVALTRC"`, `uint32_t` version (1), `uint32_t` `sizeof(trace_event)`,
+ *   `uint32_t` `clock_kind`, `uint32_t` ring count;
+ * - per ring: `uint32_t` thread number, `uint32_t` 1 if its thread is alive, `uint64_t` events
+ *   ever written, `uint64_t` events that follow, then those events, oldest first.
+ *
+ * Rings are copied under the registry lock but without stopping their writers, so events written
+ * during the dump may be missing or torn; dump between bursts of work for exact rings.
+ *
+ * @return `false` on a write error.
+ */
+SEVAL_INLINE bool dump(FILE* f) {
+    internal::trace_registry& r = internal::registry();
+    std::vector<trace_event> events;
+
+    r.lock.lock();
+    bool ok = fwrite("SEVALTRC", 1, 8, f) == 8;
+    ok = ok && internal::write_value(f, static_cast<uint32_t>(1));
+    ok = ok && internal::write_value(f, static_cast<uint32_t>(sizeof(trace_event)));
+    ok = ok && internal::write_value(f, static_cast<uint32_t>(internal::timestamp_kind()));
+    ok = ok && internal::write_value(f, r.rings);
+
+    for (internal::trace_ring* ring = r.head; ring && ok; ring = ring->next) {
+#if defined(SEVAL_STATS_STD_THREADS)
+        uint64_t written = ring->head.load(std::memory_order_acquire);
+#else
+        uint64_t written = stats::internal::load(ring->head);
+#endif
+        uint64_t capacity = internal::trace_ring::capacity;
+        uint64_t kept = written < capacity ? written : capacity;
+        events.resize(static_cast<size_t>(kept));
+        for (uint64_t k = 0; k < kept; ++k) {
+            events[static_cast<size_t>(k)] = ring->events[(written - kept + k) & (capacity - 1)];
+        }
+
+        ok = internal::write_value(f, ring->thread) && internal::write_value(f, static_cast<uint32_t>(ring->live ? 1 : 0));
+        ok = ok && internal::write_value(f, written) && internal::write_value(f, kept);
+        ok = ok && (events.empty() || fwrite(&events[0], sizeof(trace_event), events.size(), f) == events.size());
+    }
+    r.lock.unlock();
+    return ok;
+}
+
+/**
+ * @brief Writes every ring to a file (see `dump(FILE*)`), replacing it.
+ */
+SEVAL_INLINE bool dump(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = dump(f);
+    return fclose(f) == 0 && ok;
+}
+
+} /* trace */
+
+} /* seval */
+
+#endif // SEVAL_TRACE_HPP_LOADED
@@ -0,0 +1,803 @@
+/**
+ * @file seval_vm.hpp
+ * @brief Bytecode compiler and register VM for expressions.
+ *
+ * `compile` optimizes a parsed `seval::expr::expression` and lowers it to a compact register
+ * bytecode: every operation is specialized for its (statically known) operand types, literals
+ * become constant registers that were parsed once by the literal kernels, and variables become
+ * registers loaded once per run. `run` then executes the bytecode with a computed-goto dispatch loop (a `switch`
+ * loop on compilers without the GNU labels-as-values extension), so an expression applied to many
+ * rows is never re-parsed or re-walked.
+ *
+ * `run_columns` evaluates a program over whole columns instead: variables are bound to `double` or
+ * `int64_t` arrays (a program compiled with the column bindings keeps `int64_t` columns in integer
+ * registers, see `expression::declare`) and every instruction runs as a tight loop over a batch of
+ * `column_batch` rows, in the style of vectorized query engines, so dispatch is paid once per batch
+ * rather than per row and the per-instruction loops are left to the compiler's auto-vectorizer.
+ */
+
+#pragma once
+
+#if !defined(SEVAL_VM_HPP_LOADED)
+#define SEVAL_VM_HPP_LOADED
+
+#include <math.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "seval_expr.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(SEVAL_VM_NO_COMPUTED_GOTO)
+#define SEVAL_VM_COMPUTED_GOTO 1
+#endif
+
+namespace seval {
+
+namespace expr {
+
+/**
+ * @union slot
+ * @brief An untyped register; the bytecode knows which member is live.
+ */
+union slot {
+    int64_t i;
+    double f;
+};
+
+/**
+ * @enum vm_op
+ * @brief Bytecode operations, specialized by operand type (`_I` integer, `_F` double).
+ */
+enum vm_op {
+    VM_RET = 0, /**< stop; the result is in register `a` */
+    VM_CVT,     /**< dst = (double)a */
+    VM_ADD_I, VM_SUB_I, VM_MUL_I, VM_DIV_I, VM_MOD_I, VM_NEG_I, VM_ABS_I, VM_MIN_I, VM_MAX_I, VM_POW_I,
+    VM_ADD_F, VM_SUB_F, VM_MUL_F, VM_DIV_F, VM_MOD_F, VM_NEG_F, VM_ABS_F, VM_MIN_F, VM_MAX_F, VM_POW_F,
+    VM_SQRT_F,
+    VM_OP_COUNT
+};
+
+/**
+ * @struct instruction
+ * @brief One 8-byte instruction: `dst = op(a, b)` on register indexes.
+ */
+struct instruction {
+    uint8_t op;
+    uint8_t unused;
+    uint16_t dst;
+    uint16_t a;
+    uint16_t b;
+};
+
+/**
+ * @class program
+ * @brief Compiled expression.
+ *
+ * Register layout: constants first, then variables (in `variables` order), then temporaries.
+ */
+class program {
+public:
+    std::vector<instruction> code;         /**< The bytecode, ending with `VM_RET`. */
+    std::vector<slot> constants;           /**< Initial contents of the constant registers. */
+    std::vector<std::string> variables;    /**< Variable names; variable `v` lives in register `constants.size() + v`. */
+    std::vector<value_kind> variableKinds; /**< Type of every variable register (see `expression::declare`). */
+    std::vector<uint32_t> positions;       /**< Source offset of every instruction, for error messages. */
+    std::vector<uint32_t> slots;           /**< Row slot of every variable when compiled against a schema (see seval_schema.hpp), else empty. */
+    uint32_t registers;                    /**< Total number of registers. */
+    value_kind resultKind;                 /**< Type of the result. */
+    overflow_mode overflow;                /**< What integer instructions do on overflow. */
+
+    program() : registers(0), resultKind(KIND_INT), overflow(OVERFLOW_WRAP) {}
+
+    /** @brief Index of the first variable register. */
+    uint32_t variable_base() const { return static_cast<uint32_t>(constants.size()); }
+
+    /** @brief Type of variable `v`. */
+    value_kind variable_kind(size_t v) const { return v < variableKinds.size() ? variableKinds[v] : KIND_FLOAT; }
+};
+
+/** Maximum number of registers a program may use. */
+static const uint32_t max_registers = 0xFFFF;
+
+namespace internal {
+/**
+ * @brief Result type of every node (variables have their declared types).
+ */
+SEVAL_INLINE void infer_kinds(const expression& e, std::vector<value_kind>& kinds) {
+    kinds.resize(e.nodes.size());
+    for (size_t n = 0; n < e.nodes.size(); ++n) {
+        const node& nd = e.nodes[n];
+        switch (nd.op) {
+        case OP_CONST: kinds[n] = nd.constant.kind; break;
+        case OP_VAR:   kinds[n] = e.variable_kind(nd.a); break;
+        case OP_SQRT:  kinds[n] = KIND_FLOAT; break;
+        case OP_NEG:
+        case OP_ABS:   kinds[n] = kinds[nd.a]; break;
+        default:       kinds[n] = (kinds[nd.a] == KIND_INT && kinds[nd.b] == KIND_INT) ? KIND_INT : KIND_FLOAT; break;
+        }
+    }
+}
+
+SEVAL_INLINE vm_op vm_op_of(opcode op, value_kind kind) {
+    static const vm_op ints[OP_COUNT] = { VM_RET, VM_RET, VM_NEG_I, VM_ADD_I, VM_SUB_I, VM_MUL_I, VM_DIV_I, VM_MOD_I, VM_POW_I, VM_MIN_I, VM_MAX_I, VM_ABS_I, VM_SQRT_F };
+    static const vm_op floats[OP_COUNT] = { VM_RET, VM_RET, VM_NEG_F, VM_ADD_F, VM_SUB_F, VM_MUL_F, VM_DIV_F, VM_MOD_F, VM_POW_F, VM_MIN_F, VM_MAX_F, VM_ABS_F, VM_SQRT_F };
+    return kind == KIND_INT ? ints[op] : floats[op];
+}
+
+/**
+ * @class compiler
+ * @brief Lowers an AST to bytecode with use-count based register reuse.
+ */
+class compiler {
+public:
+    compiler(const expression& e, program& out, error* err) : e_(e), out_(out), err_(err) {}
+
+    bool run() {
+        out_.code.clear();
+        out_.constants.clear();
+        out_.positions.clear();
+        out_.variables = e_.variables;
+        out_.variableKinds = e_.variableKinds;
+        out_.variableKinds.resize(e_.variables.size(), KIND_FLOAT);
+        out_.slots.clear(); /* a program compiled against a schema may be reused without one */
+        out_.registers = 0;
+
+        if (e_.nodes.empty()) return fail(err_, 0, "empty expression");
+
+        infer_kinds(e_, kinds_);
+        out_.resultKind = kinds_[e_.root];
+
+        size_t count = e_.nodes.size();
+        uses_.assign(count, 0);
+        reg_.assign(count, 0);
+        floatReg_.assign(count, NO_REGISTER);
+        uses_[e_.root] = 1;
+        for (size_t n = 0; n < count; ++n) {
+            const node& nd = e_.nodes[n];
+            unsigned args = arity(nd.op);
+            if (args >= 1) ++uses_[nd.a];
+            if (args >= 2) ++uses_[nd.b];
+        }
+
+        /* pass 1: constant registers, in the type each use needs (integer literals used as doubles are converted here) */
+        if (e_.nodes[e_.root].op == OP_CONST) reg_[e_.root] = constant(e_.nodes[e_.root].constant);
+        for (size_t n = 0; n < count; ++n) {
+            const node& nd = e_.nodes[n];
+            if (arity(nd.op) != 0 && uses_[n]) {
+                bool wantsFloat = kinds_[n] == KIND_FLOAT || nd.op == OP_SQRT;
+                add_constant(nd.a, wantsFloat);
+                if (arity(nd.op) == 2) add_constant(nd.b, wantsFloat);
+            }
+        }
+
+        uint32_t base = static_cast<uint32_t>(out_.constants.size());
+        next_ = base + static_cast<uint32_t>(out_.variables.size());
+
+        /* pass 2: instructions */
+        for (size_t n = 0; n < count; ++n) {
+            const node& nd = e_.nodes[n];
+            if (!uses_[n]) continue;
+
+            if (nd.op == OP_CONST) continue;
+            if (nd.op == OP_VAR) {
+                reg_[n] = base + nd.a;
+                continue;
+            }
+
+            bool wantsFloat = kinds_[n] == KIND_FLOAT || nd.op == OP_SQRT;
+            uint32_t a = 0, b = 0;
+            if (!operand(nd.a, wantsFloat, a)) return false;
+            if (arity(nd.op) == 2) {
+                if (!operand(nd.b, wantsFloat, b)) return false;
+            } else {
+                b = a;
+            }
+
+            release(nd.a);
+            if (arity(nd.op) == 2) release(nd.b);
+
+            uint32_t dst = 0;
+            if (!allocate(dst)) return false;
+            reg_[n] = dst;
+            emit(vm_op_of(nd.op, wantsFloat ? KIND_FLOAT : KIND_INT), dst, a, b, nd.position);
+        }
+
+        emit(VM_RET, 0, reg_[e_.root], 0, e_.nodes[e_.root].position);
+        out_.registers = next_;
+        return true;
+    }
+
+private:
+    enum { NO_REGISTER = 0xFFFFFFFFu };
+
+    uint32_t constant(const value& v) {
+        slot s;
+        if (v.kind == KIND_INT) s.i = v.i; else s.f = v.f;
+        for (size_t k = 0; k < out_.constants.size(); ++k) {
+            if (memcmp(&out_.constants[k], &s, sizeof(s)) == 0 && constantKinds_[k] == v.kind) return static_cast<uint32_t>(k);
+        }
+        out_.constants.push_back(s);
+        constantKinds_.push_back(v.kind);
+        return static_cast<uint32_t>(out_.constants.size() - 1);
+    }
+
+    void add_constant(uint32_t n, bool wantsFloat) {
+        const node& nd = e_.nodes[n];
+        if (nd.op != OP_CONST) return;
+        if (wantsFloat && nd.constant.kind == KIND_INT) {
+            if (floatReg_[n] == NO_REGISTER) floatReg_[n] = constant(value::from_float(static_cast<double>(nd.constant.i)));
+        } else {
+            reg_[n] = constant(nd.constant);
+        }
+    }
+
+    /* register holding node `n` in the requested type, converting integers if needed */
+    bool operand(uint32_t n, bool wantsFloat, uint32_t& reg) {
+        if (!wantsFloat || kinds_[n] == KIND_FLOAT) {
+            reg = reg_[n];
+            return true;
+        }
+        if (floatReg_[n] == NO_REGISTER) {
+            uint32_t dst = 0;
+            if (!allocate(dst)) return false;
+            emit(VM_CVT, dst, reg_[n], reg_[n], e_.nodes[n].position);
+            floatReg_[n] = dst;
+            converted_.push_back(n);
+        }
+        reg = floatReg_[n];
+        return true;
+    }
+
+    /* drops one use of node `n`, recycling its temporaries after the last use */
+    void release(uint32_t n) {
+        if (--uses_[n] != 0) return;
+        uint32_t firstTemp = static_cast<uint32_t>(out_.constants.size() + out_.variables.size());
+        if (reg_[n] >= firstTemp && arity(e_.nodes[n].op) != 0) free_.push_back(reg_[n]);
+        for (size_t c = 0; c < converted_.size(); ++c) {
+            if (converted_[c] == n) {
+                free_.push_back(floatReg_[n]);
+                converted_[c] = converted_.back();
+                converted_.pop_back();
+                break;
+            }
+        }
+    }
+
+    bool allocate(uint32_t& reg) {
+        if (!free_.empty()) {
+            reg = free_.back();
+            free_.pop_back();
+            return true;
+        }
+        if (next_ >= max_registers) return fail(err_, 0, "expression needs too many registers");
+        reg = next_++;
+        return true;
+    }
+
+    void emit(vm_op op, uint32_t dst, uint32_t a, uint32_t b, uint32_t position) {
+        instruction in;
+        in.op = static_cast<uint8_t>(op);
+        in.unused = 0;
+        in.dst = static_cast<uint16_t>(dst);
+        in.a = static_cast<uint16_t>(a);
+        in.b = static_cast<uint16_t>(b);
+        out_.code.push_back(in);
+        out_.positions.push_back(position);
+    }
+
+    const expression& e_;
+    program& out_;
+    error* err_;
+    std::vector<value_kind> kinds_;
+    std::vector<value_kind> constantKinds_;
+    std::vector<uint32_t> uses_;
+    std::vector<uint32_t> reg_;
+    std::vector<uint32_t> floatReg_;
+    std::vector<uint32_t> converted_;
+    std::vector<uint32_t> free_;
+    uint32_t next_;
+};
+
+/**
+ * @brief Executes integer instruction `at` under the program's overflow mode.
+ */
+SEVAL_INLINE bool execute_int(const program& p, size_t at, opcode op, int64_t x, int64_t y, slot& out, error* err) {
+    if (int_apply(op, x, y, p.overflow, out.i)) return true;
+    return fail(err, p.positions[at], int_failure(op, y));
+}
+
+/**
+ * @brief Executes a program on an initialized register file.
+ *
+ * @param p The program.
+ * @param r The registers: constants and variables loaded, temporaries uninitialized.
+ * @param result Receives the result register.
+ * @param err If not `NULL`, receives the reason and position of a failure.
+ *
+ * @return `false` for integer division or modulo by zero and trapped integer overflow.
+ */
+SEVAL_INLINE bool execute(const program& p, slot* r, slot& result, error* err) {
+    const instruction* code = &p.code[0];
+    const instruction* pc = code;
+
+#if defined(SEVAL_VM_COMPUTED_GOTO)
+    static const void* labels[VM_OP_COUNT] = {
+        &&L_VM_RET, &&L_VM_CVT,
+        &&L_VM_ADD_I, &&L_VM_SUB_I, &&L_VM_MUL_I, &&L_VM_DIV_I, &&L_VM_MOD_I, &&L_VM_NEG_I, &&L_VM_ABS_I, &&L_VM_MIN_I, &&L_VM_MAX_I, &&L_VM_POW_I,
+        &&L_VM_ADD_F, &&L_VM_SUB_F, &&L_VM_MUL_F, &&L_VM_DIV_F, &&L_VM_MOD_F, &&L_VM_NEG_F, &&L_VM_ABS_F, &&L_VM_MIN_F, &&L_VM_MAX_F, &&L_VM_POW_F,
+        &&L_VM_SQRT_F,
+    };
+#define SEVAL_VM_CASE(name) L_##name:
+#define SEVAL_VM_NEXT() do { ++pc; goto *labels[pc->op]; } while (0)
+    goto *labels[pc->op];
+#else
+#define SEVAL_VM_CASE(name) case name:
+#define SEVAL_VM_NEXT() do { ++pc; goto dispatch; } while (0)
+dispatch:
+    switch (pc->op) {
+#endif
+
+    SEVAL_VM_CASE(VM_RET) {
+        result = r[pc->a];
+        return true;
+    }
+    SEVAL_VM_CASE(VM_CVT) { r[pc->dst].f = static_cast<double>(r[pc->a].i); SEVAL_VM_NEXT(); }
+
+#define SEVAL_VM_INT(op) do { if (!execute_int(p, pc - code, op, r[pc->a].i, r[pc->b].i, r[pc->dst], err)) return false; } while (0)
+    SEVAL_VM_CASE(VM_ADD_I) { SEVAL_VM_INT(OP_ADD); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_SUB_I) { SEVAL_VM_INT(OP_SUB); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MUL_I) { SEVAL_VM_INT(OP_MUL); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_DIV_I) { SEVAL_VM_INT(OP_DIV); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MOD_I) { SEVAL_VM_INT(OP_MOD); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_NEG_I) { SEVAL_VM_INT(OP_NEG); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_ABS_I) { SEVAL_VM_INT(OP_ABS); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MIN_I) { int64_t x = r[pc->a].i, y = r[pc->b].i; r[pc->dst].i = y < x ? y : x; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MAX_I) { int64_t x = r[pc->a].i, y = r[pc->b].i; r[pc->dst].i = x < y ? y : x; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_POW_I) { SEVAL_VM_INT(OP_POW); SEVAL_VM_NEXT(); }
+
+    SEVAL_VM_CASE(VM_ADD_F) { r[pc->dst].f = r[pc->a].f + r[pc->b].f; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_SUB_F) { r[pc->dst].f = r[pc->a].f - r[pc->b].f; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MUL_F) { r[pc->dst].f = r[pc->a].f * r[pc->b].f; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_DIV_F) { r[pc->dst].f = r[pc->a].f / r[pc->b].f; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MOD_F) { r[pc->dst].f = fmod(r[pc->a].f, r[pc->b].f); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_NEG_F) { r[pc->dst].f = -r[pc->a].f; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_ABS_F) { r[pc->dst].f = fabs(r[pc->a].f); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MIN_F) { double x = r[pc->a].f, y = r[pc->b].f; r[pc->dst].f = y < x ? y : x; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_MAX_F) { double x = r[pc->a].f, y = r[pc->b].f; r[pc->dst].f = x < y ? y : x; SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_POW_F) { r[pc->dst].f = pow(r[pc->a].f, r[pc->b].f); SEVAL_VM_NEXT(); }
+    SEVAL_VM_CASE(VM_SQRT_F) { r[pc->dst].f = sqrt(r[pc->a].f); SEVAL_VM_NEXT(); }
+
+#if !defined(SEVAL_VM_COMPUTED_GOTO)
+    default:
+        return fail(err, 0, "invalid instruction");
+    }
+#endif
+#undef SEVAL_VM_CASE
+#undef SEVAL_VM_NEXT
+#undef SEVAL_VM_INT
+}
+
+/**
+ * @brief Loads a value into the register of a variable of type `kind`.
+ * @return `false` if an integer variable gets a non-integral value.
+ */
+SEVAL_INLINE bool load_variable(value_kind kind, double d, slot& s) {
+    if (kind == KIND_FLOAT) {
+        s.f = d;
+        return true;
+    }
+    return integral(d, s.i);
+}
+
+/**
+ * @brief Loads the variable registers from a row (see `run(const program&, const double*, ...)`).
+ * @return `false` if an integer variable gets a non-integral value.
+ */
+SEVAL_INLINE bool load_row(const program& p, const double* row, slot* r, error* err) {
+    uint32_t base = p.variable_base();
+    for (size_t v = 0; v < p.variables.size(); ++v) {
+        double d = row[p.slots.empty() ? v : p.slots[v]];
+        if (!load_variable(p.variable_kind(v), d, r[base + v])) return fail(err, 0, "integer variable bound to a non-integer value");
+    }
+    return true;
+}
+
+/**
+ * @brief Builds a row for `run(const program&, const double*, ...)` from named bindings.
+ */
+SEVAL_INLINE bool bind_row(const program& p, const bindings& vars, std::vector<double>& row, error* err) {
+    size_t width = p.variables.size();
+    for (size_t v = 0; v < p.slots.size(); ++v) width = p.slots[v] + 1 > width ? p.slots[v] + 1 : width;
+    row.assign(width, 0.0);
+    for (size_t v = 0; v < p.variables.size(); ++v) {
+        bindings::const_iterator it = vars.find(p.variables[v]);
+        if (it == vars.end()) return fail(err, 0, "unbound variable");
+        row[p.slots.empty() ? v : p.slots[v]] = it->second;
+    }
+    return true;
+}
+
+/**
+ * @brief Register file on the stack for small programs, on the heap otherwise.
+ */
+class register_file {
+public:
+    explicit register_file(const program& p) : regs_(small_) {
+        if (p.registers > small_size) {
+            heap_.resize(p.registers);
+            regs_ = &heap_[0];
+        }
+        if (!p.constants.empty()) memcpy(regs_, &p.constants[0], p.constants.size() * sizeof(slot));
+    }
+
+    slot* get() { return regs_; }
+
+private:
+    static const size_t small_size = 64;
+
+    slot small_[small_size];
+    std::vector<slot> heap_;
+    slot* regs_;
+};
+} /* internal */
+
+/**
+ * @brief Optimizes (see `seval::expr::optimize`) and compiles a parsed expression to bytecode.
+ *
+ * @param e The expression.
+ * @param out Receives the program.
+ * @param err If not `NULL`, receives the reason of a failure.
+ * @param mode What integer overflow does, at compile time and when run (default is `OVERFLOW_WRAP`).
+ *
+ * @return `true` on success, otherwise `false`.
+ */
+SEVAL_INLINE bool compile(const expression& e, program& out, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    expression optimized;
+    optimize(e, optimized, mode);
+    internal::compiler c(optimized, out, err);
+    out.overflow = mode;
+    if (c.run()) return true;
+    out.code.clear(); /* a partial program has no VM_RET */
+    return false;
+}
+
+/**
+ * @brief Parses and compiles an expression in one call.
+ */
+SEVAL_INLINE bool compile(const char* text, program& out, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    expression e;
+    return parse(text, e, err) && compile(e, out, err, mode);
+}
+
+/**
+ * @brief Runs a compiled expression.
+ *
+ * @param p The program.
+ * @param vars The variable bindings; every variable of the program must be bound, and integer
+ *        variables to integral values.
+ * @param result Receives the value of the expression.
+ * @param err If not `NULL`, receives the reason and position of a failure.
+ *
+ * @return `false` for unbound variables, non-integral values of integer variables, integer
+ *         division by zero and trapped integer overflow, otherwise `true`.
+ */
+SEVAL_INLINE bool run(const program& p, const bindings& vars, value& result, error* err = NULL) {
+    if (p.code.empty()) return internal::fail(err, 0, "empty program");
+
+    internal::register_file regs(p);
+    slot* r = regs.get();
+    uint32_t base = p.variable_base();
+    for (size_t v = 0; v < p.variables.size(); ++v) {
+        bindings::const_iterator it = vars.find(p.variables[v]);
+        if (it == vars.end()) return internal::fail(err, 0, "unbound variable");
+        if (!internal::load_variable(p.variable_kind(v), it->second, r[base + v])) {
+            return internal::fail(err, 0, "integer variable bound to a non-integer value");
+        }
+    }
+
+    slot s;
+    if (!internal::execute(p, r, s, err)) return false;
+    result.kind = p.resultKind;
+    if (p.resultKind == KIND_INT) result.i = s.i; else result.f = s.f;
+    return true;
+}
+
+/**
+ * @brief Runs a compiled program on a row of values, without any name lookup.
+ *
+ * @param p The program.
+ * @param row One value per variable in `p.variables` order or, for a program compiled against a
+ *        schema, one value per schema slot.
+ * @param result Receives the value of the expression.
+ * @param err If not `NULL`, receives the reason and position of a failure.
+ *
+ * @return `false` for non-integral values of integer variables, integer division by zero and
+ *         trapped integer overflow, otherwise `true`.
+ */
+SEVAL_INLINE bool run(const program& p, const double* row, value& result, error* err = NULL) {
+    if (p.code.empty()) return internal::fail(err, 0, "empty program");
+
+    internal::register_file regs(p);
+    slot* r = regs.get();
+    if (!internal::load_row(p, row, r, err)) return false;
+
+    slot s;
+    if (!internal::execute(p, r, s, err)) return false;
+    result.kind = p.resultKind;
+    if (p.resultKind == KIND_INT) result.i = s.i; else result.f = s.f;
+    return true;
+}
+
+/**
+ * @struct column_ref
+ * @brief A column bound to a variable for `run_columns`: a `double` or `int64_t` array.
+ */
+struct column_ref {
+    value_kind kind;  /**< Element type of `data`. */
+    const void* data; /**< The first element. */
+
+    column_ref() : kind(KIND_FLOAT), data(NULL) {}
+    column_ref(const double* d) : kind(KIND_FLOAT), data(d) {}
+    column_ref(const int64_t* i) : kind(KIND_INT), data(i) {}
+};
+
+/** Column bindings by variable name. */
+typedef std::map<std::string, column_ref> column_bindings;
+
+/** Rows processed per instruction step by `run_columns`. */
+static const size_t column_batch = 1024;
+
+/**
+ * @brief Compiles an expression for `run_columns` over the given columns: variables bound to
+ * `int64_t` columns are declared `KIND_INT` (see `expression::declare`), so their values stay exact
+ * and the arithmetic on them runs as integer instructions under `mode`.
+ */
+SEVAL_INLINE bool compile(const expression& e, const column_bindings& columns, program& out, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    expression typed(e);
+    for (column_bindings::const_iterator it = columns.begin(); it != columns.end(); ++it) {
+        if (it->second.kind == KIND_INT) typed.declare(it->first, KIND_INT);
+    }
+    return compile(typed, out, err, mode);
+}
+
+/**
+ * @brief Parses and compiles an expression for `run_columns` over the given columns.
+ */
+SEVAL_INLINE bool compile(const char* text, const column_bindings& columns, program& out, error* err = NULL, overflow_mode mode = OVERFLOW_WRAP) {
+    expression e;
+    return parse(text, e, err) && compile(e, columns, out, err, mode);
+}
+
+namespace internal {
+/**
+ * @brief Integer instruction `at` over `m` rows under a saturating or trapping overflow mode.
+ */
+SEVAL_INLINE bool execute_int_column(const program& p, size_t at, opcode op, const slot* a, const slot* b, slot* d, size_t m, error* err) {
+    for (size_t k = 0; k < m; ++k) {
+        if (!execute_int(p, at, op, a[k].i, b[k].i, d[k], err)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Executes a program on `m` rows at once; each register is an array of `m` slots.
+ *
+ * Wrapping and saturating addition and subtraction stay branch-free so the loops vectorize; the
+ * other integer operations under `OVERFLOW_SATURATE` or `OVERFLOW_TRAP` are checked row by row.
+ */
+SEVAL_INLINE bool execute_columns(const program& p, slot* const* r, size_t m, error* err) {
+    const instruction* code = &p.code[0];
+    const bool wrap = p.overflow == OVERFLOW_WRAP;
+    const bool saturate = p.overflow == OVERFLOW_SATURATE;
+
+    for (const instruction* pc = code; pc->op != VM_RET; ++pc) {
+        slot* d = r[pc->dst];
+        const slot* a = r[pc->a];
+        const slot* b = r[pc->b];
+        size_t k = 0;
+
+        switch (pc->op) {
+        case VM_CVT:   for (k = 0; k < m; ++k) d[k].f = static_cast<double>(a[k].i); break;
+
+        case VM_ADD_I:
+            if (wrap) for (k = 0; k < m; ++k) d[k].i = wrap_add(a[k].i, b[k].i);
+            else if (saturate) for (k = 0; k < m; ++k) d[k].i = saturating_add(a[k].i, b[k].i);
+            else if (!execute_int_column(p, pc - code, OP_ADD, a, b, d, m, err)) return false;
+            break;
+        case VM_SUB_I:
+            if (wrap) for (k = 0; k < m; ++k) d[k].i = wrap_sub(a[k].i, b[k].i);
+            else if (saturate) for (k = 0; k < m; ++k) d[k].i = saturating_sub(a[k].i, b[k].i);
+            else if (!execute_int_column(p, pc - code, OP_SUB, a, b, d, m, err)) return false;
+            break;
+        case VM_MUL_I:
+            if (wrap) for (k = 0; k < m; ++k) d[k].i = wrap_mul(a[k].i, b[k].i);
+            else if (!execute_int_column(p, pc - code, OP_MUL, a, b, d, m, err)) return false;
+            break;
+        case VM_DIV_I:
+        case VM_MOD_I: {
+            bool zero = false;
+            for (k = 0; k < m; ++k) zero |= b[k].i == 0;
+            if (zero) return fail(err, p.positions[pc - code], "integer division by zero");
+            if (!wrap) {
+                if (!execute_int_column(p, pc - code, pc->op == VM_DIV_I ? OP_DIV : OP_MOD, a, b, d, m, err)) return false;
+            } else if (pc->op == VM_DIV_I) {
+                for (k = 0; k < m; ++k) d[k].i = b[k].i == -1 ? wrap_neg(a[k].i) : a[k].i / b[k].i;
+            } else {
+                for (k = 0; k < m; ++k) d[k].i = b[k].i == -1 ? 0 : a[k].i % b[k].i;
+            }
+            break;
+        }
+        case VM_NEG_I:
+            if (wrap) for (k = 0; k < m; ++k) d[k].i = wrap_neg(a[k].i);
+            else if (!execute_int_column(p, pc - code, OP_NEG, a, a, d, m, err)) return false;
+            break;
+        case VM_ABS_I:
+            if (wrap) for (k = 0; k < m; ++k) d[k].i = a[k].i < 0 ? wrap_neg(a[k].i) : a[k].i;
+            else if (!execute_int_column(p, pc - code, OP_ABS, a, a, d, m, err)) return false;
+            break;
+        case VM_MIN_I: for (k = 0; k < m; ++k) d[k].i = b[k].i < a[k].i ? b[k].i : a[k].i; break;
+        case VM_MAX_I: for (k = 0; k < m; ++k) d[k].i = a[k].i < b[k].i ? b[k].i : a[k].i; break;
+        case VM_POW_I:
+            if (wrap) for (k = 0; k < m; ++k) d[k].i = int_pow(a[k].i, b[k].i);
+            else if (!execute_int_column(p, pc - code, OP_POW, a, b, d, m, err)) return false;
+            break;
+
+        case VM_ADD_F: for (k = 0; k < m; ++k) d[k].f = a[k].f + b[k].f; break;
+        case VM_SUB_F: for (k = 0; k < m; ++k) d[k].f = a[k].f - b[k].f; break;
+        case VM_MUL_F: for (k = 0; k < m; ++k) d[k].f = a[k].f * b[k].f; break;
+        case VM_DIV_F: for (k = 0; k < m; ++k) d[k].f = a[k].f / b[k].f; break;
+        case VM_MOD_F: for (k = 0; k < m; ++k) d[k].f = fmod(a[k].f, b[k].f); break;
+        case VM_NEG_F: for (k = 0; k < m; ++k) d[k].f = -a[k].f; break;
+        case VM_ABS_F: for (k = 0; k < m; ++k) d[k].f = fabs(a[k].f); break;
+        case VM_MIN_F: for (k = 0; k < m; ++k) d[k].f = b[k].f < a[k].f ? b[k].f : a[k].f; break;
+        case VM_MAX_F: for (k = 0; k < m; ++k) d[k].f = a[k].f < b[k].f ? b[k].f : a[k].f; break;
+        case VM_POW_F: for (k = 0; k < m; ++k) d[k].f = pow(a[k].f, b[k].f); break;
+        case VM_SQRT_F: for (k = 0; k < m; ++k) d[k].f = sqrt(a[k].f); break;
+
+        default:
+            return fail(err, 0, "invalid instruction");
+        }
+    }
+    return true;
+}
+
+/* a `double` column of an integer variable; false unless every value is integral */
+SEVAL_INLINE bool load_int_column(const double* src, slot* dst, size_t m) {
+    for (size_t k = 0; k < m; ++k) {
+        if (!integral(src[k], dst[k].i)) return false;
+    }
+    return true;
+}
+
+/* an `int64_t` column of a double variable; false if a value is beyond +-2^53, where doubles skip integers */
+SEVAL_INLINE bool load_float_column(const int64_t* src, slot* dst, size_t m) {
+    const int64_t limit = static_cast<int64_t>(1) << 53;
+    bool exact = true;
+    for (size_t k = 0; k < m; ++k) {
+        exact &= src[k] >= -limit && src[k] <= limit;
+        dst[k].f = static_cast<double>(src[k]);
+    }
+    return exact;
+}
+
+SEVAL_INLINE void store_column(const slot* result, value_kind kind, size_t m, double* out) {
+    for (size_t k = 0; k < m; ++k) out[k] = kind == KIND_INT ? static_cast<double>(result[k].i) : result[k].f;
+}
+
+SEVAL_INLINE void store_column(const slot* result, value_kind kind, size_t m, int64_t* out) {
+    (void)kind;
+    for (size_t k = 0; k < m; ++k) out[k] = result[k].i;
+}
+
+template <typename Out>
+SEVAL_INLINE bool run_columns(const program& p, const column_ref* columns, size_t rows, Out* out, error* err) {
+    if (p.code.empty()) return fail(err, 0, "empty program");
+
+    size_t batch = rows < column_batch ? rows : column_batch;
+    if (batch == 0) return true;
+
+    std::vector<slot> storage(static_cast<size_t>(p.registers) * batch);
+    std::vector<slot*> r(p.registers);
+    for (size_t reg = 0; reg < p.registers; ++reg) r[reg] = &storage[reg * batch];
+
+    for (size_t k = 0; k < p.constants.size(); ++k) {
+        for (size_t row = 0; row < batch; ++row) r[k][row] = p.constants[k];
+    }
+
+    uint32_t base = p.variable_base();
+    uint32_t result = p.code.back().a;
+
+    for (size_t start = 0; start < rows; start += batch) {
+        size_t m = rows - start < batch ? rows - start : batch;
+
+        for (size_t v = 0; v < p.variables.size(); ++v) {
+            value_kind kind = p.variable_kind(v);
+            slot* dst = &storage[(base + v) * batch];
+            if (columns[v].kind == kind) {
+                /* variable registers are never written, so columns of the variable's type are read in place */
+                const char* src = static_cast<const char*>(columns[v].data) + start * sizeof(slot);
+                r[base + v] = reinterpret_cast<slot*>(const_cast<char*>(src));
+            } else if (kind == KIND_INT) {
+                if (!load_int_column(static_cast<const double*>(columns[v].data) + start, dst, m)) {
+                    return fail(err, 0, "integer variable bound to a non-integer value");
+                }
+                r[base + v] = dst;
+            } else {
+                if (!load_float_column(static_cast<const int64_t*>(columns[v].data) + start, dst, m)) {
+                    return fail(err, 0, "integer column value beyond 2^53 bound to a double variable");
+                }
+                r[base + v] = dst;
+            }
+        }
+
+        if (!execute_columns(p, &r[0], m, err)) return false;
+        store_column(r[result], p.resultKind, m, out + start);
+    }
+    return true;
+}
+
+template <typename Out>
+SEVAL_INLINE bool run_columns_by_name(const program& p, const column_bindings& columns, size_t rows, Out* out, error* err) {
+    std::vector<column_ref> ordered(p.variables.size());
+    for (size_t v = 0; v < p.variables.size(); ++v) {
+        column_bindings::const_iterator it = columns.find(p.variables[v]);
+        if (it == columns.end()) return fail(err, 0, "unbound variable");
+        ordered[v] = it->second;
+    }
+    return run_columns(p, ordered.empty() ? NULL : &ordered[0], rows, out, err);
+}
+} /* internal */
+
+/**
+ * @brief Evaluates a program for every row of a set of columns.
+ *
+ * @param p The program.
+ * @param columns One column per variable, in `p.variables` order. Columns of the variable's type
+ *        are read in place; the others are converted batch by batch, which fails for non-integral
+ *        values of integer variables and for `int64_t` values beyond +-2^53 (where doubles lose
+ *        precision) of double variables. Compiling with the column bindings (see
+ *        `compile(const expression&, const column_bindings&, ...)`) makes `int64_t` columns exact.
+ * @param rows The number of rows.
+ * @param out Receives one result per row (integer results are converted).
+ * @param err If not `NULL`, receives the reason and position of a failure.
+ *
+ * @return `false` for a column value its variable cannot take, integer division by zero or trapped
+ *         integer overflow in any row, otherwise `true`.
+ */
+SEVAL_INLINE bool run_columns(const program& p, const column_ref* columns, size_t rows, double* out, error* err = NULL) {
+    return internal::run_columns(p, columns, rows, out, err);
+}
+
+/**
+ * @brief Evaluates an integer-valued program for every row of a set of columns.
+ *
+ * @return `false` if the program's result is not an integer, on integer division by zero and on
+ *         trapped integer overflow.
+ */
+SEVAL_INLINE bool run_columns(const program& p, const column_ref* columns, size_t rows, int64_t* out, error* err = NULL) {
+    if (p.resultKind != KIND_INT) return internal::fail(err, 0, "result is not an integer");
+    return internal::run_columns(p, columns, rows, out, err);
+}
+
+/**
+ * @brief Evaluates a program for every row, with columns bound by variable name.
+ */
+SEVAL_INLINE bool run_columns(const program& p, const column_bindings& columns, size_t rows, double* out, error* err = NULL) {
+    return internal::run_columns_by_name(p, columns, rows, out, err);
+}
+
+/**
+ * @brief Evaluates an integer-valued program for every row, with columns bound by variable name.
+ */
+SEVAL_INLINE bool run_columns(const program& p, const column_bindings& columns, size_t rows, int64_t* out, error* err = NULL) {
+    if (p.resultKind != KIND_INT) return internal::fail(err, 0, "result is not an integer");
+    return internal::run_columns_by_name(p, columns, rows, out, err);
+}
+
+} /* expr */
+
+} /* seval */
+
+#endif // SEVAL_VM_HPP_LOADED
@@ -1,7 +1,28 @@
 #include <iostream>
 #include <cassert>
+#include <locale.h>
 #include <stdint.h>
+#include <string>
+#include <vector>
+#if __cplusplus >= 201103L
+#include <thread>
+#endif
+#define SEVAL_STATS 1 /* the tests also check the path counters */
+#define SEVAL_TRACE 1 /* ... and the call trace */
 #include "include/seval.hpp"
+#include "include/seval_stats.hpp"
+#include "include/seval_trace.hpp"
+#include "include/seval_batch.hpp"
+#include "include/seval_arrow.hpp"
+#include "include/seval_lazy.hpp"
+#include "include/seval_file.hpp"
+#include "include/seval_expr.hpp"
+#include "include/seval_vm.hpp"
+#include "include/seval_jit.hpp"
+#include "include/seval_cache.hpp"
+#include "include/seval_schema.hpp"
+#include "include/seval_parallel.hpp"
+#include "include/seval_static.hpp"
 
 template <typename T>
 bool floatpoint_compare(T f1, T f2, T deviation = 1e-6) {
@@ -75,6 +96,26 @@ void seval_test() {
         assert((seval::evaluate<int, const char*>("-0b1101") == -0b1101));
         assert((seval::evaluate<int, const char*>("-0b101010") == -0b101010));
     }
+    /* SIGN AND PREFIX */
+    {
+        assert((seval::evaluate<uint8_t, const char*>("-1")) == 255); /* negation wraps around */
+        assert((seval::evaluate<uint64_t, const char*>("-2")) == UINT64_MAX - 1);
+        assert((seval::evaluate<int, const char*>("+0X1f") == 0x1f));
+        assert((seval::evaluate<int, const char*>("0B11") == 3));
+        assert((seval::evaluate<int, const char*>("0") == 0 && seval::evaluate<int, const char*>("-") == 0));
+        assert((seval::evaluate<int, const char*>("-12", false) == 0)); /* the sign is not part of the literal */
+        assert((seval::evaluate<int, const char*>("0x12", true, true, false) == 0)); /* stops at 'x' */
+        assert((seval::evaluate<int, const char*>("0b11", true, true, true, false) == 0));
+        assert((seval::evaluate<int, std::string>(std::string("-0x10")) == -16));
+        assert((seval::evaluate_n<int, const char*>("-0b1101", 4) == -0b1));
+
+        seval::internal::prologue head = seval::internal::read_prologue<const char*>("-0xff", 2, true, true, true);
+        assert(head.sign == seval::internal::SIGN_NEGATIVE && head.hasSign && head.radix == 10 && head.length == 1); /* no room for "0x" */
+        head = seval::internal::read_prologue<const char*>("+0b1", 4, true, true, true);
+        assert(head.sign == seval::internal::SIGN_POSITIVE && head.hasSign && head.radix == 2 && head.length == 3);
+        assert(floatpoint_compare(seval::evaluate<double, const char*>("-0"), -0.0));
+        assert((seval::evaluate<double, const char*>("-1.5") == -1.5));
+    }
 }
 
 void seval_test_n() {
@@ -106,9 +147,1585 @@ void seval_test_n() {
     }
 }
 
+void seval_test_field() {
+    /* Validation */
+    {
+        int i = -1;
+        assert(seval::evaluate_field<int>("123", 3, i) && i == 123);
+        assert(seval::evaluate_field<int>("-0x1f", 5, i) && i == -0x1f);
+        assert(seval::evaluate_field<int>("0b101", 5, i) && i == 5);
+        assert(seval::evaluate_field<int>("12,34", 2, i) && i == 12); /* stops at the field length */
+
+        assert(!seval::evaluate_field<int>("", 0, i));
+        assert(!seval::evaluate_field<int>("-", 1, i));
+        assert(!seval::evaluate_field<int>("0x", 2, i));
+        assert(!seval::evaluate_field<int>("12ab", 4, i));
+        assert(!seval::evaluate_field<int>("1.5", 3, i));
+
+        double d = 0;
+        assert(seval::evaluate_field<double>("1e3", 3, d) && floatpoint_compare(d, 1000.0));
+        assert(seval::evaluate_field<double>("-.5", 3, d) && floatpoint_compare(d, -0.5));
+        assert(!seval::evaluate_field<double>(".", 1, d));
+        assert(!seval::evaluate_field<double>("1e", 2, d));
+        assert(!seval::evaluate_field<double>("1e+", 3, d));
+    }
+    /* Range of the type */
+    {
+        uint8_t u8 = 7;
+        assert(!seval::evaluate_field<uint8_t>("300", 3, u8) && u8 == 7);
+        assert(seval::evaluate_field<uint8_t>("255", 3, u8) && u8 == 255);
+        assert(!seval::evaluate_field<uint8_t>("0x100", 5, u8) && u8 == 255);
+
+        int i = 7;
+        assert(!seval::evaluate_field<int>("99999999999", 11, i) && i == 7);
+        assert(!seval::evaluate_field<int>("2147483648", 10, i));
+        assert(seval::evaluate_field<int>("-2147483648", 11, i) && i == -2147483647 - 1);
+        assert(!seval::evaluate_field<int>("-2147483649", 11, i));
+        int8_t i8 = 0;
+        assert(seval::evaluate_field<int8_t>("-128", 4, i8) && i8 == -128);
+        assert(!seval::evaluate_field<int8_t>("128", 3, i8));
+
+        unsigned u = 7;
+        assert(!seval::evaluate_field<unsigned>("-5", 2, u) && u == 7);
+        assert(!seval::evaluate_field<unsigned>("-0x1", 4, u));
+        assert(seval::evaluate_field<unsigned>("-0", 2, u) && u == 0);
+        assert(seval::evaluate_field<unsigned>("4294967295", 10, u) && u == 4294967295u);
+
+        uint64_t u64 = 0;
+        assert(seval::evaluate_field<uint64_t>("18446744073709551615", 20, u64) && u64 == UINT64_MAX);
+        assert(!seval::evaluate_field<uint64_t>("18446744073709551616", 20, u64));
+        assert(!seval::evaluate_field<uint64_t>("0x10000000000000000", 19, u64));
+        assert(seval::evaluate_field<uint64_t>("0b1111111111111111111111111111111111111111111111111111111111111111", 66, u64) && u64 == UINT64_MAX);
+        assert(!seval::evaluate_field<uint64_t>("99999999999999999999999", 23, u64));
+        int64_t i64 = 0;
+        assert(seval::evaluate_field<int64_t>("-9223372036854775808", 20, i64) && i64 == INT64_MIN);
+        assert(!seval::evaluate_field<int64_t>("9223372036854775808", 19, i64));
+        assert(seval::evaluate_field<int64_t>("0000000000000000000000042", 25, i64) && i64 == 42); /* leading zeros never overflow */
+    }
+    /* Prefixes are read for integers only, in every language standard */
+    {
+        double d = 7;
+        assert(!seval::evaluate_field<double>("0x1A", 4, d) && floatpoint_compare(d, 7.0));
+        assert(!seval::evaluate_field<double>("0b1", 3, d));
+        float f = 7;
+        assert(!seval::evaluate_field<float>("-0x10", 5, f) && floatpoint_compare(f, 7.0f));
+        assert(seval::evaluate_field<double>("0", 1, d) && floatpoint_compare(d, 0.0));
+        int i = 0;
+        assert(seval::evaluate_field<int>("0x1A", 4, i) && i == 26);
+    }
+}
+
+void seval_test_batch() {
+    /* Column */
+    {
+        std::string column = "1\n-2\r\nabc\n\n0x10\n";
+        std::vector<int> values;
+        std::vector<size_t> errors;
+        assert(seval::batch::parse_column<int>(column.data(), column.size(), '\n', values, &errors) == 2);
+        assert(values.size() == 5);
+        assert(values[0] == 1 && values[1] == -2 && values[4] == 16);
+        assert(errors.size() == 2 && errors[0] == 2 && errors[1] == 3);
+    }
+    /* Dictionary cache */
+    {
+        std::string column;
+        for (int i = 0; i < 3000; ++i) {
+            column += (i % 3 == 0) ? "200," : (i % 3 == 1) ? "404," : "NA,";
+        }
+        std::vector<int> values;
+        std::vector<size_t> errors;
+        std::vector<uint32_t> codes;
+        seval::batch::dictionary_result<int> result = seval::batch::parse_column_dictionary<int>(column.data(), column.size(), ',', values, &errors, &codes);
+        assert(values.size() == 3000 && codes.size() == 3000);
+        assert(result.errors == 1000 && errors.size() == 1000 && errors[0] == 2);
+        assert(result.encoded && result.dictionary.size() == 2);
+        assert(result.hits == 3000 - 3);
+        assert(values[3] == 200 && values[4] == 404);
+        assert(result.dictionary[codes[3]] == 200 && result.dictionary[codes[4]] == 404);
+        assert(codes[2] == seval::batch::dictionary_cache<int>::no_code);
+    }
+    /* Dictionary cache disables itself on high-cardinality columns */
+    {
+        std::string column;
+        for (int i = 0; i < 5000; ++i) {
+            char field[16];
+            int n = i, len = 0;
+            do { field[len++] = static_cast<char>('0' + n % 10); n /= 10; } while (n);
+            while (len) column += field[--len];
+            column += '\n';
+        }
+        std::vector<long> values;
+        seval::batch::dictionary_result<long> result = seval::batch::parse_column_dictionary<long>(column.data(), column.size(), '\n', values);
+        assert(!result.encoded);
+        assert(result.lookups == 1024);
+        assert(values.size() == 5000 && values[4321] == 4321);
+    }
+}
+
+void seval_test_zones() {
+    std::string column;
+    for (int i = 0; i < 10; ++i) {
+        static const char* fields[10] = { "5", "3", "x", "9", "1", "2", "3", "", "4", "7" };
+        column += fields[i];
+        column += '\n';
+    }
+    std::vector<int> values;
+    std::vector<size_t> errors;
+    std::vector<seval::batch::zone<int> > zones;
+    assert(seval::batch::parse_column_zones<int>(column.data(), column.size(), '\n', values, &errors, zones, 4) == 2);
+    assert(values.size() == 10 && errors.size() == 2);
+    assert(zones.size() == 3);
+
+    assert(zones[0].firstRow == 0 && zones[0].rows == 4 && zones[0].nullCount == 1);
+    assert(zones[0].min == 3 && zones[0].max == 9);
+    assert(!zones[0].ascending && !zones[0].descending);
+
+    assert(zones[1].firstRow == 4 && zones[1].nullCount == 1);
+    assert(zones[1].min == 1 && zones[1].max == 3 && zones[1].ascending && !zones[1].descending);
+
+    assert(zones[2].rows == 2 && zones[2].min == 4 && zones[2].max == 7 && zones[2].ascending);
+    assert(!zones[2].mayContain(8, 100) && zones[2].mayContain(5, 5));
+}
+
+/* every kernel must agree with evaluate_field, bit for bit, whatever the lead */
+template <typename T>
+void seval_test_kernel_agrees(const char* field, size_t length, size_t lead) {
+    T expected = 0;
+    bool valid = seval::evaluate_field<T>(field, length, expected);
+    for (int k = 0; k < seval::kernels::KERNEL_KIND_COUNT; ++k) {
+        T got = 0;
+        assert(seval::kernels::parse_field<T>(static_cast<seval::kernels::kernel_kind>(k), field, length, lead, got) == valid);
+        assert(!valid || memcmp(&got, &expected, sizeof(T)) == 0);
+    }
+}
+
+void seval_test_kernels() {
+    /* Fields of every length up to past the kernels' limit, with and without sign, with one bad byte
+       anywhere, placed at every distance from the start of the buffer */
+    const char bad[] = { '/', ':', ' ', 'x', '.', 'e', '\0', '\xB5' };
+    uint32_t seed = 12345;
+    std::string buffer(64, '#');
+    for (size_t length = 0; length <= 24; ++length) {
+        for (int variant = 0; variant < 12; ++variant) {
+            std::string field;
+            for (size_t k = 0; k < length; ++k) {
+                seed = seed * 1103515245u + 12345u;
+                field += static_cast<char>('0' + (seed >> 16) % 10);
+            }
+            if (variant % 3 == 1 && length) field[0] = '-';
+            if (variant % 3 == 2 && length) field[0] = '+';
+            if (variant >= 6 && length) field[(seed >> 8) % length] = bad[(variant + length) % 8];
+            if (variant == 3) field = std::string(length, '9');
+
+            for (size_t lead = 0; lead <= 20; lead += 4) {
+                std::string text = buffer.substr(0, lead) + field + "###################";
+                const char* at = text.data() + lead;
+                seval_test_kernel_agrees<int64_t>(at, field.size(), lead);
+                seval_test_kernel_agrees<uint64_t>(at, field.size(), lead);
+                seval_test_kernel_agrees<int32_t>(at, field.size(), lead);
+                seval_test_kernel_agrees<uint8_t>(at, field.size(), lead);
+                seval_test_kernel_agrees<double>(at, field.size(), lead);
+                seval_test_kernel_agrees<float>(at, field.size(), lead);
+            }
+        }
+    }
+    seval_test_kernel_agrees<double>("-0", 2, 0);
+    seval_test_kernel_agrees<int>("0x1F", 4, 0);
+    seval_test_kernel_agrees<double>("1.5e3", 5, 0);
+
+    uint64_t v = 0;
+    assert(seval::kernels::parse_digits(seval::kernels::KERNEL_SIMD16, "9999999999999999999", 19, 0, v) && v == 9999999999999999999ULL);
+    assert(!seval::kernels::parse_digits(seval::kernels::KERNEL_SWAR8, "12345678901234567890", 20, 0, v));
+    assert(seval::kernels::available(seval::kernels::KERNEL_SCALAR) && std::string(seval::kernels::kernel_name(seval::kernels::KERNEL_SWAR8)) == "swar8");
+}
+
+/* under `trim`, every kernel must agree with evaluate_field on the field without its whitespace */
+template <typename T>
+void seval_test_trim_agrees(const std::string& field, unsigned trim) {
+    size_t w = 0;
+    while ((trim & seval::kernels::TRIM_WHITESPACE) && w < field.size() && strchr(" \t\n\v\f\r", field[w])) ++w;
+    T expected = 0;
+    bool valid = seval::evaluate_field<T>(field.data() + w, field.size() - w, expected);
+    for (int k = 0; k < seval::kernels::KERNEL_KIND_COUNT; ++k) {
+        T got = 0;
+        assert(seval::kernels::parse_field<T>(static_cast<seval::kernels::kernel_kind>(k), field.data(), field.size(), 0, got, trim) == valid);
+        assert(!valid || memcmp(&got, &expected, sizeof(T)) == 0);
+    }
+}
+
+void seval_test_trim() {
+    /* The runs stop at the first other byte, wherever it falls in the vector and word steps */
+    for (size_t n = 0; n <= 40; ++n) {
+        for (size_t run = 0; run <= n; ++run) {
+            std::string zeros = std::string(run, '0') + std::string(n - run, '7');
+            std::string spaces = std::string(run, run % 3 ? ' ' : '\t') + std::string(n - run, '\x89');
+            assert(seval::kernels::internal::zero_run(zeros.data(), n) == run);
+            assert(seval::kernels::internal::space_run(spaces.data(), n) == run);
+        }
+    }
+    assert(seval::kernels::internal::space_run(" \t\n\v\f\r\x08", 7) == 6);
+    assert(seval::kernels::internal::space_run("\x0e", 1) == 0);
+
+    /* Zero-padded fields of every width, and the shapes zeros must not be stripped from */
+    for (size_t width = 1; width <= 40; width += 3) {
+        for (size_t digits = 0; digits <= width && digits <= 20; digits += 2) {
+            std::string field = std::string(width - digits, '0') + std::string("98765432109876543210").substr(0, digits);
+            const unsigned zeros = seval::kernels::TRIM_ZEROS;
+            seval_test_trim_agrees<int64_t>(field, zeros);
+            seval_test_trim_agrees<uint64_t>("+" + field, zeros);
+            seval_test_trim_agrees<int32_t>("-" + field, zeros);
+            seval_test_trim_agrees<double>("-" + field, zeros);
+            seval_test_trim_agrees<float>(field, zeros);
+            seval_test_trim_agrees<int64_t>(" \t" + field, zeros | seval::kernels::TRIM_WHITESPACE);
+        }
+    }
+    const char* shapes[] = { "0", "-0", "000", "-000", "0x1f", "00x1f", "0b11", "0.5", "000.25", "-", "0-1", "", "   ", " \r\n-0012", " 1.5e3", "\t0x10" };
+    for (size_t k = 0; k < sizeof(shapes) / sizeof(shapes[0]); ++k) {
+        for (unsigned trim = 0; trim < 4; ++trim) {
+            seval_test_trim_agrees<int64_t>(shapes[k], trim);
+            seval_test_trim_agrees<double>(shapes[k], trim);
+        }
+    }
+
+    /* The histogram sees the trimmed digit runs */
+    const char* field = "  -000000000000000012345";
+    size_t length = strlen(field);
+    size_t offset = seval::kernels::trim_field(field, length, seval::kernels::TRIM_WHITESPACE | seval::kernels::TRIM_ZEROS);
+    assert(length == 22 && offset == 17 && field[0] == '-');
+    seval::batch::length_histogram h;
+    h.add("000000000000000012345", 21);
+    h.add("000000000000000012345", 21, seval::kernels::TRIM_ZEROS);
+    assert(h.other == 1 && h.digits[5] == 1);
+
+    /* A zero-padded column parses as without the option */
+    std::string column;
+    for (int row = 0; row < 3000; ++row) {
+        char text[32];
+        snprintf(text, sizeof(text), row % 5 ? "%020d" : "-%010d", row * 7919);
+        column += text;
+        column += '\n';
+    }
+    std::vector<int64_t> expected, values;
+    std::vector<size_t> expectedErrors, errors;
+    seval::batch::parse_column<int64_t>(column.data(), column.size(), '\n', expected, &expectedErrors);
+    seval::batch::adaptive_options options;
+    options.trim = seval::kernels::TRIM_ZEROS;
+    seval::batch::adaptive_result r = seval::batch::parse_column_adaptive<int64_t>(column.data(), column.size(), '\n', values, &errors, options);
+    assert(values == expected && errors == expectedErrors && r.errors == 0 && r.kernel != seval::kernels::KERNEL_SCALAR);
+
+    /* Leading whitespace is accepted only when asked for */
+    values.clear();
+    assert(seval::batch::parse_column_adaptive<int64_t>(" 1,\t-2,3", 8, ',', values).errors == 2);
+    options.trim = seval::kernels::TRIM_WHITESPACE;
+    values.clear();
+    assert(seval::batch::parse_column_adaptive<int64_t>(" 1,\t-2,3", 8, ',', values, NULL, options).errors == 0);
+    assert(values.size() == 3 && values[0] == 1 && values[1] == -2 && values[2] == 3);
+}
+
+void seval_test_adaptive() {
+    /* The histogram drives the choice: short fixed-length fields go digit by digit, long or
+       mixed-length ones word by word */
+    seval::batch::length_histogram h;
+    h.add("1.5", 3);
+    h.add("0x10", 4);
+    h.add("", 0);
+    assert(h.total == 3 && h.other == 3 && seval::batch::choose_kernel(h) == seval::kernels::KERNEL_SCALAR);
+    h.clear();
+    for (int k = 0; k < 100; ++k) h.add("-42", 3);
+    assert(h.digits[2] == 100 && seval::batch::choose_kernel(h) == seval::kernels::KERNEL_SCALAR);
+    h.clear();
+    for (int k = 0; k < 100; ++k) h.add(k % 2 ? "1" : "1234567890123456789", k % 2 ? 1 : 19);
+    seval::kernels::kernel_kind wide = seval::batch::choose_kernel(h);
+    assert(wide == (seval::kernels::available(seval::kernels::KERNEL_SIMD16) ? seval::kernels::KERNEL_SIMD16 : seval::kernels::KERNEL_SWAR8));
+
+    /* A column that changes shape halfway: short codes, then long ids mixed with decimals and errors */
+    std::string column;
+    for (int row = 0; row < 2000; ++row) {
+        char field[32];
+        if (row < 1000) snprintf(field, sizeof(field), "%d", row % 10);
+        else if (row % 7 == 0) snprintf(field, sizeof(field), "%d.25", row);
+        else if (row % 11 == 0) snprintf(field, sizeof(field), "x%d", row);
+        else snprintf(field, sizeof(field), "%lld", static_cast<long long>(row) * 1000000000000003LL);
+        column += field;
+        column += '\n';
+    }
+
+    std::vector<double> expected, values;
+    std::vector<size_t> expectedErrors, errors;
+    size_t errorCount = seval::batch::parse_column<double>(column.data(), column.size(), '\n', expected, &expectedErrors);
+
+    seval::batch::adaptive_options options;
+    options.sampleSize = 64;
+    options.resampleInterval = 500;
+    seval::batch::adaptive_result r = seval::batch::parse_column_adaptive<double>(column.data(), column.size(), '\n', values, &errors, options);
+    assert(r.rows == 2000 && r.errors == errorCount && r.samples == 4 && errors == expectedErrors);
+    assert(values.size() == expected.size() && memcmp(&values[0], &expected[0], values.size() * sizeof(double)) == 0);
+    assert(r.fields[seval::kernels::KERNEL_SCALAR] >= 900 && r.kernel == wide);
+
+    /* Sampling only once keeps the first choice */
+    options.resampleInterval = 0;
+    values.clear();
+    r = seval::batch::parse_column_adaptive<double>(column.data(), column.size(), '\n', values, NULL, options);
+    assert(r.samples == 1 && r.kernel == seval::kernels::KERNEL_SCALAR && r.fields[r.kernel] == 2000 - 63);
+    assert(memcmp(&values[0], &expected[0], values.size() * sizeof(double)) == 0);
+}
+
+/* a batch parser with the signature of parse_column */
+template <typename T>
+struct seval_test_parser {
+    typedef size_t (*type)(const char*, size_t, char, std::vector<T>&, std::vector<size_t>*);
+};
+
+/* the parser must append exactly what parse_column produces */
+template <typename T>
+void seval_test_column_agrees(typename seval_test_parser<T>::type parse, const std::string& column, char delimiter) {
+    std::vector<T> expected, values(1, T(7));
+    std::vector<size_t> expectedErrors, errors;
+    size_t errorCount = seval::batch::parse_column<T>(column.data(), column.size(), delimiter, expected, &expectedErrors);
+    assert(parse(column.data(), column.size(), delimiter, values, &errors) == errorCount);
+    assert(errors == expectedErrors && values.size() == expected.size() + 1 && values[0] == T(7));
+    assert(expected.empty() || memcmp(&values[1], &expected[0], expected.size() * sizeof(T)) == 0);
+}
+
+/* 1-digit and 19-digit ids in random order, with signs, CRLF, decimals, errors and empty fields */
+std::string seval_test_mixed_column() {
+    std::string column;
+    uint32_t seed = 777;
+    for (int row = 0; row < 3000; ++row) {
+        seed = seed * 1103515245u + 12345u;
+        char field[40];
+        switch ((seed >> 16) % 12) {
+        case 0: snprintf(field, sizeof(field), "-%u", (seed >> 8) % 10); break;
+        case 1: snprintf(field, sizeof(field), "+%u\r", (seed >> 8) % 10); break;
+        case 2: snprintf(field, sizeof(field), "%u.5", seed % 1000); break;
+        case 3: snprintf(field, sizeof(field), "1%u9x", seed % 100); break;
+        case 4: snprintf(field, sizeof(field), "%s", row % 2 ? "" : "-"); break;
+        case 5: snprintf(field, sizeof(field), "%u%u%u", seed, seed, seed); break;
+        case 6: snprintf(field, sizeof(field), "0x%X", seed % 4096); break;
+        default:
+            if (seed & 0x100) snprintf(field, sizeof(field), "%u", (seed >> 4) % 10);
+            else snprintf(field, sizeof(field), "%u%010u", 100000000u + seed % 800000000u, seed);
+            break;
+        }
+        column += field;
+        column += '\n';
+    }
+    return column;
+}
+
+template <typename T>
+void seval_test_parser_agrees(typename seval_test_parser<T>::type parse) {
+    static const std::string column = seval_test_mixed_column();
+    seval_test_column_agrees<T>(parse, column, '\n');
+
+    /* Edge shapes of the buffer itself */
+    seval_test_column_agrees<T>(parse, "", ',');
+    seval_test_column_agrees<T>(parse, ",", ',');
+    seval_test_column_agrees<T>(parse, "5,,-", ',');
+    seval_test_column_agrees<T>(parse, "12,34\r", ',');
+}
+
+void seval_test_bucketed() {
+    seval_test_parser_agrees<int64_t>(&seval::batch::parse_column_bucketed<int64_t>);
+    seval_test_parser_agrees<uint64_t>(&seval::batch::parse_column_bucketed<uint64_t>);
+    seval_test_parser_agrees<int32_t>(&seval::batch::parse_column_bucketed<int32_t>);
+    seval_test_parser_agrees<uint8_t>(&seval::batch::parse_column_bucketed<uint8_t>);
+    seval_test_parser_agrees<double>(&seval::batch::parse_column_bucketed<double>);
+    seval_test_parser_agrees<float>(&seval::batch::parse_column_bucketed<float>);
+}
+
+void seval_test_interleaved() {
+    /* Every run of a group is converted as if alone, whatever its neighbours */
+    const char* runs[5] = { "7", "1234567890123456789", "12x4", "", "00000000000000000001" };
+    const size_t lengths[5] = { 1, 19, 4, 0, 20 };
+    for (size_t a = 0; a < 5; ++a) {
+        for (size_t b = 0; b < 5; ++b) {
+            for (size_t c = 0; c < 5; ++c) {
+                const char* p[4] = { runs[a], runs[b], runs[c], runs[(a + b + c) % 5] };
+                size_t n[4] = { lengths[a], lengths[b], lengths[c], lengths[(a + b + c) % 5] };
+                uint64_t v[4];
+                uint32_t valid = seval::kernels::parse_digits_interleaved<4>(p, n, v);
+                for (size_t i = 0; i < 4; ++i) {
+                    uint64_t alone = 0;
+                    bool ok = seval::kernels::parse_digits(seval::kernels::KERNEL_SCALAR, p[i], n[i], 0, alone);
+                    assert(((valid >> i) & 1) == (ok ? 1u : 0u) && (!ok || v[i] == alone));
+                }
+            }
+        }
+    }
+
+    /* Groups of 2, 3 (a partial last group) and 8 */
+    seval_test_parser_agrees<int64_t>(&seval::batch::parse_column_interleaved<int64_t, 4>);
+    seval_test_parser_agrees<uint64_t>(&seval::batch::parse_column_interleaved<uint64_t, 2>);
+    seval_test_parser_agrees<int32_t>(&seval::batch::parse_column_interleaved<int32_t, 3>);
+    seval_test_parser_agrees<uint8_t>(&seval::batch::parse_column_interleaved<uint8_t, 8>);
+    seval_test_parser_agrees<double>(&seval::batch::parse_column_interleaved<double, 4>);
+    seval_test_parser_agrees<float>(&seval::batch::parse_column_interleaved<float, 8>);
+
+    std::vector<int> values;
+    assert(seval::batch::parse_column_interleaved<int>("1,-22,x,4444,55555", 18, ',', values) == 1);
+    assert(values.size() == 5 && values[1] == -22 && values[2] == 0 && values[4] == 55555);
+}
+
+template <typename T>
+void seval_test_gather_agrees(const std::vector<const char*>& ptrs, const std::vector<size_t>& lens) {
+    std::vector<T> out(ptrs.size() + 1, T(7));
+    std::vector<size_t> errors, expectedErrors;
+    size_t errorCount = seval::parse_gather<T>(&ptrs[0], &lens[0], ptrs.size(), &out[0], &errors);
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+        T expected = 0;
+        if (!seval::evaluate_field<T>(ptrs[i], lens[i], expected)) expectedErrors.push_back(i);
+        assert(memcmp(&out[i], &expected, sizeof(T)) == 0);
+    }
+    assert(errorCount == expectedErrors.size() && errors == expectedErrors && out.back() == T(7));
+}
+
+void seval_test_gather() {
+    /* The tokens of the mixed column, each copied to its own allocation, read in a shuffled order */
+    std::string column = seval_test_mixed_column();
+    std::vector<std::string> tokens;
+    for (size_t begin = 0, end; (end = column.find('\n', begin)) != std::string::npos; begin = end + 1) {
+        tokens.push_back(column.substr(begin, end - begin));
+    }
+    std::vector<const char*> ptrs;
+    std::vector<size_t> lens;
+    for (size_t k = 0; k < tokens.size(); ++k) {
+        const std::string& token = tokens[(k * 7919) % tokens.size()];
+        ptrs.push_back(token.data());
+        lens.push_back(token.size());
+    }
+    ptrs.push_back(NULL);
+    lens.push_back(0);
+    seval_test_gather_agrees<int64_t>(ptrs, lens);
+    seval_test_gather_agrees<uint64_t>(ptrs, lens);
+    seval_test_gather_agrees<int32_t>(ptrs, lens);
+    seval_test_gather_agrees<uint8_t>(ptrs, lens);
+    seval_test_gather_agrees<double>(ptrs, lens);
+    seval_test_gather_agrees<float>(ptrs, lens);
+
+    /* Fewer strings than the prefetch distance, and none */
+    const char* few[3] = { "12", "-3", "4x" };
+    const size_t fewLengths[3] = { 2, 2, 2 };
+    int values[3];
+    assert(seval::parse_gather<int>(few, fewLengths, 3, values) == 1 && values[0] == 12 && values[1] == -3 && values[2] == 0);
+    assert(seval::parse_gather<int>(few, fewLengths, 0, values) == 0);
+}
+
+/* parse_column_padded over a padded copy of the column */
+template <typename T>
+size_t seval_test_parse_padded(const char* data, size_t size, char delimiter, std::vector<T>& values, std::vector<size_t>* errors) {
+    seval::batch::padded_buffer buffer;
+    assert(buffer.assign(data, size) && buffer.size() == size);
+    return seval::batch::parse_column_padded<T>(buffer.data(), buffer.size(), delimiter, values, errors);
+}
+
+template <typename T>
+void seval_test_padded_fields(const char* text, size_t length) {
+    seval::batch::padded_buffer buffer;
+    assert(buffer.assign(text, length));
+    T expected = 0, padded = 0, pageSafe = 0;
+    bool ok = seval::evaluate_field<T>(text, length, expected);
+    assert(seval::kernels::parse_field_padded<T>(buffer.data(), length, padded) == ok);
+    assert(seval::kernels::parse_field_page_safe<T>(text, length, pageSafe) == ok);
+    assert(memcmp(&padded, &expected, sizeof(T)) == 0 && memcmp(&pageSafe, &expected, sizeof(T)) == 0);
+}
+
+void seval_test_padded() {
+    seval_test_parser_agrees<int64_t>(&seval_test_parse_padded<int64_t>);
+    seval_test_parser_agrees<uint64_t>(&seval_test_parse_padded<uint64_t>);
+    seval_test_parser_agrees<int32_t>(&seval_test_parse_padded<int32_t>);
+    seval_test_parser_agrees<uint8_t>(&seval_test_parse_padded<uint8_t>);
+    seval_test_parser_agrees<double>(&seval_test_parse_padded<double>);
+    seval_test_parser_agrees<float>(&seval_test_parse_padded<float>);
+    seval_test_parser_agrees<int64_t>(&seval::batch::parse_column_page_safe<int64_t>);
+    seval_test_parser_agrees<uint8_t>(&seval::batch::parse_column_page_safe<uint8_t>);
+    seval_test_parser_agrees<double>(&seval::batch::parse_column_page_safe<double>);
+
+    /* Every length around the word boundaries, with a bad byte at every position */
+    const char digits[] = "-12345678901234567890";
+    for (size_t length = 0; length <= 21; ++length) {
+        seval_test_padded_fields<int64_t>(digits + 1, length < 20 ? length : 20);
+        seval_test_padded_fields<int64_t>(digits, length);
+        seval_test_padded_fields<uint64_t>(digits + 1, length < 20 ? length : 20);
+        seval_test_padded_fields<int32_t>(digits, length);
+        for (size_t bad = 0; bad < length && bad < 20; ++bad) {
+            char field[21];
+            memcpy(field, digits + 1, 20);
+            field[bad] = bad % 2 ? '/' : ':';
+            seval_test_padded_fields<int64_t>(field, length < 20 ? length : 20);
+        }
+    }
+
+    /* The padding is zeroed and an empty buffer is still readable */
+    seval::batch::padded_buffer empty;
+    assert(empty.data() == NULL && empty.size() == 0);
+    assert(empty.allocate(0) && empty.data() != NULL);
+    for (size_t k = 0; k < seval::kernels::padding; ++k) assert(empty.data()[k] == 0);
+
+#if defined(SEVAL_FILE_MMAP)
+    /* Fields ending right before an unmapped page */
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    void* map = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    assert(map != MAP_FAILED);
+    char* base = static_cast<char*>(map);
+    assert(mprotect(base + page, page, PROT_NONE) == 0);
+    for (size_t length = 1; length <= 21; ++length) {
+        char* field = base + page - length;
+        memcpy(field, digits, length);
+        int64_t expected = 0, value = 0;
+        bool ok = seval::evaluate_field<int64_t>(field, length, expected);
+        assert(seval::kernels::parse_field_page_safe<int64_t>(field, length, value) == ok && value == expected);
+
+        std::vector<int64_t> values;
+        assert(seval::batch::parse_column_page_safe<int64_t>(field, length, ',', values) == (ok ? 0u : 1u));
+        assert(values.size() == 1 && values[0] == expected);
+    }
+    memcpy(base + page - 6, "7,-8,9", 6);
+    std::vector<int> values;
+    assert(seval::batch::parse_column_page_safe<int>(base + page - 6, 6, ',', values) == 0);
+    assert(values.size() == 3 && values[0] == 7 && values[1] == -8 && values[2] == 9);
+    munmap(map, 2 * page);
+#endif
+}
+
+void seval_test_arrow() {
+    /* Nulls for invalid and empty fields */
+    {
+        std::string column = "1,x,3,,-5";
+        struct ArrowArray array;
+        struct ArrowSchema schema;
+        assert(seval::arrow::parse_column_arrow<int32_t>(column.data(), column.size(), ',', &array, &schema, "id"));
+        assert(array.length == 5 && array.null_count == 2 && array.n_buffers == 2);
+        assert(reinterpret_cast<uintptr_t>(array.buffers[1]) % 64 == 0);
+
+        const int32_t* values = static_cast<const int32_t*>(array.buffers[1]);
+        assert(values[0] == 1 && values[2] == 3 && values[4] == -5);
+        assert(static_cast<const uint8_t*>(array.buffers[0])[0] == 0x15);
+        assert(seval::arrow::is_valid(&array, 0) && !seval::arrow::is_valid(&array, 1) && !seval::arrow::is_valid(&array, 3));
+
+        assert(std::string(schema.format) == "i" && std::string(schema.name) == "id");
+        assert(schema.flags == ARROW_FLAG_NULLABLE);
+
+        array.release(&array);
+        schema.release(&schema);
+        assert(array.release == NULL && schema.release == NULL);
+    }
+    /* No validity bitmap without nulls; buffers grow past the initial estimate */
+    {
+        std::string column;
+        for (int i = 0; i < 1000; ++i) column += "1.5\n";
+        struct ArrowArray array;
+        assert(seval::arrow::parse_column_arrow<double>(column.data(), column.size(), '\n', &array));
+        assert(array.length == 1000 && array.null_count == 0 && array.buffers[0] == NULL);
+        assert(floatpoint_compare(static_cast<const double*>(array.buffers[1])[999], 1.5));
+        assert(std::string(seval::arrow::format<double>()) == "g" && std::string(seval::arrow::format<uint16_t>()) == "S");
+        array.release(&array);
+    }
+}
+
+void seval_test_lazy() {
+    /* Delimiter index agrees with parse_column */
+    {
+        std::string column = "12,345,,6789,0x1F,-4,abc,1234567890,7,8,9,10,11,12,13,";
+        seval::batch::field_index index;
+        std::vector<long> values;
+        assert(seval::batch::index_fields(column.data(), column.size(), ',', index) == 15);
+        seval::batch::parse_column<long>(column.data(), column.size(), ',', values);
+        assert(values.size() == index.size());
+        assert(index.begin(1) == 3 && index.length(1) == 3 && index.length(2) == 0);
+        assert(index.begin(14) == column.size() - 3 && index.length(14) == 2);
+    }
+    /* Fields are evaluated on access */
+    {
+        std::string column = "1\r\n2\r\nbad\r\n0b11";
+        seval::batch::lazy_column<int> lazy(column.data(), column.size());
+        assert(lazy.size() == 4);
+        assert(lazy[3] == 3 && lazy[0] == 1 && lazy[1] == 2);
+        int value = -1;
+        assert(!lazy.get(2, value) && value == 0);
+        assert(lazy.get(3, value) && value == 3); /* memoized */
+
+        seval::batch::lazy_column<double> plain(column.data(), column.size(), '\n', false);
+        assert(floatpoint_compare(plain[1], 2.0));
+    }
+}
+
+void seval_test_file() {
+    const char* path = "seval_test_column.txt";
+    {
+        FILE* f = fopen(path, "wb");
+        assert(f);
+        fputs("10\n20\nx\n40\n", f);
+        fclose(f);
+    }
+
+    std::vector<int> values;
+    std::vector<size_t> errors;
+    assert(seval::file::parse_file<int>(path, '\n', values, &errors));
+    assert(values.size() == 4 && values[3] == 40 && errors.size() == 1 && errors[0] == 2);
+    assert(!seval::file::parse_file<int>("seval_test_missing.txt", '\n', values));
+
+    seval::file::cache_options cache(".");
+    {
+        seval::file::column<int> column;
+        assert(seval::file::load_column<int>(path, '\n', column, &cache));
+        assert(!column.fromCache() && column.size() == 4 && column[1] == 20);
+    }
+    {
+        seval::file::column<int> column;
+        assert(seval::file::load_column<int>(path, '\n', column, &cache));
+        assert(column.fromCache() && column.size() == 4 && column[0] == 10 && column[3] == 40);
+        assert(column.errorCount() == 1 && column.errors()[0] == 2);
+    }
+    {
+        /* a different element type does not reuse the cache file */
+        seval::file::column<double> column;
+        assert(seval::file::load_column<double>(path, '\n', column, &cache));
+        assert(!column.fromCache() && floatpoint_compare(column[1], 20.0));
+    }
+    {
+        /* same size and (likely) same mtime second, different content */
+        FILE* f = fopen(path, "wb");
+        fputs("11\n20\nx\n40\n", f);
+        fclose(f);
+        seval::file::column<int> column;
+        assert(seval::file::load_column<int>(path, '\n', column, &cache));
+        assert(!column.fromCache() && column[0] == 11);
+    }
+
+
+    seval::file::mapped_file source;
+    assert(source.open(path));
+    uint64_t sourceId = seval::file::internal::source_id(source, path);
+    std::string cachePath = seval::file::internal::cache_path(cache, seval::file::internal::cache_key(sourceId, seval::file::internal::type_tag<int>(), '\n'));
+    {
+        /* a header whose sections overflow or are misaligned is not trusted */
+        seval::file::column<int> column;
+        assert(seval::file::load_column<int>(path, '\n', column, &cache) && column.fromCache());
+        seval::file::internal::cache_header header;
+        const uint64_t corrupt[][2] = { { 0x4000000000000000ULL, 0 }, { 4, 1 } };
+        for (size_t i = 0; i < sizeof(corrupt) / sizeof(corrupt[0]); ++i) {
+            FILE* f = fopen(cachePath.c_str(), "r+b");
+            assert(f && fread(&header, sizeof(header), 1, f) == 1);
+            header.rows = corrupt[i][0];
+            header.valuesOffset += corrupt[i][1];
+            fseek(f, 0, SEEK_SET);
+            assert(fwrite(&header, sizeof(header), 1, f) == 1);
+            fclose(f);
+            assert(seval::file::load_column<int>(path, '\n', column, &cache));
+            assert(!column.fromCache() && column.size() == 4 && column[0] == 11 && column[3] == 40);
+            assert(seval::file::load_column<int>(path, '\n', column, &cache) && column.fromCache());
+        }
+    }
+#if defined(SEVAL_FILE_MMAP)
+    {
+        /* a rewrite within the same second, of the same size, is noticed without hashing the content */
+        seval::file::cache_options quick(".");
+        quick.verifyContent = false;
+        seval::file::column<int> column;
+        assert(seval::file::load_column<int>(path, '\n', column, &quick));
+        usleep(20000);
+        FILE* f = fopen(path, "wb");
+        fputs("12\n20\nx\n40\n", f);
+        fclose(f);
+        seval::file::mapped_file rewritten;
+        assert(rewritten.open(path));
+        if (rewritten.mtime() == source.mtime() && rewritten.mtime_nsec() != source.mtime_nsec()) {
+            assert(seval::file::load_column<int>(path, '\n', column, &quick));
+            assert(!column.fromCache() && column[0] == 12);
+        }
+    }
+#endif
+
+    remove(cachePath.c_str());
+    cachePath = seval::file::internal::cache_path(cache, seval::file::internal::cache_key(sourceId, seval::file::internal::type_tag<double>(), '\n'));
+    remove(cachePath.c_str());
+    source.close();
+    remove(path);
+}
+
+void seval_test_expr() {
+    seval::expr::bindings vars;
+    vars["x"] = 2.0;
+    vars["rate"] = 0.25;
+    seval::expr::value v;
+    seval::expr::error err;
+
+    /* Typed arithmetic */
+    {
+        assert(seval::expr::evaluate("(0x10 + 3.5e2) * -0b11 / x", vars, v) && v.kind == seval::expr::KIND_FLOAT);
+        assert(floatpoint_compare(v.f, -549.0));
+        assert(seval::expr::evaluate("7 / 2 + 7 % 3 - -1", vars, v) && v.kind == seval::expr::KIND_INT && v.i == 5);
+        assert(seval::expr::evaluate("1 + 2 * 3 - 4", vars, v) && v.i == 3);
+        assert(seval::expr::evaluate("0x7FFFFFFFFFFFFFFF + 1", vars, v) && v.i == -9223372036854775807LL - 1); /* wraps */
+        assert(seval::expr::evaluate("pow(2, 10) + max(3, -4) * abs(-2)", vars, v) && v.kind == seval::expr::KIND_INT && v.i == 1030);
+        assert(seval::expr::evaluate("sqrt(16) * rate + min(x, .5)", vars, v) && floatpoint_compare(v.f, 1.5));
+        assert(seval::expr::evaluate("1e3 / 8", vars, v) && floatpoint_compare(v.f, 125.0));
+    }
+    /* Errors */
+    {
+        assert(!seval::expr::evaluate("1 / (x - x) + 1 / 0", vars, v, &err) && err.position == 16);
+        assert(!seval::expr::evaluate("y * 2", vars, v, &err) && err.position == 0);
+        assert(!seval::expr::evaluate("(1 + 2", vars, v, &err) && err.position == 6);
+        assert(!seval::expr::evaluate("1 + ", vars, v, &err) && err.position == 4);
+        assert(!seval::expr::evaluate("0b12", vars, v, &err) && err.position == 3);
+        assert(!seval::expr::evaluate("2e + 1", vars, v, &err) && err.position == 1);
+        assert(!seval::expr::evaluate("foo(1)", vars, v, &err) && err.position == 0);
+        assert(!seval::expr::evaluate("pow(1)", vars, v, &err));
+        assert(!seval::expr::evaluate("abs(1, 2)", vars, v, &err));
+        assert(!seval::expr::evaluate(std::string(1000, '(').c_str(), vars, v, &err));
+    }
+    /* Integer literals must fit in 64 bits; 2^63 only after a unary minus */
+    {
+        static const char* ranges[] = { "99999999999999999999", "x + 18446744073709551617", "0x1FFFFFFFFFFFFFFFF",
+                                        "9223372036854775808", "2 * 0b1000000000000000000000000000000000000000000000000000000000000000" };
+        static const size_t positions[] = { 0, 4, 0, 0, 4 };
+        for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+            assert(!seval::expr::evaluate(ranges[i], vars, v, &err, seval::expr::OVERFLOW_TRAP));
+            assert(err.position == positions[i] && strcmp(err.message, "integer literal out of range") == 0);
+        }
+        assert(seval::expr::evaluate("-9223372036854775808", vars, v, &err, seval::expr::OVERFLOW_TRAP) && v.i == -9223372036854775807LL - 1);
+        assert(!seval::expr::evaluate("1 - 0x8000000000000000", vars, v, &err) && err.position == 4); /* a binary minus */
+        assert(!seval::expr::evaluate("-(9223372036854775808)", vars, v, &err) && err.position == 2);
+        assert(seval::expr::evaluate("99999999999999999999.5", vars, v) && v.kind == seval::expr::KIND_FLOAT && v.f > 9.9e19); /* reals may be large */
+    }
+    /* A parsed expression can be evaluated many times */
+    {
+        seval::expr::expression e;
+        assert(seval::expr::parse("x * x + rate", e));
+        assert(e.variables.size() == 2 && e.variables[0] == "x");
+        vars["x"] = 3.0;
+        assert(seval::expr::evaluate(e, vars, v) && floatpoint_compare(v.f, 9.25));
+    }
+}
+
+void seval_test_optimize() {
+    seval::expr::expression e, o;
+
+    /* Folding */
+    assert(seval::expr::parse("(0x10 + 3.5e2) * -0b11 + pow(2, 3)", e));
+    seval::expr::optimize(e, o);
+    assert(o.nodes.size() == 1 && o.nodes[0].op == seval::expr::OP_CONST);
+    assert(floatpoint_compare(o.nodes[0].constant.f, -1090.0));
+
+    /* Common sub-expressions, including commuted ones */
+    assert(seval::expr::parse("(x * y + 1) * (y * x + 1)", e));
+    seval::expr::optimize(e, o);
+    assert(o.nodes.size() == 6 && o.nodes[o.root].a == o.nodes[o.root].b);
+
+    /* Identities and strength reduction */
+    assert(seval::expr::parse("((x + -0.0) * 1 - 0) / 1 + -(-y)", e));
+    seval::expr::optimize(e, e);
+    assert(e.nodes.size() == 3 && e.nodes[e.root].op == seval::expr::OP_ADD);
+    assert(seval::expr::parse("x + 0", e)); /* -0 + 0 is +0 */
+    seval::expr::optimize(e, o);
+    assert(o.nodes.size() == 3 && o.nodes[o.root].op == seval::expr::OP_ADD);
+    assert(seval::expr::parse("pow(x, 2)", e));
+    seval::expr::optimize(e, o);
+    assert(o.nodes[o.root].op == seval::expr::OP_MUL && o.nodes[o.root].a == o.nodes[o.root].b);
+    assert(seval::expr::parse("x / -4", e));
+    seval::expr::optimize(e, o);
+    assert(o.nodes[o.root].op == seval::expr::OP_MUL && o.nodes[o.nodes[o.root].b].constant.f == -0.25);
+    assert(seval::expr::parse("x / 3", e));
+    seval::expr::optimize(e, o);
+    assert(o.nodes[o.root].op == seval::expr::OP_DIV);
+
+    /* Results are unchanged */
+    {
+        static const char* sources[] = {
+            "x * y + (x - y) * (x + y) / (x * x + 1) - abs(y)",
+            "pow(x, 2) + pow(y, 1) * pow(x, 0) - x / 8 + abs(-y)",
+            "min(x, x) + max(y * 1, y) + (2 * 3 - 6) * x",
+            "sqrt(abs(abs(y))) / 0.5 - 1 / (2 - 0.5)",
+        };
+        seval::expr::bindings vars;
+        vars["x"] = 3.0;
+        vars["y"] = -0.75;
+        for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+            seval::expr::value expected, actual;
+            assert(seval::expr::parse(sources[i], e));
+            seval::expr::optimize(e, o);
+            assert(o.nodes.size() < e.nodes.size());
+            assert(seval::expr::evaluate(e, vars, expected) && seval::expr::evaluate(o, vars, actual));
+            assert(expected.kind == actual.kind && floatpoint_compare(expected.f, actual.f));
+        }
+
+        /* the sign of a zero survives: y + 0 is +0 for y = -0, y + -0.0 and y - 0 stay -0 */
+        static const char* zeros[] = { "1 / (y + 0)", "1 / (0 + y)", "1 / (y + -0.0)", "1 / (y - 0)", "1 / (y - -0.0)" };
+        static const double infinities[] = { 1, 1, -1, -1, 1 };
+        vars["y"] = -0.0;
+        for (size_t i = 0; i < sizeof(zeros) / sizeof(zeros[0]); ++i) {
+            seval::expr::value expected, actual, compiled;
+            seval::expr::program p;
+            assert(seval::expr::parse(zeros[i], e));
+            seval::expr::optimize(e, o);
+            assert(seval::expr::compile(e, p));
+            assert(seval::expr::evaluate(e, vars, expected) && seval::expr::evaluate(o, vars, actual) && seval::expr::run(p, vars, compiled));
+            assert(expected.f == infinities[i] / 0.0 && actual.f == expected.f && compiled.f == expected.f);
+        }
+    }
+
+    /* pow(x, 0) keeps an operand that fails */
+    {
+        seval::expr::bindings vars;
+        vars["x"] = 2.0;
+        seval::expr::value v;
+        seval::expr::error err;
+        seval::expr::program p;
+        assert(seval::expr::parse("x + pow(1 / 0, 0)", e));
+        assert(!seval::expr::evaluate(e, vars, v));
+        assert(seval::expr::compile(e, p) && !seval::expr::run(p, vars, v, &err) && err.position == 10);
+        assert(seval::expr::parse("x + pow(9223372036854775807 * 2, 0)", e));
+        assert(seval::expr::compile(e, p, NULL, seval::expr::OVERFLOW_TRAP) && !seval::expr::run(p, vars, v));
+        assert(seval::expr::compile(e, p) && seval::expr::run(p, vars, v) && floatpoint_compare(v.f, 3.0));
+        assert(seval::expr::parse("pow(x * 3, 0) + pow(0.5 / 0, 0)", e));
+        seval::expr::optimize(e, o);
+        assert(o.nodes.size() == 1 && o.nodes[0].op == seval::expr::OP_CONST);
+    }
+
+    /* Integer division by zero is not folded away */
+    {
+        seval::expr::bindings vars;
+        vars["x"] = 1.0;
+        seval::expr::value v;
+        seval::expr::error err;
+        assert(seval::expr::parse("x + 1 / (2 - 2)", e));
+        seval::expr::optimize(e, o);
+        assert(!seval::expr::evaluate(o, vars, v, &err) && err.position == 6);
+    }
+}
+
+void seval_test_vm() {
+    seval::expr::bindings vars;
+    vars["x"] = 2.0;
+    vars["y"] = -3.5;
+
+    /* Bytecode agrees with the AST evaluator */
+    {
+        static const char* sources[] = {
+            "(0x10 + 3.5e2) * -0b11 / x",
+            "7 / 2 + 7 % 3 - -1",
+            "pow(2, 10) + max(3, -4) * abs(-2) + pow(2, -1)",
+            "sqrt(16) * x + min(y, .5) - 7 % 4",
+            "x * y + (x - y) * (x + y) / (x * x + 1) - abs(y)",
+            "max(x, 3) + min(2, 1) * 0x10 + pow(x, 3) % 5",
+            "-(-(x)) + 1",
+            "42",
+            "y",
+        };
+        for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+            seval::expr::expression e;
+            seval::expr::program p;
+            seval::expr::value expected, actual;
+            assert(seval::expr::parse(sources[i], e));
+            assert(seval::expr::compile(e, p));
+            assert(seval::expr::evaluate(e, vars, expected));
+            assert(seval::expr::run(p, vars, actual));
+            assert(expected.kind == actual.kind);
+            assert(expected.kind == seval::expr::KIND_INT ? expected.i == actual.i : floatpoint_compare(expected.f, actual.f));
+        }
+    }
+    /* Constants are parsed once, registers are reused */
+    {
+        seval::expr::program p;
+        assert(seval::expr::compile("x * 2 + x * 2 + x * 2 + x * 2", p));
+        assert(p.constants.size() == 1 && p.variables.size() == 1);
+        assert(p.registers <= 5);
+        assert(p.code.back().op == seval::expr::VM_RET);
+    }
+    /* Errors */
+    {
+        seval::expr::program p;
+        seval::expr::value v;
+        seval::expr::error err;
+        assert(seval::expr::compile("10 / (3 - 3)", p));
+        assert(!seval::expr::run(p, vars, v, &err) && err.position == 3);
+        assert(seval::expr::compile("z + 1", p));
+        assert(!seval::expr::run(p, vars, v, &err));
+        assert(!seval::expr::compile("1 +", p, &err));
+    }
+    /* Declared integer variables use integer instructions and take integral values only */
+    {
+        seval::expr::expression e;
+        seval::expr::program p;
+        seval::expr::value expected, actual;
+        seval::expr::error err;
+        assert(seval::expr::parse("n / 2 + n % 3 * x", e));
+        assert(e.declare("n", seval::expr::KIND_INT) && !e.declare("m", seval::expr::KIND_INT));
+        assert(seval::expr::compile(e, p) && p.variable_kind(0) == seval::expr::KIND_INT);
+        bool integerDivision = false;
+        for (size_t k = 0; k < p.code.size(); ++k) integerDivision |= p.code[k].op == seval::expr::VM_DIV_I;
+        assert(integerDivision);
+
+        seval::expr::bindings ints(vars);
+        ints["n"] = 7.0;
+        assert(seval::expr::evaluate(e, ints, expected) && floatpoint_compare(expected.f, 5.0));
+        assert(seval::expr::run(p, ints, actual) && floatpoint_compare(actual.f, 5.0));
+        double row[2] = { 7.0, 2.0 };
+        assert(seval::expr::run(p, row, actual) && floatpoint_compare(actual.f, 5.0));
+
+        ints["n"] = 7.5;
+        row[0] = 7.5;
+        assert(!seval::expr::evaluate(e, ints, expected, &err) && err.position == 0);
+        assert(std::string(err.message) == "integer variable bound to a non-integer value");
+        assert(!seval::expr::run(p, ints, actual, &err) && !seval::expr::run(p, row, actual, &err));
+        ints["n"] = 9223372036854775808.0;
+        assert(!seval::expr::run(p, ints, actual));
+
+        seval::expr::tiered_program hot(p, 0); /* integer variables stay on the VM */
+        assert(!hot.run(row, actual) && !hot.native());
+    }
+}
+
+void seval_test_columns() {
+    const size_t rows = 2500; /* two full batches and a tail */
+    std::vector<double> price(rows);
+    std::vector<int64_t> quantity(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        price[i] = 0.25 * static_cast<double>(i);
+        quantity[i] = static_cast<int64_t>(i % 7) - 3;
+    }
+
+    /* Columns agree with row-by-row evaluation */
+    {
+        seval::expr::program p;
+        assert(seval::expr::compile("price * qty + max(price, 100) / 0x4 - abs(qty)", p));
+        seval::expr::column_bindings columns;
+        columns["price"] = seval::expr::column_ref(&price[0]);
+        columns["qty"] = seval::expr::column_ref(&quantity[0]);
+
+        std::vector<double> out(rows);
+        assert(seval::expr::run_columns(p, columns, rows, &out[0]));
+        for (size_t i = 0; i < rows; i += 97) {
+            seval::expr::bindings vars;
+            vars["price"] = price[i];
+            vars["qty"] = static_cast<double>(quantity[i]);
+            seval::expr::value v;
+            assert(seval::expr::run(p, vars, v) && floatpoint_compare(v.f, out[i]));
+        }
+        double last = price[rows - 1]; /* qty is -3 in the last row */
+        assert(floatpoint_compare(out[rows - 1], last * -3 + last / 4 - 3));
+    }
+    /* Integer results and constant programs */
+    {
+        seval::expr::program p;
+        int64_t out[3] = { 0, 0, 0 };
+        double real[3] = { 0, 0, 0 };
+        assert(seval::expr::compile("6 * 7", p));
+        assert(seval::expr::run_columns(p, static_cast<const seval::expr::column_ref*>(NULL), 3, out));
+        assert(out[0] == 42 && out[2] == 42);
+
+        seval::expr::error err;
+        assert(seval::expr::compile("price / 2", p));
+        seval::expr::column_ref column(&price[0]);
+        assert(!seval::expr::run_columns(p, &column, 3, out, &err));
+        assert(seval::expr::run_columns(p, &column, 3, real) && floatpoint_compare(real[2], 0.25));
+    }
+    /* int64 columns beyond 2^53 stay exact in integer registers, and are refused as doubles */
+    {
+        std::vector<int64_t> big(rows);
+        for (size_t i = 0; i < rows; ++i) big[i] = 9007199254740993LL + static_cast<int64_t>(i);
+        seval::expr::column_bindings columns;
+        columns["q"] = seval::expr::column_ref(&big[0]);
+        columns["price"] = seval::expr::column_ref(&price[0]);
+
+        seval::expr::program p;
+        std::vector<int64_t> out(rows);
+        assert(seval::expr::compile("q + 1", columns, p) && p.resultKind == seval::expr::KIND_INT);
+        assert(seval::expr::run_columns(p, columns, rows, &out[0]));
+        assert(out[0] == 9007199254740994LL && out[rows - 1] == 9007199254740994LL + static_cast<int64_t>(rows - 1));
+
+        seval::expr::error err;
+        std::vector<double> real(rows);
+        assert(seval::expr::compile("q + price", p));
+        assert(!seval::expr::run_columns(p, columns, rows, &real[0], &err));
+        assert(std::string(err.message) == "integer column value beyond 2^53 bound to a double variable");
+
+        /* double columns of integer variables must hold integers */
+        seval::expr::expression e;
+        assert(seval::expr::parse("price * 4 + 1", e) && e.declare("price", seval::expr::KIND_INT));
+        assert(seval::expr::compile(e, p) && p.resultKind == seval::expr::KIND_INT);
+        std::vector<double> whole(rows);
+        for (size_t i = 0; i < rows; ++i) whole[i] = static_cast<double>(i);
+        assert(!seval::expr::run_columns(p, &columns["price"], rows, &out[0], &err));
+        seval::expr::column_ref integral(&whole[0]);
+        assert(seval::expr::run_columns(p, &integral, rows, &out[0]) && out[rows - 1] == 4 * static_cast<int64_t>(rows - 1) + 1);
+    }
+}
+
+void seval_test_jit() {
+    const char* formulas[] = {
+        "x * 1.5 + y / 4 - 0x10",
+        "-abs(x - y) + sqrt(y * y)",
+        "min(x, y) * max(x, 2.5) - -x",
+        "pow(x, 2) + x % 3",
+        "x",
+    };
+    const double xs[] = { 0.0, 1.25, -7.5, 1e300, 3.0 };
+    const double ys[] = { 2.0, 0.5, 9.0, -1e-300, 3.0 };
+
+    /* Native results match the VM bit for bit */
+    for (size_t f = 0; f < sizeof(formulas) / sizeof(formulas[0]); ++f) {
+        seval::expr::program p;
+        assert(seval::expr::compile(formulas[f], p));
+        seval::expr::tiered_program hot(p, 0);
+
+        for (size_t i = 0; i < sizeof(xs) / sizeof(xs[0]); ++i) {
+            seval::expr::bindings vars;
+            vars["x"] = xs[i];
+            vars["y"] = ys[i];
+            seval::expr::value expected, actual;
+            assert(seval::expr::run(p, vars, expected));
+            assert(hot.run(vars, actual) && actual.kind == expected.kind);
+            assert(memcmp(&actual.f, &expected.f, sizeof(double)) == 0);
+        }
+        assert(hot.native() == seval::expr::jit_available());
+    }
+
+    /* Tier-up happens after the threshold and columns use the packed code */
+    {
+        seval::expr::program p;
+        assert(seval::expr::compile("min(price, 100) * qty - abs(qty) / 2", p));
+        seval::expr::tiered_program hot(p, 8);
+
+        const size_t rows = 101;
+        std::vector<double> price(rows), qty(rows), vm(rows), native(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            price[i] = 1.5 * static_cast<double>(i);
+            qty[i] = static_cast<double>(i % 5) - 2;
+        }
+        seval::expr::column_ref columns[2] = { seval::expr::column_ref(&price[0]), seval::expr::column_ref(&qty[0]) };
+        assert(p.variables[0] == "price");
+
+        assert(hot.run_columns(columns, 8, &vm[0]) && !hot.native());
+        assert(seval::expr::run_columns(p, columns, rows, &vm[0]));
+        assert(hot.run_columns(columns, rows, &native[0]));
+        assert(hot.native() == seval::expr::jit_available() && hot.rows() == 8 + rows);
+        assert(memcmp(&vm[0], &native[0], rows * sizeof(double)) == 0);
+    }
+
+    /* Integer literals are folded; integer division by zero stays on the VM */
+    {
+        seval::expr::program p;
+        double x = 1.0;
+        seval::expr::value v;
+        assert(seval::expr::compile("x / (1 - 1) + -(2 * 3)", p));
+        seval::expr::tiered_program folded(p, 0);
+        assert(folded.run(&x, v) && v.f > 1e308);
+        assert(folded.native() == seval::expr::jit_available());
+
+        seval::expr::error err;
+        assert(seval::expr::compile("x + 7 / (1 - 1)", p));
+        seval::expr::tiered_program checked(p, 0);
+        assert(!checked.run(&x, v, &err) && !checked.native() && err.position == 6);
+    }
+}
+
+#if __cplusplus >= 201103L
+void seval_test_cache_worker(seval::expr::expression_cache* cache, int seed) {
+    static const char* formulas[] = { "x + 1", "x * 2", "x - 3", "x / 4", "pow(x, 2)", "abs(x)" };
+    for (int i = 0; i < 2000; ++i) {
+        seval::expr::compiled_expression c;
+        size_t f = static_cast<size_t>(i * 7 + seed) % 6;
+        assert(cache->get(formulas[f], c));
+        double x = static_cast<double>(i);
+        seval::expr::value v;
+        assert(c.run(&x, v) && c.text() == formulas[f]);
+    }
+}
+#endif
+
+void seval_test_cache() {
+    seval::expr::bindings vars;
+    vars["x"] = 3.0;
+
+    /* Hits, misses and LRU eviction */
+    {
+        seval::expr::expression_cache cache(2, 1);
+        seval::expr::compiled_expression a, b, c;
+        seval::expr::value v;
+        assert(cache.get("x + 1", a) && cache.get("x * 2", b));
+        assert(cache.get("x + 1", c) && &c.bytecode() == &a.bytecode());
+        assert(cache.get("x - 1", c));                 /* evicts "x * 2" */
+        assert(cache.get("x + 1", c));
+        seval::expr::cache_stats stats = cache.stats();
+        assert(stats.hits == 2 && stats.misses == 3 && stats.evictions == 1 && stats.size == 2);
+
+        assert(b.run(vars, v) && floatpoint_compare(v.f, 6.0)); /* evicted entries stay usable */
+        assert(cache.get("x * 2", b) && cache.stats().misses == 4);
+
+        seval::expr::error err;
+        assert(!cache.get("x +", c, &err) && cache.stats().size == 2);
+        cache.clear();
+        assert(cache.stats().size == 0 && a.run(vars, v) && floatpoint_compare(v.f, 4.0));
+    }
+    /* Native entries, handles outliving the cache */
+    {
+        seval::expr::compiled_expression kept;
+        {
+            seval::expr::expression_cache cache(16, 4, true);
+            assert(cache.get(std::string("pow(x, 2) - 1"), kept));
+            assert(kept.native().scalar() == seval::expr::jit_available());
+        }
+        seval::expr::value v;
+        assert(kept.valid() && kept.run(vars, v) && floatpoint_compare(v.f, 8.0));
+    }
+#if __cplusplus >= 201103L
+    /* Concurrent lookups */
+    {
+        seval::expr::expression_cache cache(4, 2);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) threads.push_back(std::thread(seval_test_cache_worker, &cache, t));
+        for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+        seval::expr::cache_stats stats = cache.stats();
+        assert(stats.hits + stats.misses == 8000 && stats.size <= 4);
+    }
+#endif
+}
+
+void seval_test_schema() {
+    std::vector<std::string> names;
+    for (int i = 0; i < 60; ++i) names.push_back("v" + std::string(1, static_cast<char>('a' + i % 26)) + std::string(1, static_cast<char>('0' + i / 26)));
+    seval::expr::schema vars(names);
+
+    /* Every name has its own slot; other names miss */
+    assert(vars.size() == 60);
+    for (size_t i = 0; i < names.size(); ++i) assert(vars.find(names[i]) == i);
+    assert(vars.find("va9") == seval::expr::schema::npos && vars.find("") == seval::expr::schema::npos);
+    assert(vars.find("va0", 2) == seval::expr::schema::npos);
+
+    std::vector<std::string> duplicates(names);
+    duplicates.push_back("vb1");
+    seval::expr::schema broken;
+    assert(!broken.build(duplicates) && broken.size() == 0 && broken.find("vb1") == seval::expr::schema::npos);
+
+    /* Compiled programs index rows directly */
+    std::vector<double> row(names.size());
+    for (size_t i = 0; i < row.size(); ++i) row[i] = static_cast<double>(i);
+    seval::expr::program p;
+    seval::expr::value v;
+    assert(seval::expr::compile("vz1 * 2 + vc0 - vh2", vars, p));
+    assert(p.slots.size() == 3 && p.slots[0] == 51);
+    assert(seval::expr::run(p, &row[0], v) && floatpoint_compare(v.f, 51.0 * 2 + 2 - 59));
+
+    seval::expr::tiered_program hot(p, 0);
+    assert(hot.run(&row[0], v) && floatpoint_compare(v.f, 45.0));
+    seval::expr::bindings named;
+    named["vz1"] = 1.0;
+    named["vc0"] = 2.0;
+    named["vh2"] = 3.0;
+    assert(hot.run(named, v) && floatpoint_compare(v.f, 1.0));
+
+    seval::expr::error err;
+    assert(!seval::expr::compile("vz1 + price", vars, p, &err) && err.position == 6);
+    assert(p.code.empty() && p.slots.empty() && !seval::expr::run(p, &row[0], v)); /* nothing left to run on the wrong layout */
+
+    /* Recompiling without the schema drops the slot map: rows are then in variable order */
+    assert(seval::expr::compile("vz1 * 2 + vc0 - vh2", vars, p));
+    assert(seval::expr::compile("x + 1", p) && p.slots.empty());
+    double single = 4.0;
+    assert(seval::expr::run(p, &single, v) && floatpoint_compare(v.f, 5.0));
+    seval::expr::tiered_program cold(p, 0);
+    assert(cold.run(&single, v) && floatpoint_compare(v.f, 5.0));
+}
+
+void seval_test_overflow() {
+    const int64_t max = 9223372036854775807LL, min = -max - 1;
+    seval::expr::bindings vars;
+    vars["x"] = 0.5;
+    seval::expr::value v;
+    seval::expr::error err;
+
+    /* Wrap (the default), saturate and trap on the AST */
+    assert(seval::expr::evaluate("9223372036854775807 + 1", vars, v) && v.i == min);
+    assert(seval::expr::evaluate("9223372036854775807 + 1", vars, v, NULL, seval::expr::OVERFLOW_SATURATE) && v.i == max);
+    assert(!seval::expr::evaluate("9223372036854775807 + 1", vars, v, &err, seval::expr::OVERFLOW_TRAP));
+    assert(err.position == 20 && std::string(err.message) == "integer overflow");
+
+    const seval::expr::overflow_mode saturate = seval::expr::OVERFLOW_SATURATE, trap = seval::expr::OVERFLOW_TRAP;
+    assert(seval::expr::evaluate("-9223372036854775807 - 2", vars, v, NULL, saturate) && v.i == min);
+    assert(seval::expr::evaluate("4611686018427387904 * -3", vars, v, NULL, saturate) && v.i == min);
+    assert(seval::expr::evaluate("4611686018427387904 * 2 - 1", vars, v, NULL, saturate) && v.i == max - 1);
+    assert(seval::expr::evaluate("(-9223372036854775807 - 1) / -1", vars, v, NULL, saturate) && v.i == max);
+    assert(seval::expr::evaluate("abs(-9223372036854775807 - 1)", vars, v, NULL, saturate) && v.i == max);
+    assert(seval::expr::evaluate("pow(3, 40)", vars, v, NULL, saturate) && v.i == max);
+    assert(seval::expr::evaluate("pow(-2, 65)", vars, v, NULL, saturate) && v.i == min);
+    assert(seval::expr::evaluate("pow(-2, 63)", vars, v, NULL, trap) && v.i == min);     /* exact, no overflow */
+    assert(seval::expr::evaluate("pow(2, 63)", vars, v) && v.i == min);
+    assert(!seval::expr::evaluate("x + 9223372036854775807 * 2", vars, v, &err, trap) && err.position == 24);
+    assert(!seval::expr::evaluate("9223372036854775807 % 0", vars, v, &err, trap) && std::string(err.message) == "integer division by zero");
+
+    /* Compiled programs keep their mode: folding never hides a trap, and the VM reports it */
+    seval::expr::program p;
+    assert(seval::expr::compile("-(-9223372036854775807 - 1) + x", p, NULL, trap));
+    assert(!seval::expr::run(p, vars, v, &err) && err.position == 0 && std::string(err.message) == "integer overflow");
+    assert(seval::expr::compile("-(-9223372036854775807 - 1) + x", p, NULL, saturate));
+    assert(seval::expr::run(p, vars, v) && floatpoint_compare(v.f, 9223372036854775807.0));
+    seval::expr::tiered_program hot(p, 0);
+    assert(hot.run(vars, v) && floatpoint_compare(v.f, 9223372036854775807.0));
+
+    /* Columns of integer data: trapped overflow fails the batch; saturation stays branch-free */
+    const size_t rows = 2500;
+    std::vector<int64_t> q(rows), out(rows);
+    for (size_t i = 0; i < rows; ++i) q[i] = static_cast<int64_t>(i) - 1000;
+    q[1500] = max;
+    q[2400] = min;
+    seval::expr::column_bindings columns;
+    columns["q"] = seval::expr::column_ref(&q[0]);
+
+    assert(seval::expr::compile("q + 1 - 2", columns, p, NULL, trap) && p.resultKind == seval::expr::KIND_INT);
+    assert(!seval::expr::run_columns(p, columns, rows, &out[0], &err) && err.position == 2 && std::string(err.message) == "integer overflow");
+    assert(seval::expr::compile("q + 1 - 2", columns, p, NULL, saturate));
+    assert(seval::expr::run_columns(p, columns, rows, &out[0]));
+    assert(out[0] == -1001 && out[1500] == max - 2 && out[2400] == min);
+    assert(seval::expr::compile("q + 1 - 2", columns, p));
+    assert(seval::expr::run_columns(p, columns, rows, &out[0]) && out[1500] == max - 1 && out[2400] == max);
+    assert(seval::expr::compile("q * 3 + abs(q)", columns, p, NULL, saturate));
+    assert(seval::expr::run_columns(p, columns, rows, &out[0]) && out[1500] == max && out[2400] == min + max && out[999] == -2);
+    assert(seval::expr::compile("abs(q)", columns, p, NULL, trap));
+    assert(!seval::expr::run_columns(p, columns, rows, &out[0], &err) && err.position == 0);
+
+    /* The column loops agree with the VM row by row */
+    assert(seval::expr::compile("q * 3 - q / 7 + q % 5", columns, p, NULL, saturate));
+    assert(seval::expr::run_columns(p, columns, rows, &out[0]));
+    for (size_t i = 0; i < rows; i += 37) {
+        seval::expr::bindings row;
+        row["q"] = static_cast<double>(q[i]);
+        if (i == 1500 || i == 2400) continue; /* not exact as doubles */
+        assert(seval::expr::run(p, row, v) && v.i == out[i]);
+    }
+
+    /* Caches compile every entry with their mode */
+    seval::expr::expression_cache cache(16, 1, false, saturate);
+    seval::expr::compiled_expression c;
+    assert(cache.get("x * 0 + 9223372036854775807 * 9223372036854775807", c) && c.run(vars, v) && floatpoint_compare(v.f, 9223372036854775807.0));
+}
+
+void seval_test_parallel() {
+    const char* formulas[] = { "x + 1", "x * y - 3", "pow(x, 2) / (y + 1)", "max(x, y) % 7", "x +", "x / (1 - 1) + 7 % (2 - 2)" };
+    const size_t count = sizeof(formulas) / sizeof(formulas[0]);
+
+    std::vector<seval::expr::bindings> events(50);
+    for (size_t e = 0; e < events.size(); ++e) {
+        events[e]["x"] = static_cast<double>(e) * 0.5;
+        events[e]["y"] = static_cast<double>(e % 7) - 3.0;
+    }
+
+    /* Every formula against every event, interleaved so equal texts are far apart */
+    std::vector<seval::expr::evaluation_task> tasks;
+    for (size_t e = 0; e < events.size(); ++e) {
+        for (size_t f = 0; f < count; ++f) tasks.push_back(seval::expr::evaluation_task(formulas[(f + e) % count], &events[e]));
+    }
+    tasks.push_back(seval::expr::evaluation_task("x + 1", NULL));
+
+    seval::expr::expression_cache cache(64, 4, true);
+    seval::expr::evaluation_pool pool(cache, 3, 16);
+    std::vector<seval::expr::evaluation_result> results;
+    for (int round = 0; round < 3; ++round) {
+        assert(!pool.evaluate(tasks, results) && results.size() == tasks.size());
+        for (size_t k = 0; k < tasks.size(); ++k) {
+            seval::expr::value expected;
+            seval::expr::error err;
+            static const seval::expr::bindings none;
+            bool ok = seval::expr::evaluate(tasks[k].text.c_str(), tasks[k].vars ? *tasks[k].vars : none, expected, &err);
+            assert(results[k].ok == ok);
+            if (ok) {
+                double a = results[k].result.as_float(), b = expected.as_float();
+                assert(results[k].result.kind == expected.kind);
+                assert(a == b || (a != a && b != b) || floatpoint_compare(a, b)); /* inf and NaN rows included */
+            } else {
+                assert(std::string(results[k].err.message) == err.message && results[k].err.position == err.position);
+            }
+        }
+    }
+    assert(cache.stats().size == count - 1);
+
+    /* All-good batches report success; empty batches are fine */
+    std::vector<seval::expr::evaluation_task> good(tasks.begin(), tasks.begin() + 1);
+    assert(pool.evaluate(good, results) && results.size() == 1 && results[0].ok);
+    assert(pool.evaluate(std::vector<seval::expr::evaluation_task>(), results) && results.empty());
+
+    /* A pool without workers gives the same results on the calling thread */
+    seval::expr::evaluation_pool inline_pool(cache, 0);
+    assert(inline_pool.threads() == 0 && inline_pool.evaluate(good, results) && results[0].ok);
+}
+
+void seval_test_stats() {
+    using seval::stats::snapshot;
+    assert(seval::stats::enabled());
+    assert(std::string(seval::stats::describe(seval::stats::FIELD_ERROR_TRAILING).kernel) == "evaluate_field");
+    assert(std::string(seval::stats::describe(seval::stats::DICTIONARY_DISABLES).path) == "disable");
+
+    /* Each literal form and each rejection reason lands on its own counter */
+    snapshot before = seval::stats::collect();
+    double v = seval::evaluate<double, const char*>("-1.5e3");
+    assert(v == -1500.0);
+    int n = seval::evaluate_n<int, const char*>("0x1F", 4);
+    assert(n == 31);
+    assert(seval::evaluate_field<int>("0b101", 5, n) && n == 5);
+    assert(!seval::evaluate_field<double>("", 0, v));
+    assert(!seval::evaluate_field<double>("-", 1, v));
+    assert(!seval::evaluate_field<double>("12a", 3, v));
+    assert(!seval::evaluate_field<double>("1e+", 3, v));
+    snapshot d = seval::stats::collect().since(before);
+
+    assert(d[seval::stats::EVALUATE_CALLS] == 1 && d[seval::stats::EVALUATE_BYTES] == 6);
+    assert(d[seval::stats::EVALUATE_SIGN] == 1 && d[seval::stats::EVALUATE_DECIMAL] == 1);
+    assert(d[seval::stats::EVALUATE_FRACTION] == 1 && d[seval::stats::EVALUATE_EXPONENT] == 1);
+    assert(d[seval::stats::EVALUATE_N_CALLS] == 1 && d[seval::stats::EVALUATE_N_HEXADECIMAL] == 1 && d[seval::stats::EVALUATE_N_BYTES] == 4);
+    assert(d[seval::stats::FIELD_CALLS] == 5 && d[seval::stats::FIELD_BYTES] == 12 && d[seval::stats::FIELD_BINARY] == 1);
+    assert(d[seval::stats::FIELD_ERROR_EMPTY] == 1 && d[seval::stats::FIELD_ERROR_DIGITS] == 1);
+    assert(d[seval::stats::FIELD_ERROR_TRAILING] == 1 && d[seval::stats::FIELD_ERROR_EXPONENT] == 1);
+
+    /* Batch helpers: SIMD and scalar bytes add up, dictionary lookups are split by outcome */
+    const char column[] = "1\n2\n1\n2\n1\n2\n1\n2\n1\n2\n12345678901234567\n";
+    before = seval::stats::collect();
+    seval::batch::field_index index;
+    seval::batch::index_fields(column, sizeof(column) - 1, '\n', index);
+    std::vector<double> values;
+    seval::batch::parse_column_dictionary<double>(column, sizeof(column) - 1, '\n', values);
+    d = seval::stats::collect().since(before);
+    assert(d[seval::stats::INDEX_CALLS] == 1 && d[seval::stats::INDEX_BYTES] == sizeof(column) - 1);
+    assert(d[seval::stats::INDEX_SIMD_BYTES] + d[seval::stats::INDEX_SCALAR_BYTES] == sizeof(column) - 1);
+    assert(d[seval::stats::DICTIONARY_MISSES] == 2 && d[seval::stats::DICTIONARY_HITS] == 8 && d[seval::stats::DICTIONARY_BYPASSES] == 1);
+    assert(d[seval::stats::DICTIONARY_LOOKUPS] == 11);
+
+    /* Batch kernels count one call per invocation and the fields it parsed separately */
+    before = seval::stats::collect();
+    std::vector<int> ints;
+    seval::batch::parse_column_bucketed<int>(column, sizeof(column) - 1, '\n', ints);
+    seval::batch::parse_column_page_safe<int>(column, sizeof(column) - 1, '\n', ints);
+    d = seval::stats::collect().since(before);
+    assert(d[seval::stats::BUCKETED_CALLS] == 1 && d[seval::stats::BUCKETED_FIELDS] == 11);
+    assert(d[seval::stats::PAGE_SAFE_CALLS] == 1 && d[seval::stats::PAGE_SAFE_FIELDS] == 11);
+    const char* strings[] = { "7", "-12", "x" };
+    const size_t stringLengths[] = { 1, 3, 1 };
+    int gathered[3];
+    before = seval::stats::collect();
+    seval::parse_gather<int>(strings, stringLengths, 3, gathered);
+    d = seval::stats::collect().since(before);
+    assert(d[seval::stats::GATHER_CALLS] == 1 && d[seval::stats::GATHER_STRINGS] == 3);
+    assert(d[seval::stats::GATHER_PLAIN] == 2 && d[seval::stats::GATHER_FALLBACK] == 1);
+
+    /* Prometheus rendering: one line per counter, shares against the kernel's calls or bytes */
+    snapshot fixed;
+    fixed.values[seval::stats::FIELD_CALLS] = 4;
+    fixed.values[seval::stats::FIELD_HEXADECIMAL] = 1;
+    fixed.values[seval::stats::FIELD_ERROR_TRAILING] = 3;
+    fixed.values[seval::stats::BUCKETED_CALLS] = 2;
+    fixed.values[seval::stats::BUCKETED_FIELDS] = 8;
+    fixed.values[seval::stats::BUCKETED_PLAIN] = 6;
+    char text[8192];
+    size_t length = seval::stats::render_prometheus(fixed, text, sizeof(text));
+    std::string rendered(text);
+    assert(length == rendered.size() && length < sizeof(text));
+    assert(rendered.find("# TYPE seval_calls_total counter\nseval_calls_total{kernel=\"evaluate\"} 0\n") != std::string::npos);
+    assert(rendered.find("seval_calls_total{kernel=\"evaluate_field\"} 4\n") != std::string::npos);
+    assert(rendered.find("seval_path_total{kernel=\"evaluate_field\",path=\"hexadecimal\"} 1\n") != std::string::npos);
+    assert(rendered.find("seval_path_ratio{kernel=\"evaluate_field\",path=\"hexadecimal\"} 0.25\n") != std::string::npos);
+    assert(rendered.find("seval_errors_total{kernel=\"evaluate_field\",kind=\"trailing\"} 3\n") != std::string::npos);
+    assert(rendered.find("seval_calls_total{kernel=\"bucketed\"} 2\n") != std::string::npos);
+    assert(rendered.find("seval_fields_total{kernel=\"bucketed\"} 8\n") != std::string::npos);
+    assert(rendered.find("seval_path_ratio{kernel=\"bucketed\",path=\"bucket\"} 0.75\n") != std::string::npos);
+    assert(rendered.find("seval_stats_enabled 1\n") != std::string::npos);
+
+    /* A short buffer gets a NUL-terminated prefix and the full length back */
+    char small[16];
+    assert(seval::stats::render_prometheus(fixed, small, sizeof(small)) == length);
+    assert(strlen(small) == sizeof(small) - 1 && rendered.compare(0, sizeof(small) - 1, small) == 0);
+    assert(seval::stats::render_prometheus(fixed, NULL, 0) == length);
+
+    /* Shares keep six fraction digits and a '.' whatever LC_NUMERIC says */
+    const char* commaLocales[] = { "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8" };
+    for (size_t i = 0; i < sizeof(commaLocales) / sizeof(commaLocales[0]); ++i) {
+        if (setlocale(LC_NUMERIC, commaLocales[i])) break;
+    }
+    fixed.values[seval::stats::BUCKETED_FIELDS] = 3;
+    fixed.values[seval::stats::BUCKETED_PLAIN] = 2;
+    fixed.values[seval::stats::BUCKETED_FALLBACK] = 3;
+    seval::stats::render_prometheus(fixed, text, sizeof(text));
+    setlocale(LC_NUMERIC, "C");
+    rendered = text;
+    assert(rendered.find("seval_path_ratio{kernel=\"bucketed\",path=\"bucket\"} 0.666667\n") != std::string::npos);
+    assert(rendered.find("seval_path_ratio{kernel=\"bucketed\",path=\"fallback\"} 1\n") != std::string::npos);
+    assert(rendered.find("seval_path_ratio{kernel=\"evaluate\",path=\"sign\"} 0\n") != std::string::npos);
+
+#if __cplusplus >= 201103L
+    /* Counts of other threads, including exited ones, are part of the totals */
+    before = seval::stats::collect();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.push_back(std::thread([] {
+            for (int k = 0; k < 1000; ++k) (void)seval::evaluate<int, const char*>("42");
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); ++t) workers[t].join();
+    d = seval::stats::collect().since(before);
+    assert(d[seval::stats::EVALUATE_CALLS] == 4000 && d[seval::stats::EVALUATE_BYTES] == 8000);
+#endif
+}
+
+/* reads one value of a trace dump */
+template <typename V>
+V seval_test_trace_read(FILE* f) {
+    V v;
+    assert(fread(&v, sizeof(V), 1, f) == 1);
+    return v;
+}
+
+void seval_test_trace() {
+    assert(std::string(seval::trace::kernel_name(seval::trace::KERNEL_PARSE_COLUMN_ZONES)) == "parse_column_zones");
+
+    /* Every call appends one event to the calling thread's ring */
+    uint64_t before = seval::trace::local_count();
+    std::vector<double> values;
+    seval::batch::parse_column<double>("1\n2\n", 4, '\n', values);
+    assert(seval::trace::local_count() - before == 3); /* the column and its two fields */
+
+#if __cplusplus >= 201103L
+    /* A thread that wraps its ring around; its ring outlives it in the dump */
+    std::thread([] {
+        for (int k = 0; k < 5000; ++k) (void)seval::evaluate<int, const char*>("12345");
+    }).join();
+#endif
+
+    double v = 0;
+    assert(seval::evaluate_field<double>("1.5", 3, v));
+
+    const char* path = "seval_test_trace.bin";
+    assert(seval::trace::dump(path));
+    FILE* f = fopen(path, "rb");
+    assert(f);
+    char magic[8];
+    assert(fread(magic, 1, 8, f) == 8 && memcmp(magic, "SEVALTRC", 8) == 0);
+    assert(seval_test_trace_read<uint32_t>(f) == 1);
+    assert(seval_test_trace_read<uint32_t>(f) == sizeof(seval::trace::trace_event));
+    (void)seval_test_trace_read<uint32_t>(f);
+    uint32_t rings = seval_test_trace_read<uint32_t>(f);
+
+    bool sawCaller = false, sawWrapped = false;
+    for (uint32_t r = 0; r < rings; ++r) {
+        (void)seval_test_trace_read<uint32_t>(f);
+        uint32_t live = seval_test_trace_read<uint32_t>(f);
+        uint64_t written = seval_test_trace_read<uint64_t>(f);
+        uint64_t kept = seval_test_trace_read<uint64_t>(f);
+        assert(kept <= written && kept <= SEVAL_TRACE_CAPACITY);
+
+        std::vector<seval::trace::trace_event> events(static_cast<size_t>(kept));
+        assert(kept == 0 || fread(&events[0], sizeof(seval::trace::trace_event), events.size(), f) == events.size());
+        if (kept == 0) continue;
+
+        const seval::trace::trace_event& last = events.back();
+        if (live && last.kernel == seval::trace::KERNEL_EVALUATE_FIELD && last.length == 3) sawCaller = true;
+        if (!live && kept == SEVAL_TRACE_CAPACITY && last.kernel == seval::trace::KERNEL_EVALUATE && last.length == 5) sawWrapped = true;
+    }
+    fclose(f);
+    remove(path);
+
+    assert(sawCaller);
+#if __cplusplus >= 201103L
+    assert(sawWrapped);
+#else
+    (void)sawWrapped;
+#endif
+}
+
+#if defined(SEVAL_STATIC_FORMULA)
+/* runtime evaluation of `text`, for comparison with the compile-time formula */
+double seval_test_static_reference(const char* text, double a, double b) {
+    seval::expr::bindings vars;
+    vars["a"] = a;
+    vars["b"] = b;
+    seval::expr::value v;
+    assert(seval::expr::evaluate(text, vars, v));
+    return v.as_float();
+}
+
+void seval_test_static() {
+    using seval::expr::formula;
+
+    /* Literal-only formulas are constant expressions with the runtime typing rules */
+    static_assert(formula<"(1 + 2) * 0x10">::eval() == 48);
+    static_assert(formula<"7 / 2 + 0b11 % 2">::eval() == 4);
+    static_assert(formula<"pow(2, 10) - max(3, -4)">::eval() == 1021);
+    static_assert(formula<"1.5e1 - 0b101 / 2">::eval() == 13.0);
+    static_assert(formula<"abs(-2.5) + -(-1)">::eval() == 3.5);
+    static_assert(std::is_same<formula<"9223372036854775807 + 1">::result_type, int64_t>::value);
+    static_assert(formula<"9223372036854775807 + 1">::eval() == INT64_MIN);
+    static_assert(std::is_same<formula<"4 / 2.0">::result_type, double>::value);
+    static_assert(formula<"a * 2 + 0x10">::eval(1.0) == 18.0);
+
+    /* Variables are numbered in order of first appearance */
+    typedef formula<"b * a + b"> ordered;
+    assert(ordered::variable_count == 2 && ordered::variable(0) == "b" && ordered::variable(1) == "a");
+    const double row[] = { 3.0, 4.0 };
+    assert(ordered::run(row) == 15.0);
+
+    /* Same results as the interpreter, including library calls and mixed integer/double folding */
+    double xs[] = { -3.5, 0.0, 2.0, 16.0, 1e10 };
+    for (size_t k = 0; k < sizeof(xs) / sizeof(xs[0]); ++k) {
+        double a = xs[k], b = xs[(k + 2) % 5];
+        assert(formula<"a * 2 + 0x10">::eval(a) == seval_test_static_reference("a * 2 + 0x10", a, b));
+        assert(formula<"sqrt(abs(a)) + pow(b, 2) % 7 - min(a, -b)">::eval(a, b) == seval_test_static_reference("sqrt(abs(a)) + pow(b, 2) % 7 - min(a, -b)", a, b));
+        assert(formula<"(a - b) / (3 * 0.5) + max(a, 1e2) - -a">::eval(a, b) == seval_test_static_reference("(a - b) / (3 * 0.5) + max(a, 1e2) - -a", a, b));
+    }
+
+    /* Invalid texts report what parse or evaluate would */
+    seval::expr::expression e;
+    seval::expr::error err;
+    assert(!formula<"1 +">::valid && !seval::expr::parse("1 +", e, &err));
+    assert(strcmp(formula<"1 +">::message, err.message) == 0 && formula<"1 +">::position == err.position);
+    assert(!formula<"0x + a">::valid && !seval::expr::parse("0x + a", e, &err));
+    assert(strcmp(formula<"0x + a">::message, err.message) == 0 && formula<"0x + a">::position == err.position);
+    assert(!formula<"cos(a)">::valid && formula<"cos(a)">::position == 0);
+    assert(!formula<"sqr(a) + maxi(a, 1)">::valid && !seval::expr::parse("sqr(a) + maxi(a, 1)", e, &err));
+    assert(strcmp(formula<"sqr(a) + maxi(a, 1)">::message, err.message) == 0 && formula<"sqr(a) + maxi(a, 1)">::position == err.position);
+    static_assert(formula<"max (1, 2) + abs (-3)">::eval() == 5);
+    assert(!formula<"a + 7 % (3 - 3)">::valid && strcmp(formula<"a + 7 % (3 - 3)">::message, "integer division by zero") == 0);
+    assert(formula<"a + 7 % (3 - 3)">::position == 6);
+    typedef formula<"a + 18446744073709551617"> wide;
+    assert(!wide::valid && !seval::expr::parse("a + 18446744073709551617", e, &err));
+    assert(strcmp(wide::message, err.message) == 0 && wide::position == err.position && wide::position == 4);
+    static_assert(formula<"-9223372036854775808", seval::expr::OVERFLOW_TRAP>::eval() == INT64_MIN);
+    static_assert(!formula<"9223372036854775808">::valid);
+
+    /* Overflow modes apply to folding */
+    static_assert(formula<"9223372036854775807 + 1", seval::expr::OVERFLOW_SATURATE>::eval() == INT64_MAX);
+    typedef formula<"a + 9223372036854775807 * 2", seval::expr::OVERFLOW_TRAP> trapped;
+    assert(!trapped::valid && strcmp(trapped::message, "integer overflow") == 0 && trapped::position == 24);
+}
+#endif
+
 int main() {
     seval_test();
     seval_test_n();
+    seval_test_field();
+    seval_test_batch();
+    seval_test_zones();
+    seval_test_kernels();
+    seval_test_adaptive();
+    seval_test_trim();
+    seval_test_bucketed();
+    seval_test_interleaved();
+    seval_test_gather();
+    seval_test_padded();
+    seval_test_arrow();
+    seval_test_lazy();
+    seval_test_file();
+    seval_test_expr();
+    seval_test_optimize();
+    seval_test_vm();
+    seval_test_columns();
+    seval_test_jit();
+    seval_test_cache();
+    seval_test_schema();
+    seval_test_overflow();
+    seval_test_parallel();
+    seval_test_stats();
+    seval_test_trace();
+#if defined(SEVAL_STATIC_FORMULA)
+    seval_test_static();
+#endif
     std::cout << "All tests passed!" << std::endl;
     return 0;
 }
\ No newline at end of file